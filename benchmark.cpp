@@ -0,0 +1,377 @@
+/*
+	Benchmark of the different attribute paths of this library.
+
+	Every scenario writes the same coloured lines through every path:
+
+		raw		the attribute calls as they were before the console state was cached:
+				'GetStdHandle', 'GetConsoleScreenBufferInfo' and 'SetConsoleTextAttribute' for every change (windows only)
+		cached	'std::cout' with the win32 backend of the cached 'ConsoleState' (windows only)
+		batched	the 'ConsoleWriter'
+		vt		'std::cout' with the virtual terminal backend, for redirected output with 'RedirectPolicy::vt'
+				(skipped on consoles that do not support it)
+		screen	the 'BasicScreen' (only for the redraw scenario)
+
+	The win32 paths have to flush 'std::cout' before every attribute change to keep the colours correct.
+
+	The library is instrumented with 'OMEGA_COLOR_CONSOLE_STATS' to count the kernel calls per line.
+	'std::cout' writes through a stream buffer of 4096 bytes that uses the instrumented 'ConsoleState::write()',
+	so that the kernel calls of the streams are counted as well.
+
+	The latencies are measured for every unit of a scenario, that is a line or a frame of 25 lines for the redraw,
+	the 'unit' column of the report tells which. The throughput and the kernel calls are reported per line.
+
+	Run it once for each target, the report is written to the standard error:
+
+		benchmark				the real console
+		benchmark file			a redirected file ('bench_output.txt')
+		benchmark nul			the null device
+
+	Options:
+
+		--lines <n>				number of lines per scenario and path (default 20000)
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_STATS
+	#define OMEGA_COLOR_CONSOLE_STATS
+#endif
+#include "include/colour_console.h"
+#include "include/colour_console_screen.h"
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <streambuf>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <fcntl.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+using namespace cc;
+
+namespace{
+
+using Clock = std::chrono::steady_clock;
+
+enum class Scenario{plain, change_per_line, change_per_word, nested_spans, redraw};
+
+constexpr Scenario scenarios[] = {Scenario::plain, Scenario::change_per_line, Scenario::change_per_word, Scenario::nested_spans, Scenario::redraw};
+
+const char* name(Scenario scenario){
+	switch(scenario){
+		case Scenario::plain: return "plain text";
+		case Scenario::change_per_line: return "change per line";
+		case Scenario::change_per_word: return "change per word";
+		case Scenario::nested_spans: return "nested spans";
+		case Scenario::redraw: return "full screen redraw";
+	}
+	return "";
+}
+
+constexpr std::size_t screen_width = 80;
+constexpr std::size_t screen_height = 25;
+
+constexpr ConsoleTextAttrChange word_colours[] = {Text::red, Text::green, Text::yellow, Text::blue, Text::purple, Text::aqua, Text::white, Text::light_red};
+
+/**
+	Writes one unit of the scenario into the sink: a line, or a whole frame for the redraw scenario
+*/
+template<class Sink>
+void emit(Sink& out, Scenario scenario, std::size_t i){
+	switch(scenario){
+		case Scenario::plain:
+			out << "plain text line number " << static_cast<unsigned int>(i) << " without any colour\n";
+			break;
+		case Scenario::change_per_line:
+			out << ((i & 1) ? Text::light_green : Text::light_red) << "one colour change per line number " << static_cast<unsigned int>(i) << '\n';
+			break;
+		case Scenario::change_per_word:
+			for(const ConsoleTextAttrChange colour : word_colours) out << colour << "word ";
+			out << Text::white << static_cast<unsigned int>(i) << '\n';
+			break;
+		case Scenario::nested_spans:
+			out << "In this text we composed " << Dye::green(Mark::red("a dye and a mark")) << " and " << Underline(Dye::yellow("an underline")) << '\n';
+			break;
+		case Scenario::redraw:
+			for(std::size_t y = 0; y < screen_height; ++y){
+				for(std::size_t x = 0; x < screen_width; x += 8){
+					out << word_colours[(x / 8 + y + i) % 8] << "cell " << static_cast<unsigned int>((i + y) % 100) << ' ';
+				}
+				out << Text::white << '\n';
+			}
+			break;
+	}
+}
+
+#ifdef _WIN32
+/**RawWin32
+	The attribute calls as they were before the console state was cached
+*/
+struct RawWin32{
+	std::ostream& stream;
+
+	static HANDLE handle(){
+		return kernel_call(KernelCall::get_std_handle, []{return GetStdHandle(STD_OUTPUT_HANDLE);});
+	}
+
+	static ConsoleTextAttr get(){
+		CONSOLE_SCREEN_BUFFER_INFO i;
+		kernel_call(KernelCall::get_screen_buffer_info, [&]{return GetConsoleScreenBufferInfo(handle(), &i);});
+		return ConsoleTextAttr{i.wAttributes};
+	}
+
+	static void set(ConsoleTextAttr attributes){
+		kernel_call(KernelCall::set_text_attribute, [&]{return SetConsoleTextAttribute(handle(), static_cast<WORD>(attributes.value));});
+	}
+
+	RawWin32& operator << (ConsoleTextAttr attributes){
+		this->stream.flush();
+		set(attributes);
+		return *this;
+	}
+
+	RawWin32& operator << (ConsoleTextAttrChange change){
+		this->stream.flush();
+		set(apply_change(get(), change));
+		return *this;
+	}
+
+	template<class Payload>
+	RawWin32& operator << (const BasicConsoleTextAttrChangePrint<Payload>& print){
+		const ConsoleTextAttr previous = get();
+		return *this << print.attributes << print.string << previous;
+	}
+
+	template<class T>
+	RawWin32& operator << (const T& value){
+		this->stream << value;
+		return *this;
+	}
+};
+
+/**CachedWin32
+	'std::cout' with the win32 backend, which needs a flush before every attribute change
+*/
+struct CachedWin32{
+	std::ostream& stream;
+
+	CachedWin32& operator << (ConsoleTextAttr attributes){
+		this->stream << std::flush << attributes;
+		return *this;
+	}
+
+	CachedWin32& operator << (ConsoleTextAttrChange change){
+		this->stream << std::flush << change;
+		return *this;
+	}
+
+	template<class Payload>
+	CachedWin32& operator << (const BasicConsoleTextAttrChangePrint<Payload>& print){
+		const ConsoleTextAttr previous = get_text_attributes();
+		return *this << print.attributes << print.string << previous;
+	}
+
+	template<class T>
+	CachedWin32& operator << (const T& value){
+		this->stream << value;
+		return *this;
+	}
+};
+#endif
+
+}//namespace
+
+#ifdef _WIN32
+// the adapters handle the attributes themselves instead of the stream operators of the library
+namespace cc{
+template<> struct is_attribute_sink<RawWin32> : std::true_type{};
+template<> struct is_attribute_sink<CachedWin32> : std::true_type{};
+}//namespace cc
+#endif
+
+namespace{
+
+/**StatsBuffer
+	The stream buffer of 'std::cout', it writes through the instrumented console state
+*/
+class StatsBuffer : public std::streambuf{
+public:
+	StatsBuffer(){this->setp(this->buffer_, this->buffer_ + sizeof(this->buffer_));}
+
+protected:
+	int_type overflow(int_type c) override {
+		this->sync();
+		if(!traits_type::eq_int_type(c, traits_type::eof())){
+			*this->pptr() = traits_type::to_char_type(c);
+			this->pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	int sync() override {
+		const std::size_t size = static_cast<std::size_t>(this->pptr() - this->pbase());
+		if(size != 0) console_state().write(std::string_view(this->pbase(), size));
+		this->setp(this->buffer_, this->buffer_ + sizeof(this->buffer_));
+		return 0;
+	}
+
+private:
+	char buffer_[4096];
+};
+
+/**Result
+	The measurement of one scenario on one path
+*/
+struct Result{
+	std::string path;
+	Scenario scenario;
+	double units_per_second;
+	double p50_ns;
+	double p99_ns;
+	double kernel_calls_per_unit;
+};
+
+double percentile(std::vector<double>& samples, double fraction){
+	const std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(samples.size())));
+	std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+	return samples[index];
+}
+
+/**
+	Runs 'write(i)' for every unit and measures each call, 'finish()' is measured together with the last unit
+*/
+template<class Write, class Finish>
+Result measure(const char* path, Scenario scenario, std::size_t units, Write&& write, Finish&& finish){
+	std::vector<double> samples(units);
+	const std::uint64_t calls_before = stats().kernel_calls();
+	const Clock::time_point begin = Clock::now();
+	for(std::size_t i = 0; i < units; ++i){
+		const Clock::time_point start = Clock::now();
+		write(i);
+		if(i + 1 == units) finish();
+		samples[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+	const std::uint64_t calls = stats().kernel_calls() - calls_before;
+
+	Result result{path, scenario, static_cast<double>(units) / seconds, 0, 0, static_cast<double>(calls) / static_cast<double>(units)};
+	result.p50_ns = percentile(samples, 0.50);
+	result.p99_ns = percentile(samples, 0.99);
+	return result;
+}
+
+/**
+	Redirects the standard output, so that all paths write to the target
+*/
+bool redirect_stdout(const char* path){
+	std::fflush(stdout);
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) return false;
+	const int fd = _open_osfhandle(reinterpret_cast<intptr_t>(file), _O_WRONLY | _O_BINARY);
+	if(fd < 0 || _dup2(fd, 1) != 0) return false;
+	SetStdHandle(STD_OUTPUT_HANDLE, file);
+#else
+	const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0 || dup2(fd, STDOUT_FILENO) < 0) return false;
+	close(fd);
+#endif
+	return true;
+}
+
+}//namespace
+
+int main(int argc, char** argv){
+	const char* target = "console";
+	std::size_t lines = 20000;
+	for(int i = 1; i < argc; ++i){
+		const std::string_view argument = argv[i];
+		if(argument == "--lines" && i + 1 < argc){
+			lines = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+		}else{
+			target = argv[i];
+		}
+	}
+
+	const std::string_view target_name = target;
+	if(target_name == "file"){
+		if(!redirect_stdout("bench_output.txt")) return 1;
+	}else if(target_name == "nul"){
+#ifdef _WIN32
+		if(!redirect_stdout("NUL")) return 1;
+#else
+		if(!redirect_stdout("/dev/null")) return 1;
+#endif
+	}else if(target_name != "console"){
+		std::cerr << "unknown target '" << target << "', use 'console', 'file' or 'nul'\n";
+		return 1;
+	}
+
+	StatsBuffer stats_buffer;
+	std::streambuf* const original_buffer = std::cout.rdbuf(&stats_buffer);
+
+	ConsoleState& console = console_state();
+	const Backend detected = console.backend();
+	std::vector<Result> results;
+
+	for(const Scenario scenario : scenarios){
+		// a frame of the redraw scenario is 25 lines
+		const std::size_t units = (scenario == Scenario::redraw) ? std::max<std::size_t>(1, lines / screen_height) : lines;
+
+#ifdef _WIN32
+		console.set_backend(Backend::win32);
+		console.sync();
+		{
+			RawWin32 out{std::cout};
+			results.push_back(measure("raw", scenario, units, [&](std::size_t i){emit(out, scenario, i);}, []{std::cout.flush();}));
+		}
+		{
+			CachedWin32 out{std::cout};
+			results.push_back(measure("cached", scenario, units, [&](std::size_t i){emit(out, scenario, i);}, []{std::cout.flush();}));
+		}
+#endif
+		{
+			console.set_backend(detected);
+			console.sync();
+			ConsoleWriter out;
+			results.push_back(measure("batched", scenario, units, [&](std::size_t i){emit(out, scenario, i);}, [&]{out.flush();}));
+		}
+		if(!console.is_console() || detected == Backend::vt){
+			// redirected output gets the escape sequences through the redirect policy, like in production
+			console.set_redirect_policy(RedirectPolicy::vt);
+			results.push_back(measure("vt", scenario, units, [&](std::size_t i){emit(std::cout, scenario, i);}, []{std::cout.flush();}));
+			console.set_redirect_policy(RedirectPolicy::strip);
+		}
+		if(scenario == Scenario::redraw){
+			static BasicScreen<screen_width, screen_height> screen;
+			results.push_back(measure("screen", scenario, units, [&](std::size_t i){
+				auto cursor = screen.cursor(0, 0);
+				emit(cursor, scenario, i);
+				screen.present();
+			}, []{}));
+		}
+	}
+	std::cout << Preset::Default << std::flush;
+	std::cout.rdbuf(original_buffer);
+
+	std::fprintf(stderr, "\ntarget: %s, %zu lines per scenario (frames of %zu lines for the redraw)\n\n", target, lines, screen_height);
+	std::fprintf(stderr, "%-20s %-8s %14s %14s %6s %16s %16s\n", "scenario", "path", "lines/s", "syscalls/line", "unit", "p50 [ns/unit]", "p99 [ns/unit]");
+	for(const Result& result : results){
+		const bool frames = (result.scenario == Scenario::redraw);
+		const double lines_per_unit = frames ? static_cast<double>(screen_height) : 1.0;
+		std::fprintf(stderr, "%-20s %-8s %14.0f %14.3f %6s %16.0f %16.0f\n", name(result.scenario), result.path.c_str(), 
+			result.units_per_second * lines_per_unit, result.kernel_calls_per_unit / lines_per_unit, frames ? "frame" : "line", result.p50_ns, result.p99_ns);
+	}
+
+	const ConsoleStats totals = stats();
+	std::fprintf(stderr, "\n%" PRIu64 " kernel calls, %" PRIu64 " bytes written, %" PRIu64 " elided changes\n", totals.kernel_calls(), totals.bytes_written, totals.elided_changes);
+	return 0;
+}
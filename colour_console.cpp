@@ -0,0 +1,17 @@
+/*
+	The calls of the operating system of 'colour_console.h', compiled once.
+	
+	Add this file to the project and define 'OMEGA_COLOR_CONSOLE_COMPILED_BACKEND' for all files of it,
+	then the headers of the library declare the calls of 'cc::platform' instead of defining them
+	and only this file includes '<windows.h>' for the plain console output.
+*/
+
+#define OMEGA_COLOR_CONSOLE_BACKEND_SOURCE
+
+#include "include/colour_console.h"
+
+#ifdef _WIN32
+	#include "include/colour_console_win32.h"
+#else
+	#include "include/colour_console_posix.h"
+#endif
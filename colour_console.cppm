@@ -0,0 +1,93 @@
+/*
+	The headers of this library as the C++20 module 'cc'.
+	
+		import cc;
+		
+		int main(){
+			cc::ConsoleWriter out;
+			out << cc::Text::red << "error: " << cc::Preset::Default << "something went wrong\n";
+		}
+	
+	The standard and the system headers are included in the global module fragment,
+	so '<windows.h>' and its macros do not leak into the files that import the module.
+	The headers of the library are included after 'export module cc;' with 'OMEGA_COLOR_CONSOLE_EXPORT' defined as 'export',
+	which exports the namespace 'cc' with everything in it, the stream operators of the attributes included.
+	'OMEGA_COLOR_CONSOLE_MODULE_INLINE' is defined empty, so the functions with static variables and the key functions
+	of the classes with virtual functions are compiled once into the object of the module instead of being inline.
+	
+	GCC 12 miscompiles the declarations of the standard library that a file which imports the module shares with it,
+	so with GCC 12 the files that import 'cc' must not include or import any standard header themselves.
+	They can use the sinks like 'cc::ConsoleWriter', but not 'std::cout', see 'module_example.cpp'.
+	
+	Compile it as the module interface of the project, for example:
+		
+		g++ -std=c++20 -fmodules-ts -x c++ -c colour_console.cppm
+		cl /std:c++20 /interface /c colour_console.cppm
+		clang++ -std=c++20 --precompile colour_console.cppm -o cc.pcm
+	
+	Macros defined for the whole project, like 'OMEGA_COLOR_CONSOLE_STATS', apply to the module as well.
+*/
+
+module;
+
+//std
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cinttypes>
+#include <cerrno>
+#include <charconv>
+#include <algorithm>
+#include <type_traits>
+#include <iterator>
+#include <utility>
+#include <streambuf>
+#include <ostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+	//windows
+	#include <windows.h>
+	#include <WinCon.h>
+	#include <intrin.h>
+#else
+	//posix
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <sys/uio.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+#endif
+
+export module cc;
+
+#define OMEGA_COLOR_CONSOLE_EXPORT export
+#define OMEGA_COLOR_CONSOLE_MODULE_INLINE
+
+#include "include/colour_console.h"
+#include "include/colour_console_extended.h"
+#include "include/colour_console_quantise.h"
+#include "include/colour_console_streambuf.h"
+#include "include/colour_console_logger.h"
+#include "include/colour_console_markup.h"
+#include "include/colour_console_theme.h"
+#include "include/colour_console_render.h"
+#include "include/colour_console_bulk.h"
+#include "include/colour_console_archive.h"
+#include "include/colour_console_screen.h"
+#include "include/colour_console_region.h"
+#include "include/colour_console_live.h"
+#include "include/colour_console_scrollback.h"
+#include "include/colour_console_table.h"
+#include "include/colour_console_parser.h"
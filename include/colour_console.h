@@ -42,6 +42,23 @@
 	calling the windows system calls directly. Thus this is a header only library and 
 	everything is marked as 'inline' and 'constexpr'
 	
+	The console handle and the current attributes are cached in a process wide 'ConsoleState',
+	so the console is only called when the attributes actually change.
+	Call 'sync_text_attributes()' if the attributes have been changed outside of this library.
+	
+	On windows consoles that support 'ENABLE_VIRTUAL_TERMINAL_PROCESSING' and on all other platforms
+	the attributes are written as virtual terminal (ANSI) escape sequences directly into the output stream,
+	so no additional system calls are needed and the colours stay in order with the buffered text.
+	Otherwise the attributes are set with 'SetConsoleTextAttribute'. 
+	The backend is picked once at startup.
+	
+	If the standard output is not a console but a file or a pipe, the attributes are dropped by default,
+	so redirected output does not pay for failing console calls. 
+	Call 'set_redirect_policy(RedirectPolicy::vt)' to write escape sequences into redirected output instead.
+	
+	Define 'OMEGA_COLOR_CONSOLE_STATS' before including this header to count and time every kernel call
+	of this library, the numbers are returned by 'cc::stats()'. Without it the hooks compile to the plain calls.
+	
 	Usage
 	-----
 	
@@ -51,6 +68,10 @@
 	
 	Compile with C++17
 	
+	The platform independent types are in 'colour_console_core.h', the calls of the operating system
+	in 'colour_console_win32.h' and 'colour_console_posix.h'. Define 'OMEGA_COLOR_CONSOLE_COMPILED_BACKEND'
+	and add 'colour_console.cpp' to the project to compile those once, or import the module 'cc' of 'colour_console.cppm'.
+	
 	Examples
 	--------
 	
@@ -61,320 +82,1285 @@
 #ifndef OMEGA_COLOR_CONSOLE_H
 #define OMEGA_COLOR_CONSOLE_H
 
-//windows
-#include <windows.h>
-#include <WinCon.h>
+#include "colour_console_core.h"
 
 //std
-#include <string_view>
 #include <cinttypes>
+#include <streambuf>
+#include <ostream>
+#include <utility>
+#include <atomic>
+#include <mutex>
+
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+	#include <chrono>
+#endif
+
+/**
+	The calls of the operating system are inline functions of the backend headers, which are included at the end of this header.
+	Define 'OMEGA_COLOR_CONSOLE_COMPILED_BACKEND' for the whole project and add 'colour_console.cpp' to it
+	to compile them once instead, then '<windows.h>' is only included by that file.
+*/
+#ifdef OMEGA_COLOR_CONSOLE_COMPILED_BACKEND
+	#define OMEGA_COLOR_CONSOLE_BACKEND_API
+#else
+	#define OMEGA_COLOR_CONSOLE_BACKEND_API inline
+#endif
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/** Backend
+	How the attributes are brought to the console
+*/
+enum class Backend{
+	win32,	///< the attributes are set on the console with 'SetConsoleTextAttribute'
+	vt,		///< the attributes are written as virtual terminal (ANSI) escape sequences into the output
+	none	///< the attributes are only tracked and never written, used for redirected output
+};
+
+/** RedirectPolicy
+	What happens to the attributes if the standard output is not a console but a file or a pipe
+*/
+enum class RedirectPolicy{
+	strip,	///< the attributes are dropped, only the text is written
+	vt		///< the attributes are written as virtual terminal (ANSI) escape sequences into the byte stream
+};
+
+#ifdef _WIN32
+	using ConsoleHandle = void*;	///< the 'HANDLE' of windows
+#else
+	using ConsoleHandle = int;
+#endif
+
+/** platform
+	The calls of the operating system that are needed to write to the console.
+	They are defined in 'colour_console_win32.h' and 'colour_console_posix.h'.
+*/
+namespace platform{
+	
+	/// returns the handle of the standard output
+	OMEGA_COLOR_CONSOLE_BACKEND_API ConsoleHandle standard_output();
+	
+	/// returns true if the handle refers to a console or terminal and not to a file or a pipe
+	OMEGA_COLOR_CONSOLE_BACKEND_API bool is_console(ConsoleHandle handle);
+	
+	/// returns the backend that is supported by the console behind the handle, this may enable the virtual terminal processing
+	OMEGA_COLOR_CONSOLE_BACKEND_API Backend console_backend(ConsoleHandle handle);
+	
+	/// reads the current attributes of the console, returns false if the console cannot be queried
+	OMEGA_COLOR_CONSOLE_BACKEND_API bool read_attributes(ConsoleHandle handle, ConsoleTextAttr& attributes);
+	
+	/// sets the attributes of the console with the windows console API, has no effect on all other platforms
+	OMEGA_COLOR_CONSOLE_BACKEND_API void set_attributes(ConsoleHandle handle, ConsoleTextAttr attributes);
+	
+	/// writes all bytes to the handle
+	OMEGA_COLOR_CONSOLE_BACKEND_API void write(ConsoleHandle handle, std::string_view bytes);
+	
+	/// writes UTF-16 text to a windows console, returns false if it is not one
+	OMEGA_COLOR_CONSOLE_BACKEND_API bool write_utf16(ConsoleHandle handle, const wchar_t* text, std::size_t size);
+	
+}//namespace platform
+
+/** KernelCall
+	The kernel calls of this library that are counted by the instrumentation
+*/
+enum class KernelCall{
+	get_std_handle,
+	get_console_mode,
+	set_console_mode,
+	get_screen_buffer_info,
+	set_text_attribute,
+	write_file,					///< 'WriteFile' on windows and 'write' on all other platforms
+	write_console,
+	write_console_output,
+	get_file_type,				///< 'GetFileType' on windows and 'isatty' on all other platforms
+	create_screen_buffer,
+	set_active_screen_buffer,
+	fill_output_character,
+	fill_output_attribute,
+	read_console_output,
+	set_cursor_position,
+	count						///< the number of kernel calls and not a call itself
+};
+
+inline constexpr std::size_t kernel_call_count = static_cast<std::size_t>(KernelCall::count);
+
+/** KernelCallStats
+	How often a kernel call has been made and how long it took
+*/
+struct KernelCallStats{
+	std::uint64_t count = 0;
+	std::uint64_t total_ns = 0;
+	std::uint64_t max_ns = 0;
+};
+
+/** ConsoleStats
+	A snapshot of the instrumentation of the console layer
+*/
+struct ConsoleStats{
+	KernelCallStats calls[kernel_call_count] = {};
+	std::uint64_t bytes_written = 0;	///< the bytes that have been handed to the write calls
+	std::uint64_t elided_changes = 0;	///< the attribute writes that have been skipped because they would not have changed anything
+	
+	constexpr const KernelCallStats& operator[](KernelCall call) const {return this->calls[static_cast<std::size_t>(call)];}
+	
+	/// returns the number of all kernel calls
+	constexpr std::uint64_t kernel_calls() const {
+		std::uint64_t result = 0;
+		for(const KernelCallStats& call : this->calls) result += call.count;
+		return result;
+	}
+};
+
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+	inline constexpr bool stats_enabled = true;
+#else
+	inline constexpr bool stats_enabled = false;
+#endif
+
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+/**StatsRecorder
+	The process wide counters of the instrumentation, they may be updated from any thread
+*/
+class StatsRecorder{
+public:
+	void record(KernelCall call, std::uint64_t ns){
+		Counters& counters = this->calls_[static_cast<std::size_t>(call)];
+		counters.count.fetch_add(1, std::memory_order_relaxed);
+		counters.total_ns.fetch_add(ns, std::memory_order_relaxed);
+		std::uint64_t max = counters.max_ns.load(std::memory_order_relaxed);
+		while(ns > max && !counters.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)){}
+	}
+	
+	void count_bytes(std::uint64_t bytes){this->bytes_written_.fetch_add(bytes, std::memory_order_relaxed);}
+	
+	void snapshot(ConsoleStats& stats) const {
+		for(std::size_t i = 0; i < kernel_call_count; ++i){
+			stats.calls[i].count = this->calls_[i].count.load(std::memory_order_relaxed);
+			stats.calls[i].total_ns = this->calls_[i].total_ns.load(std::memory_order_relaxed);
+			stats.calls[i].max_ns = this->calls_[i].max_ns.load(std::memory_order_relaxed);
+		}
+		stats.bytes_written = this->bytes_written_.load(std::memory_order_relaxed);
+	}
+	
+	void reset(){
+		for(Counters& counters : this->calls_){
+			counters.count.store(0, std::memory_order_relaxed);
+			counters.total_ns.store(0, std::memory_order_relaxed);
+			counters.max_ns.store(0, std::memory_order_relaxed);
+		}
+		this->bytes_written_.store(0, std::memory_order_relaxed);
+	}
+	
+private:
+	struct Counters{
+		std::atomic<std::uint64_t> count{0};
+		std::atomic<std::uint64_t> total_ns{0};
+		std::atomic<std::uint64_t> max_ns{0};
+	};
+	
+	Counters calls_[kernel_call_count];
+	std::atomic<std::uint64_t> bytes_written_{0};
+};
+
+OMEGA_COLOR_CONSOLE_MODULE_INLINE StatsRecorder& stats_recorder(){
+	static StatsRecorder recorder;
+	return recorder;
+}
+
+/// records the duration of a kernel call on destruction, so that it also works for calls without a result
+class KernelCallTimer{
+public:
+	explicit KernelCallTimer(KernelCall call) : call_(call), begin_(std::chrono::steady_clock::now()){}
+	KernelCallTimer(const KernelCallTimer&) = delete;
+	KernelCallTimer& operator = (const KernelCallTimer&) = delete;
+	~KernelCallTimer(){
+		const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->begin_);
+		stats_recorder().record(this->call_, static_cast<std::uint64_t>(duration.count()));
+	}
+private:
+	KernelCall call_;
+	std::chrono::steady_clock::time_point begin_;
+};
+#endif
+
+/**
+	Makes the kernel call 'f()' and returns its result. 
+	With 'OMEGA_COLOR_CONSOLE_STATS' the call is counted and timed, otherwise this is just the call.
+*/
+template<class Call>
+inline decltype(auto) kernel_call([[maybe_unused]] KernelCall call, Call&& f){
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+	const KernelCallTimer timer(call);
+#endif
+	return f();
+}
+
+/**
+	Counts the bytes that are handed to a write call, does nothing without 'OMEGA_COLOR_CONSOLE_STATS'
+*/
+inline void count_written_bytes([[maybe_unused]] std::size_t bytes){
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+	stats_recorder().count_bytes(bytes);
+#endif
+}
+
 
-namespace cc{
+/**ConsoleState
+	Caches the handle of the standard output and keeps a shadow copy of the current console attributes.
 	
-/**ConsoleTextAttr
-	Used to set specific attributes, all other attributes will be reset when printed.
+	All changes are applied to the shadow copy in memory and the console is only called
+	if the resulting attributes actually differ from the current ones.
+	The shadow copy is only read back from the console on request by calling 'sync()',
+	for example after some other code has changed the console attributes directly.
+	
+	The backend is picked once on construction: 
+	On windows the virtual terminal backend is used if the console supports 'ENABLE_VIRTUAL_TERMINAL_PROCESSING',
+	otherwise the win32 backend is used. On all other platforms the virtual terminal backend is used.
+	If the handle is not a console but a file or a pipe, the redirect policy picks the backend instead.
+	By default the attributes are then dropped, and the console is never queried.
 */
-struct ConsoleTextAttr{
-	unsigned int value = 0;
+class ConsoleState{
+public:
+	ConsoleState() 
+		: ConsoleState(platform::standard_output()){}
+	
+	/**
+		Creates the state of another handle, for example of the standard error
+	*/
+	explicit ConsoleState(ConsoleHandle handle)
+		: handle_(handle)
+	{
+		this->is_console_ = detect_console(this->handle_);
+		this->backend_ = this->is_console_ ? detect_backend(this->handle_) : redirect_backend(this->redirect_policy_);
+		this->sync();
+	}
+	
+	/**
+		Returns true if the handle refers to a console or terminal and not to a file or a pipe
+	*/
+	static bool detect_console(ConsoleHandle handle){
+		return platform::is_console(handle);
+	}
+	
+	/**
+		Returns the backend for redirected output
+	*/
+	static constexpr Backend redirect_backend(RedirectPolicy policy){
+		return (policy == RedirectPolicy::vt) ? Backend::vt : Backend::none;
+	}
+	
+	/**
+		Returns the backend that is supported by the console behind the handle.
+		On windows this tries to enable the virtual terminal processing of the console.
+	*/
+	static Backend detect_backend(ConsoleHandle handle){
+		return platform::console_backend(handle);
+	}
+	
+	/**
+		Re-reads the current attributes from the console into the shadow copy.
+		Terminals without the windows console API cannot be queried, there the shadow copy is kept.
+	*/
+	void sync(){
+		if(!this->is_console_) return;
+		ConsoleTextAttr attributes;
+		if(platform::read_attributes(this->handle_, attributes)) this->attributes_ = attributes.value;
+	}
+	
+	/**
+		Returns the cached handle of the standard output
+	*/
+	ConsoleHandle handle() const {return this->handle_;}
+	
+	/**
+		Returns the backend that is used to bring the attributes to the console
+	*/
+	Backend backend() const {return this->backend_;}
+	
+	/**
+		Overrides the backend that has been picked on construction
+	*/
+	void set_backend(Backend backend){this->backend_ = backend;}
+	
+	/**
+		Returns true if the handle refers to a console or terminal and not to a file or a pipe
+	*/
+	bool is_console() const {return this->is_console_;}
+	
+	RedirectPolicy redirect_policy() const {return this->redirect_policy_;}
+	
+	/**
+		Sets what happens to the attributes if the handle is not a console, 
+		this does not change anything if the handle is a console
+	*/
+	void set_redirect_policy(RedirectPolicy policy){
+		this->redirect_policy_ = policy;
+		if(!this->is_console_) this->backend_ = redirect_backend(policy);
+	}
+	
+	/**
+		Returns the shadow copy of the current attributes without calling the console
+	*/
+	ConsoleTextAttr attributes() const {return ConsoleTextAttr{this->attributes_};}
+	
+	/**
+		Updates the shadow copy without calling the console.
+		Used by sinks that bring the attributes to the console themselves.
+	*/
+	void track(ConsoleTextAttr attributes){
+		this->attributes_ = attributes.value;
+		this->known_ = true;
+	}
+	
+	/**
+		Marks the shadow copy as not matching the console, so that the next attributes are written even if they are equal.
+		Used after attributes have been written that the shadow copy cannot represent, like 24-bit colours.
+	*/
+	void invalidate(){this->known_ = false;}
+	
+	/**
+		Returns false if the shadow copy does not match the console since the last 'invalidate()'
+	*/
+	bool is_known() const {return this->known_;}
+	
+	/**
+		Sets the attributes, the console is only called if they differ from the current ones.
+		With the virtual terminal backend the escape sequence is written directly to the console.
+	*/
+	void set(ConsoleTextAttr attributes){
+		if(this->elide(attributes)) return;
+		this->attributes_ = attributes.value;
+		this->known_ = true;
+		if(this->backend_ == Backend::vt){
+			this->write(vt::sgr(attributes).view());
+		}else if(this->backend_ == Backend::win32){
+			this->set_console(attributes);
+		}
+	}
+	
+	/**
+		Sets the attributes, with the virtual terminal backend the escape sequence is written into the stream
+	*/
+	template<class OStream>
+	void set(OStream& stream, ConsoleTextAttr attributes){
+		if(this->backend_ != Backend::vt) return this->set(attributes);
+		if(this->elide(attributes)) return;
+		this->attributes_ = attributes.value;
+		this->known_ = true;
+		stream << vt::sgr(attributes).view();
+	}
+	
+	/**
+		Applies the change to the shadow copy and then sets the result.
+		Changes that do not change the effective attributes are no-ops.
+	*/
+	void change(ConsoleTextAttrChange change){
+		const ConsoleTextAttr resolved = apply_change(this->attributes(), change);
+		if(this->backend_ != Backend::vt) return this->set(resolved);
+		if(this->elide(resolved)) return;
+		this->attributes_ = resolved.value;
+		this->write(change_sgr(change, resolved).view());
+	}
+	
+	/**
+		Applies the change, with the virtual terminal backend the escape sequence is written into the stream.
+		Changes that do not change the effective attributes are no-ops.
+	*/
+	template<class OStream>
+	void change(OStream& stream, ConsoleTextAttrChange change){
+		const ConsoleTextAttr resolved = apply_change(this->attributes(), change);
+		if(this->backend_ != Backend::vt) return this->set(resolved);
+		if(this->elide(resolved)) return;
+		this->attributes_ = resolved.value;
+		stream << change_sgr(change, resolved).view();
+	}
+	
+	/**
+		Remembers the current attributes on the attribute stack and then applies the change
+	*/
+	void push(ConsoleTextAttrChange change){
+		this->stack_.push(this->attributes());
+		this->change(change);
+	}
+	
+	/**
+		Remembers the current attributes on the attribute stack and then applies the change,
+		with the virtual terminal backend the escape sequence is written into the stream
+	*/
+	template<class OStream>
+	void push(OStream& stream, ConsoleTextAttrChange change){
+		this->stack_.push(this->attributes());
+		this->change(stream, change);
+	}
+	
+	/**
+		Remembers the current attributes on the attribute stack and then sets the attributes like 'set(stream, attributes)',
+		but writes 'sgr' with the virtual terminal backend, which has to be the full escape sequence of the attributes,
+		e.g. one that has been computed in advance
+	*/
+	template<class OStream>
+	void push(OStream& stream, ConsoleTextAttr attributes, const vt::Sgr& sgr){
+		this->stack_.push(this->attributes());
+		if(this->backend_ != Backend::vt) return this->set(attributes);
+		if(this->elide(attributes)) return;
+		this->attributes_ = attributes.value;
+		this->known_ = true;
+		stream << sgr.view();
+	}
+	
+	/**
+		Restores the attributes that have been remembered by the matching 'push()'
+	*/
+	void pop(){
+		ConsoleTextAttr restored;
+		if(this->stack_.pop(restored)) this->set(restored);
+	}
+	
+	/**
+		Restores the attributes that have been remembered by the matching 'push()',
+		with the virtual terminal backend the escape sequence is written into the stream
+	*/
+	template<class OStream>
+	void pop(OStream& stream){
+		ConsoleTextAttr restored;
+		if(this->stack_.pop(restored)) this->set(stream, restored);
+	}
+	
+	/**Pending
+		Attribute operations on a stream that have been applied to the shadow copy but not yet brought to the console,
+		see 'StreamAttrChain'
+	*/
+	struct Pending{
+		ConsoleTextAttr from;			///< the attributes of the console before the first operation
+		ConsoleTextAttrChange change;	///< the first operation, if it is the only one and a change
+		unsigned int count = 0;		///< the number of operations
+		bool single_change = false;
+		bool known = true;			///< 'is_known()' before the first operation
+	};
+
+	/**
+		Sets the attributes of the shadow copy, the console is only updated by 'flush(stream, pending)'
+	*/
+	void defer(Pending& pending, ConsoleTextAttr attributes){
+		this->begin(pending);
+		pending.single_change = false;
+		this->attributes_ = attributes.value;
+	}
+
+	/**
+		Applies the change to the shadow copy, the console is only updated by 'flush(stream, pending)'
+	*/
+	void defer(Pending& pending, ConsoleTextAttrChange change){
+		pending.single_change = (pending.count == 0);
+		pending.change = change;
+		this->begin(pending);
+		this->attributes_ = apply_change(this->attributes(), change).value;
+	}
+
+	/**
+		Remembers the current attributes on the attribute stack and applies the change to the shadow copy
+	*/
+	void defer_push(Pending& pending, ConsoleTextAttrChange change){
+		this->stack_.push(this->attributes());
+		this->defer(pending, change);
+	}
+
+	/**
+		Restores the attributes that have been remembered by the matching push in the shadow copy
+	*/
+	void defer_pop(Pending& pending){
+		ConsoleTextAttr restored;
+		if(this->stack_.pop(restored)) this->defer(pending, restored);
+	}
+
+	/**
+		Brings the deferred operations to the console with at most one escape sequence or attribute call.
+		With the virtual terminal backend the escape sequence is written into the stream.
+		Operations that cancel each other write nothing.
+	*/
+	template<class OStream>
+	void flush(OStream& stream, Pending& pending){
+		if(pending.count == 0) return;
+		const ConsoleTextAttr resolved = this->attributes();
+		const unsigned int count = pending.count;
+		pending.count = 0;
+		if(pending.known && resolved.value == pending.from.value){
+			this->elided_ += count;
+			return;
+		}
+		this->elided_ += count - 1;
+		if(this->backend_ == Backend::vt){
+			if(pending.single_change){
+				// a single change keeps the precomputed sequences of the constants
+				stream << change_sgr(pending.change, resolved).view();
+				return;
+			}
+			const vt::Sgr sgr = pending.known ? vt::sgr(resolved, vt::difference_mask(pending.from, resolved)) : vt::sgr(resolved);
+			stream << sgr.view();
+		}else if(this->backend_ == Backend::win32){
+			this->set_console(resolved);
+		}
+		this->known_ = true;
+	}
+
+	/**
+		Returns how many attribute writes have been skipped because they would not have changed the effective attributes
+	*/
+	std::uint64_t elided_changes() const {return this->elided_;}
+	
+	/**
+		Adds attribute writes that have been skipped by a sink that brings the attributes to the console itself
+	*/
+	void count_elided(std::uint64_t count){this->elided_ += count;}
+	
+	/**
+		Writes the bytes directly to the console, bypassing any stream buffer
+	*/
+	void write(std::string_view bytes){
+		count_written_bytes(bytes.size());
+		platform::write(this->handle_, bytes);
+	}
+	
+	/**
+		Writes UTF-8 text directly to the console, bypassing any stream buffer.
+		On windows the text is converted to UTF-16 in chunks and written with 'WriteConsoleW',
+		so it does not depend on the output code page of the console.
+	*/
+	void write_text(std::string_view text){
+#ifdef _WIN32
+		// files and pipes get the UTF-8 bytes
+		if(!this->is_console_) return this->write(text);
+		wchar_t wide[1024];
+		while(!text.empty()){
+			std::size_t size = std::min<std::size_t>(text.size(), 1024);
+			if(size < text.size()){
+				while(size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) --size;
+				if(size == 0) size = 1;
+			}
+			const std::size_t wide_size = utf8::to_utf16(text.substr(0, size), wide);
+			if(platform::write_utf16(this->handle_, wide, wide_size)){
+				count_written_bytes(wide_size * sizeof(wchar_t));
+			}else{
+				this->write(text.substr(0, size));
+			}
+			text.remove_prefix(size);
+		}
+#else
+		this->write(text);
+#endif
+	}
+	
+private:
+	/// returns the escape sequence of the change
+	static vt::Sgr change_sgr(ConsoleTextAttrChange change, ConsoleTextAttr resolved){
+		// field aligned changes (all constants) do not depend on the current state and fold to precomputed sequences
+		return vt::is_field_aligned(change) ? vt::sgr(change) : vt::sgr(resolved, change.mask);
+	}
+	
+	/// remembers the attributes of the console before the first deferred operation
+	void begin(Pending& pending){
+		if(pending.count++ != 0) return;
+		pending.from = this->attributes();
+		pending.known = this->known_;
+	}
+
+	/// returns true and counts the write if it would not change the effective attributes
+	bool elide(ConsoleTextAttr attributes){
+		// after 'invalidate()' only a complete set makes the shadow copy match the console again
+		if(attributes.value != this->attributes_ || !this->known_) return false;
+		++this->elided_;
+		return true;
+	}
+	
+	void set_console(ConsoleTextAttr attributes){
+		platform::set_attributes(this->handle_, attributes);
+	}
+	
+	ConsoleHandle handle_;
+	bool is_console_;
+	RedirectPolicy redirect_policy_ = RedirectPolicy::strip;
+	Backend backend_;
+	unsigned int attributes_ = Attribute::foreground_red | Attribute::foreground_green | Attribute::foreground_blue;
+	bool known_ = true;
+	std::uint64_t elided_ = 0;
+	TextAttrStack stack_;
 };
 
-inline constexpr ConsoleTextAttr operator | (ConsoleTextAttr lhs, ConsoleTextAttr rhs){
-	return ConsoleTextAttr{lhs.value | rhs.value};
+/**
+	Returns the process wide console state of the standard output
+*/
+OMEGA_COLOR_CONSOLE_MODULE_INLINE ConsoleState& console_state(){
+	static ConsoleState state;
+	return state;
 }
 
 /**
 	Apply the given colour and text format settings
 */
 inline void set_text_attributes(ConsoleTextAttr attributes){
-	SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), attributes.value);
+	console_state().set(attributes);
 }
 
 /**
-	Get the current console colour and fromat settings
+	Get the current console colour and fromat settings.
+	This returns the shadow copy and does not call the console, use 'sync_text_attributes()' to re-read them.
 */
 inline ConsoleTextAttr get_text_attributes(){
-	CONSOLE_SCREEN_BUFFER_INFO i;
-	GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &i);
-	ConsoleTextAttr attributes;
-	attributes.value = i.wAttributes;
-	return attributes;
+	return console_state().attributes();
 }
 
-
 /**
-	Set the colour and text format within the stream
+	Returns how many attribute writes have been skipped because they would not have changed the effective attributes
 */
-template<class OStream>
-OStream& operator << (OStream& stream, ConsoleTextAttr attr){
-	set_text_attributes(attr);
-	return stream;
+inline std::uint64_t elided_text_attribute_changes(){
+	return console_state().elided_changes();
 }
 
-/**ConsoleTextAttrChange
-	Used to change a specific set of attributes, all other attributes will reman as they were before.
+/**
+	Re-reads the current console colour and format settings, 
+	use this if the console attributes have been changed outside of this library
 */
-struct ConsoleTextAttrChange{
-	unsigned int value = 0;
-	unsigned int mask = 0;
-};
+inline void sync_text_attributes(){
+	console_state().sync();
+}
 
-inline constexpr ConsoleTextAttrChange operator | (ConsoleTextAttrChange lhs, ConsoleTextAttrChange rhs){
-	return ConsoleTextAttrChange{lhs.value | rhs.value, lhs.mask | rhs.mask};
+/**
+	Sets what happens to the attributes if the standard output is not a console but a file or a pipe.
+	By default they are dropped, with 'RedirectPolicy::vt' they are written as escape sequences.
+*/
+inline void set_redirect_policy(RedirectPolicy policy){
+	console_state().set_redirect_policy(policy);
 }
 
 /**
-	change only the settings that are set in the mask and keep everything else
+	Returns a snapshot of the instrumentation. 
+	The kernel calls and written bytes are only counted with 'OMEGA_COLOR_CONSOLE_STATS' and are zero otherwise,
+	the elided changes are always counted.
 */
-inline void change_text_attributes(ConsoleTextAttrChange attr){
-	auto attributes = get_text_attributes();
-	attributes.value &= ~attr.mask;
-	attributes.value |= attr.value & attr.mask;
-	set_text_attributes(attributes);	
+inline ConsoleStats stats(){
+	ConsoleStats result;
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+	stats_recorder().snapshot(result);
+#endif
+	result.elided_changes = console_state().elided_changes();
+	return result;
 }
 
 /**
-	Change the colour and text format within the stream
+	Resets the counters of the kernel calls and written bytes
 */
-template<class OStream>
-OStream& operator << (OStream& stream, ConsoleTextAttrChange attr){
-	change_text_attributes(attr);
-	return stream;
+inline void reset_stats(){
+#ifdef OMEGA_COLOR_CONSOLE_STATS
+	stats_recorder().reset();
+#endif
 }
 
 
-/**ConsoleTextAttrPrint
-	Used to print a specific text in a specific style and then restores the previous text attributes.
+/**AttrState
+	The interface of everything that keeps the logical attributes of a stream itself,
+	so that the stream operators resolve changes against them instead of the process wide console state.
 */
-struct ConsoleTextAttrChangePrint{
-	ConsoleTextAttrChange attributes;
-	std::string_view string;
+class AttrState{
+public:
+	/**
+		Returns the attributes of the characters that are written next
+	*/
+	virtual ConsoleTextAttr attributes() const = 0;
+	
+	/**
+		Changes the attributes of the characters that are written next
+	*/
+	virtual void set_attributes(ConsoleTextAttr attributes) = 0;
+	
+	void change(ConsoleTextAttrChange change){
+		this->set_attributes(apply_change(this->attributes(), change));
+	}
+	
+	/**
+		Remembers the attributes on the attribute stack and applies the change.
+		States whose attributes are kept per thread override 'push()' and 'pop()' with a stack per thread.
+	*/
+	virtual void push(ConsoleTextAttrChange change){
+		this->stack_.push(this->attributes());
+		this->change(change);
+	}
+	
+	/**
+		Restores the attributes of the matching 'push()'
+	*/
+	virtual void pop(){
+		ConsoleTextAttr restored;
+		if(this->stack_.pop(restored)) this->set_attributes(restored);
+	}
+	
+protected:
+	~AttrState() = default;
+	
+private:
+	TextAttrStack stack_;
 };
 
-/**
-	prints the string in 'attr' with the applied attributes for the text and then changes the text back to its previous font.
+class AttrStreambuf;
+class StreamAttrState;
+
+/**AttrStateRegistry
+	Lists the 'StreamAttrState' and 'AttrStreambuf' objects that exist, the most recently created ones first.
+	As long as there are none, the stream operators only load the count and use the process wide console state.
 */
-template<class OStream>
-OStream& operator << (OStream& stream, ConsoleTextAttrChangePrint attr){
-	auto attributes = get_text_attributes();
-	stream << attr.attributes << attr.string << attributes;
-	return stream;
-}
+struct AttrStateRegistry{
+	std::mutex mutex;
+	AttrStreambuf* buffers = nullptr;
+	StreamAttrState* states = nullptr;
+	std::atomic<std::size_t> count{0};
+	std::atomic<long> generation{0};	///< changes whenever one of them is created or destroyed
+};
 
-/** TextColour
-	This is used to change the foreground colour of the text.
-	Just write it in the output stream and the colour of the text will change.
-	
-	std::cout << TextColour::red << "Everything after this is in red" << std::endl;
-*/	
-
-namespace Text{	
-	inline constexpr unsigned int mask = FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN;
-	inline constexpr ConsoleTextAttrChange black{0, mask};
-	inline constexpr ConsoleTextAttrChange blue{FOREGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange green{FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange aqua{FOREGROUND_BLUE | FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange red{FOREGROUND_RED, mask};
-	inline constexpr ConsoleTextAttrChange purple{FOREGROUND_RED | FOREGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange yellow{FOREGROUND_RED | FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange white{FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange grey{FOREGROUND_INTENSITY, mask};
-	inline constexpr ConsoleTextAttrChange light_blue{FOREGROUND_INTENSITY | FOREGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange light_green{FOREGROUND_INTENSITY | FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange light_aqua{FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange light_red{FOREGROUND_INTENSITY | FOREGROUND_RED, mask};
-	inline constexpr ConsoleTextAttrChange light_purple{FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange light_yellow{FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange bright_white{FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN, mask};
+OMEGA_COLOR_CONSOLE_MODULE_INLINE AttrStateRegistry& attr_state_registry(){
+	static AttrStateRegistry registry;
+	return registry;
 }
 
-/**
-	TextSetColour elements will when printed override all attributes, whereas TextColour elements will change the text colour and leafe all other attributes as is.
-	So for example when printed:
-	
-	std::cout << TextSetColour::red << "Text" << std::endl;
-	
-	The text will be red, the background will be set to black and all bars will be set to off. 
-	However you may compose different 'set' elements
-	
-	Since the default is black there is also no black text that can be set
-*/
-namespace TextSet{
-	inline constexpr ConsoleTextAttr blue{FOREGROUND_BLUE};
-	inline constexpr ConsoleTextAttr green{FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr aqua{FOREGROUND_BLUE | FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr red{FOREGROUND_RED};
-	inline constexpr ConsoleTextAttr purple{FOREGROUND_RED | FOREGROUND_BLUE};
-	inline constexpr ConsoleTextAttr yellow{FOREGROUND_RED | FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr white{FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr grey{FOREGROUND_INTENSITY};
-	inline constexpr ConsoleTextAttr light_blue{FOREGROUND_INTENSITY | FOREGROUND_BLUE};
-	inline constexpr ConsoleTextAttr light_green{FOREGROUND_INTENSITY | FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr light_aqua{FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr light_red{FOREGROUND_INTENSITY | FOREGROUND_RED};
-	inline constexpr ConsoleTextAttr light_purple{FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE};
-	inline constexpr ConsoleTextAttr light_yellow{FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_GREEN};
-	inline constexpr ConsoleTextAttr bright_white{FOREGROUND_INTENSITY | FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN};
-}
+/**AttrStreambuf
+	The interface of stream buffers that carry the attributes in-band with the characters.
+	The stream operators detect it behind the 'rdbuf()' of a stream and record the attributes
+	at the current position of the buffer instead of calling the console,
+	so the colours line up with the text without flushing the stream.
+	See 'colour_console_streambuf.h' for the implementations.
+	
+	Every attribute stream buffer is registered while it is attached, so the stream operators find it behind 'rdbuf()' without RTTI.
+	Every thread remembers the results for the streams it has used last, so the registry is only searched
+	when a thread writes into another stream or buffer or after an attribute state has been created or destroyed.
+	
+	Other threads may call the buffer as soon as it is registered, so the most derived class calls 'attach()'
+	at the end of its constructor and 'detach()' at the beginning of its destructor, when it is complete.
+*/
+class AttrStreambuf : public std::streambuf, public AttrState{
+public:
+	AttrStreambuf() = default;
+	
+	AttrStreambuf(const AttrStreambuf&) = delete;
+	AttrStreambuf& operator = (const AttrStreambuf&) = delete;
+	
+	~AttrStreambuf() override;
+	
+	/**
+		Returns the attribute stream buffer if the buffer is one, or 'nullptr'
+	*/
+	static AttrStreambuf* find(const std::streambuf* buffer){
+		if(buffer == nullptr) return nullptr;
+		AttrStateRegistry& registry = attr_state_registry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+		for(AttrStreambuf* registered = registry.buffers; registered != nullptr; registered = registered->next_){
+			if(static_cast<const std::streambuf*>(registered) == buffer) return registered;
+		}
+		return nullptr;
+	}
+	
+protected:
+	/**
+		Registers the buffer, so that the stream operators find it
+	*/
+	void attach(){
+		AttrStateRegistry& registry = attr_state_registry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+		if(this->attached_) return;
+		this->next_ = registry.buffers;
+		registry.buffers = this;
+		this->attached_ = true;
+		registry.count.fetch_add(1, std::memory_order_relaxed);
+		registry.generation.fetch_add(1, std::memory_order_release);
+	}
+	
+	/**
+		Removes the buffer from the registry, it is safe to call it more than once
+	*/
+	void detach(){
+		AttrStateRegistry& registry = attr_state_registry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+		if(!this->attached_) return;
+		AttrStreambuf** link = &registry.buffers;
+		while(*link != this) link = &(*link)->next_;
+		*link = this->next_;
+		this->attached_ = false;
+		registry.count.fetch_sub(1, std::memory_order_relaxed);
+		registry.generation.fetch_add(1, std::memory_order_release);
+	}
+	
+private:
+	AttrStreambuf* next_ = nullptr;
+	bool attached_ = false;
+};
 
-/** BackgroundColour (background colour)
-	this enum is used to change the background colour of the output stream. 
-	Every symbol that is being printed after a BackgroundColour is being printed in that colour.
-*/	
-
-namespace Background{	
-	inline constexpr unsigned int mask = BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_BLUE | BACKGROUND_GREEN;
-	inline constexpr ConsoleTextAttrChange black{0, mask};
-	inline constexpr ConsoleTextAttrChange blue{BACKGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange green{BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange aqua{BACKGROUND_BLUE | BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange red{BACKGROUND_RED, mask};
-	inline constexpr ConsoleTextAttrChange purple{BACKGROUND_RED | BACKGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange yellow{BACKGROUND_RED | BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange white{BACKGROUND_RED | BACKGROUND_BLUE | BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange grey{BACKGROUND_INTENSITY, mask};
-	inline constexpr ConsoleTextAttrChange light_blue{BACKGROUND_INTENSITY | BACKGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange light_green{BACKGROUND_INTENSITY | BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange light_aqua{BACKGROUND_INTENSITY | BACKGROUND_BLUE | BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange light_red{BACKGROUND_INTENSITY | BACKGROUND_RED, mask};
-	inline constexpr ConsoleTextAttrChange light_purple{BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_BLUE, mask};
-	inline constexpr ConsoleTextAttrChange light_yellow{BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_GREEN, mask};
-	inline constexpr ConsoleTextAttrChange bright_white{BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_BLUE | BACKGROUND_GREEN, mask};
+/// the key function of the class, so that the module emits its virtual table and type information
+OMEGA_COLOR_CONSOLE_MODULE_INLINE AttrStreambuf::~AttrStreambuf(){
+	// in case the derived class has not detached itself
+	this->detach();
 }
 
-namespace BackgroundSet{	
-	inline constexpr unsigned int mask = BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_BLUE | BACKGROUND_GREEN;
-	inline constexpr ConsoleTextAttr blue{BACKGROUND_BLUE};
-	inline constexpr ConsoleTextAttr green{BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr aqua{BACKGROUND_BLUE | BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr red{BACKGROUND_RED};
-	inline constexpr ConsoleTextAttr purple{BACKGROUND_RED | BACKGROUND_BLUE};
-	inline constexpr ConsoleTextAttr yellow{BACKGROUND_RED | BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr white{BACKGROUND_RED | BACKGROUND_BLUE | BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr grey{BACKGROUND_INTENSITY};
-	inline constexpr ConsoleTextAttr light_blue{BACKGROUND_INTENSITY | BACKGROUND_BLUE};
-	inline constexpr ConsoleTextAttr light_green{BACKGROUND_INTENSITY | BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr light_aqua{BACKGROUND_INTENSITY | BACKGROUND_BLUE | BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr light_red{BACKGROUND_INTENSITY | BACKGROUND_RED};
-	inline constexpr ConsoleTextAttr light_purple{BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_BLUE};
-	inline constexpr ConsoleTextAttr light_yellow{BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_GREEN};
-	inline constexpr ConsoleTextAttr bright_white{BACKGROUND_INTENSITY | BACKGROUND_RED | BACKGROUND_BLUE | BACKGROUND_GREEN};
+
+/**StreamAttrState
+	Gives a stream its own logical attributes, as long as the state exists.
+	The stream operators then resolve changes against this state, they never read or write the process wide console state,
+	so every stream, for example the console, a file and a socket, can be coloured independently and from different threads. 
+	With 'RedirectPolicy::vt' the changes are written as escape sequences into the stream, with 'RedirectPolicy::strip' they are only tracked.
+	
+	std::ofstream file("log.txt");
+	cc::StreamAttrState file_state(file, cc::RedirectPolicy::vt);
+	file << Text::red << "error" << Preset::Default << '\n';
+	
+	The state is found through the address of the stream, not through its 'pword', so 'copyfmt' does not copy it to another stream.
+	If there are several states for a stream, the most recently created one is used.
+*/
+class StreamAttrState : public AttrState{
+public:
+	explicit StreamAttrState(std::ostream& stream, RedirectPolicy policy = RedirectPolicy::vt, ConsoleTextAttr attributes = default_attributes)
+		: stream_(stream)
+		, policy_(policy)
+		, attributes_(attributes){
+		AttrStateRegistry& registry = attr_state_registry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+		this->next_ = registry.states;
+		registry.states = this;
+		registry.count.fetch_add(1, std::memory_order_relaxed);
+		registry.generation.fetch_add(1, std::memory_order_release);
+	}
+	
+	StreamAttrState(const StreamAttrState&) = delete;
+	StreamAttrState& operator = (const StreamAttrState&) = delete;
+	
+	~StreamAttrState(){
+		AttrStateRegistry& registry = attr_state_registry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+		StreamAttrState** link = &registry.states;
+		while(*link != this) link = &(*link)->next_;
+		*link = this->next_;
+		registry.count.fetch_sub(1, std::memory_order_relaxed);
+		registry.generation.fetch_add(1, std::memory_order_release);
+	}
+	
+	/**
+		Returns the most recently created state of the stream, or 'nullptr'
+	*/
+	static StreamAttrState* find(const std::ios_base* stream){
+		if(stream == nullptr) return nullptr;
+		AttrStateRegistry& registry = attr_state_registry();
+		const std::lock_guard<std::mutex> lock(registry.mutex);
+		for(StreamAttrState* registered = registry.states; registered != nullptr; registered = registered->next_){
+			if(static_cast<const std::ios_base*>(&registered->stream_) == stream) return registered;
+		}
+		return nullptr;
+	}
+	
+	ConsoleTextAttr attributes() const override {return this->attributes_;}
+	
+	/**
+		Writes the difference to the previous attributes into the stream, equal attributes write nothing
+	*/
+	void set_attributes(ConsoleTextAttr attributes) override {
+		if(this->policy_ == RedirectPolicy::vt && attributes.value != this->attributes_.value){
+			const vt::Sgr sgr = vt::sgr(attributes, vt::difference_mask(this->attributes_, attributes));
+			this->stream_.write(sgr.data, static_cast<std::streamsize>(sgr.size));
+		}
+		this->attributes_ = attributes;
+	}
+	
+	RedirectPolicy policy() const {return this->policy_;}
+	
+private:
+	std::ostream& stream_;
+	RedirectPolicy policy_;
+	ConsoleTextAttr attributes_;
+	StreamAttrState* next_ = nullptr;
+};
+
+template<class OStream, class = void>
+struct has_streambuf : std::false_type{};
+
+template<class OStream>
+struct has_streambuf<OStream, std::void_t<decltype(static_cast<std::streambuf*>(std::declval<OStream&>().rdbuf()))>> : std::true_type{};
+
+/**
+	Returns the 'StreamAttrState' of the stream, otherwise the buffer if it is an 'AttrStreambuf', otherwise 'nullptr'.
+	The results are remembered per thread and not in the streams, because streams like 'std::cout' are shared between threads.
+*/
+OMEGA_COLOR_CONSOLE_MODULE_INLINE AttrState* cached_attr_state(const std::ios_base* stream, std::streambuf* buffer){
+	struct Entry{
+		const std::ios_base* stream = nullptr;
+		const std::streambuf* buffer = nullptr;
+		long generation = -1;
+		AttrState* found = nullptr;
+	};
+	constexpr std::size_t capacity = 4;
+	thread_local Entry entries[capacity];
+	thread_local std::size_t next = 0;
+	
+	const long generation = attr_state_registry().generation.load(std::memory_order_acquire);
+	for(const Entry& entry : entries){
+		if(entry.stream == stream && entry.buffer == buffer && entry.generation == generation) return entry.found;
+	}
+	AttrState* found = StreamAttrState::find(stream);
+	if(found == nullptr) found = AttrStreambuf::find(buffer);
+	entries[next++ % capacity] = Entry{stream, buffer, generation, found};
+	return found;
 }
 
 /**
-	With the Bar one can set lines above the text, underscores, lines left of each symbol and right of each symbol
+	Returns the state that keeps the attributes of the stream: its 'StreamAttrState', its 'AttrStreambuf'
+	or 'nullptr' if the stream uses the process wide console state.
+	As long as no such state exists in the program this costs one atomic load.
+*/
+template<class OStream>
+inline AttrState* attr_state([[maybe_unused]] OStream& stream){
+	if(attr_state_registry().count.load(std::memory_order_relaxed) == 0) return nullptr;
+	if constexpr (std::is_base_of_v<std::ios_base, OStream>){
+		return cached_attr_state(&stream, stream.rdbuf());
+	}else if constexpr (has_streambuf<OStream>::value){
+		return cached_attr_state(nullptr, static_cast<std::streambuf*>(stream.rdbuf()));
+	}else{
+		return nullptr;
+	}
+}
+
+/**StreamAttrChain
+	Returned by the attribute operators of streams, it collects the attribute operations of one expression.
+	If the stream uses the process wide console state, consecutive operations without text in between
+	only change the shadow copy, the console gets one escape sequence or attribute call
+	when the next value is printed into the stream or at the end of the expression:
+	
+	std::cout << Text::red << Background::blue << Bar::bottom << "x";	// one escape sequence in front of "x"
+	
+	Streams with an 'AttrStreambuf' or a 'StreamAttrState' apply the operations to their state immediately.
+	The chain converts to the stream, so functions that return the stream of the expression do not change.
 */
-namespace Bar{
-	inline constexpr ConsoleTextAttrChange top{COMMON_LVB_GRID_HORIZONTAL, COMMON_LVB_GRID_HORIZONTAL};
-	inline constexpr ConsoleTextAttrChange top_off{0, COMMON_LVB_GRID_HORIZONTAL};
+template<class OStream>
+class StreamAttrChain{
+public:
+	template<class Attr>
+	StreamAttrChain(OStream& stream, Attr attr)
+		: stream_(stream)
+		, state_(attr_state(stream)){
+		this->apply(attr);
+	}
+	
+	StreamAttrChain(const StreamAttrChain&) = delete;
+	StreamAttrChain& operator = (const StreamAttrChain&) = delete;
+	
+	~StreamAttrChain(){this->flush();}
+	
+	StreamAttrChain&& operator << (ConsoleTextAttr attr) && {this->apply(attr); return std::move(*this);}
+	StreamAttrChain&& operator << (ConsoleTextAttrChange attr) && {this->apply(attr); return std::move(*this);}
+	StreamAttrChain&& operator << (ConsoleTextAttrPush attr) && {this->apply(attr); return std::move(*this);}
+	StreamAttrChain&& operator << (ConsoleTextAttrPop attr) && {this->apply(attr); return std::move(*this);}
 	
-	inline constexpr ConsoleTextAttrChange bottom{COMMON_LVB_UNDERSCORE, COMMON_LVB_UNDERSCORE};
-	inline constexpr ConsoleTextAttrChange bottom_off{0, COMMON_LVB_UNDERSCORE};
+	/**
+		Brings the collected attributes to the console and prints the value into the stream
+	*/
+	template<class T>
+	decltype(auto) operator << (T&& value) && {
+		this->flush();
+		return this->stream_ << std::forward<T>(value);
+	}
 	
-	inline constexpr ConsoleTextAttrChange left{COMMON_LVB_GRID_LVERTICAL, COMMON_LVB_GRID_LVERTICAL};
-	inline constexpr ConsoleTextAttrChange left_off{0, COMMON_LVB_GRID_LVERTICAL};
+	/// manipulators like 'std::endl' and 'std::flush'
+	OStream& operator << (std::ostream& (*manipulator)(std::ostream&)) && {
+		this->flush();
+		manipulator(this->stream_);
+		return this->stream_;
+	}
 	
-	inline constexpr ConsoleTextAttrChange right{COMMON_LVB_GRID_RVERTICAL, COMMON_LVB_GRID_RVERTICAL};
-	inline constexpr ConsoleTextAttrChange right_off{0, COMMON_LVB_GRID_RVERTICAL};
+	/// manipulators like 'std::hex'
+	OStream& operator << (std::ios_base& (*manipulator)(std::ios_base&)) && {
+		this->flush();
+		manipulator(this->stream_);
+		return this->stream_;
+	}
 	
-	inline constexpr ConsoleTextAttrChange all{COMMON_LVB_GRID_HORIZONTAL | COMMON_LVB_UNDERSCORE | COMMON_LVB_GRID_LVERTICAL | COMMON_LVB_GRID_RVERTICAL, COMMON_LVB_GRID_HORIZONTAL | COMMON_LVB_UNDERSCORE | COMMON_LVB_GRID_LVERTICAL | COMMON_LVB_GRID_RVERTICAL};
-	inline constexpr ConsoleTextAttrChange all_off{0, COMMON_LVB_GRID_HORIZONTAL | COMMON_LVB_UNDERSCORE | COMMON_LVB_GRID_LVERTICAL | COMMON_LVB_GRID_RVERTICAL};
+	/**
+		Brings the collected attributes to the console and returns the stream
+	*/
+	operator OStream& () {
+		this->flush();
+		return this->stream_;
+	}
+	
+	/**
+		Brings the collected attributes to the console
+	*/
+	void flush(){
+		if(this->state_ == nullptr) console_state().flush(this->stream_, this->pending_);
+	}
+	
+private:
+	void apply(ConsoleTextAttr attr){
+		if(this->state_ != nullptr) this->state_->set_attributes(attr);
+		else console_state().defer(this->pending_, attr);
+	}
+	
+	void apply(ConsoleTextAttrChange attr){
+		if(this->state_ != nullptr) this->state_->change(attr);
+		else console_state().defer(this->pending_, attr);
+	}
+	
+	void apply(ConsoleTextAttrPush attr){
+		if(this->state_ != nullptr) this->state_->push(attr.attributes);
+		else console_state().defer_push(this->pending_, attr.attributes);
+	}
+	
+	void apply(ConsoleTextAttrPop){
+		if(this->state_ != nullptr) this->state_->pop();
+		else console_state().defer_pop(this->pending_);
+	}
+	
+	OStream& stream_;
+	AttrState* state_;
+	ConsoleState::Pending pending_;
+};
+
+/**
+	Set the colour and text format within the stream.
+	With the virtual terminal backend the escape sequence is written into the stream
+	in front of the next value that is printed, consecutive changes are merged.
+	Streams with an 'AttrStreambuf' record the attributes in-band instead,
+	streams with a 'StreamAttrState' resolve them against their own state.
+*/
+template<class OStream, enable_if_stream_t<OStream> = 0>
+StreamAttrChain<OStream> operator << (OStream& stream, ConsoleTextAttr attr){
+	return StreamAttrChain<OStream>(stream, attr);
 }
 
-namespace BarSet{
-	inline constexpr ConsoleTextAttr top{COMMON_LVB_GRID_HORIZONTAL};
-	inline constexpr ConsoleTextAttr bottom{COMMON_LVB_UNDERSCORE};
-	inline constexpr ConsoleTextAttr left{COMMON_LVB_GRID_LVERTICAL};
-	inline constexpr ConsoleTextAttr right{COMMON_LVB_GRID_RVERTICAL};
-	inline constexpr ConsoleTextAttr all{COMMON_LVB_GRID_HORIZONTAL | COMMON_LVB_UNDERSCORE | COMMON_LVB_GRID_LVERTICAL | COMMON_LVB_GRID_RVERTICAL};
+/**
+	change only the settings that are set in the mask and keep everything else
+*/
+inline void change_text_attributes(ConsoleTextAttrChange attr){
+	console_state().change(attr);
 }
 
-namespace Invert{
-	inline constexpr ConsoleTextAttrChange on{COMMON_LVB_REVERSE_VIDEO, COMMON_LVB_REVERSE_VIDEO};
-	inline constexpr ConsoleTextAttrChange off{0, COMMON_LVB_REVERSE_VIDEO};
+/**
+	Change the colour and text format within the stream.
+	With the virtual terminal backend the escape sequence is written into the stream
+	in front of the next value that is printed, consecutive changes are merged.
+	Streams with an 'AttrStreambuf' record the attributes in-band instead,
+	streams with a 'StreamAttrState' resolve them against their own state.
+*/
+template<class OStream, enable_if_stream_t<OStream> = 0>
+StreamAttrChain<OStream> operator << (OStream& stream, ConsoleTextAttrChange attr){
+	return StreamAttrChain<OStream>(stream, attr);
 }
 
-namespace Preset{
-	inline constexpr ConsoleTextAttr Default = TextSet::white;
-	inline constexpr ConsoleTextAttr link = TextSet::blue | BarSet::bottom;
-	inline constexpr ConsoleTextAttr active_link = TextSet::purple | BarSet::bottom;
+
+
+template<class OStream, enable_if_stream_t<OStream> = 0>
+StreamAttrChain<OStream> operator << (OStream& stream, ConsoleTextAttrPush attr){
+	return StreamAttrChain<OStream>(stream, attr);
 }
 
-namespace Dye{
-	inline constexpr ConsoleTextAttrChangePrint black(std::string_view string){return ConsoleTextAttrChangePrint{Text::black, string};}
-	inline constexpr ConsoleTextAttrChangePrint blue(std::string_view string){return ConsoleTextAttrChangePrint{Text::blue, string};}
-	inline constexpr ConsoleTextAttrChangePrint green(std::string_view string){return ConsoleTextAttrChangePrint{Text::green, string};}
-	inline constexpr ConsoleTextAttrChangePrint aqua(std::string_view string){return ConsoleTextAttrChangePrint{Text::aqua, string};}
-	inline constexpr ConsoleTextAttrChangePrint red(std::string_view string){return ConsoleTextAttrChangePrint{Text::red, string};}
-	inline constexpr ConsoleTextAttrChangePrint purple(std::string_view string){return ConsoleTextAttrChangePrint{Text::purple, string};}
-	inline constexpr ConsoleTextAttrChangePrint yellow(std::string_view string){return ConsoleTextAttrChangePrint{Text::yellow, string};}
-	inline constexpr ConsoleTextAttrChangePrint white(std::string_view string){return ConsoleTextAttrChangePrint{Text::white, string};}
-	inline constexpr ConsoleTextAttrChangePrint grey(std::string_view string){return ConsoleTextAttrChangePrint{Text::grey, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_blue(std::string_view string){return ConsoleTextAttrChangePrint{Text::light_blue, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_green(std::string_view string){return ConsoleTextAttrChangePrint{Text::light_green, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_aqua(std::string_view string){return ConsoleTextAttrChangePrint{Text::light_aqua, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_red(std::string_view string){return ConsoleTextAttrChangePrint{Text::light_red, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_purple(std::string_view string){return ConsoleTextAttrChangePrint{Text::light_purple, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_yellow(std::string_view string){return ConsoleTextAttrChangePrint{Text::light_yellow, string};}
-	inline constexpr ConsoleTextAttrChangePrint bright_white(std::string_view string){return ConsoleTextAttrChangePrint{Text::bright_white, string};}
-	
-	inline constexpr ConsoleTextAttrChangePrint black(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::black | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint blue(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::blue | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint green(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::green | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint aqua(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::aqua | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint red(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::red | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint purple(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::purple | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint yellow(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::yellow | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint white(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::white | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint grey(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::grey | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_blue(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::light_blue | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_green(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::light_green | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_aqua(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::light_aqua | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_red(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::light_red | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_purple(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::light_purple | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_yellow(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::light_yellow | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint bright_white(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Text::bright_white | formatedString.attributes, formatedString.string};}
+template<class OStream, enable_if_stream_t<OStream> = 0>
+StreamAttrChain<OStream> operator << (OStream& stream, ConsoleTextAttrPop attr){
+	return StreamAttrChain<OStream>(stream, attr);
 }
 
-namespace Mark{
-	inline constexpr ConsoleTextAttrChangePrint black(std::string_view string){return ConsoleTextAttrChangePrint{Background::black, string};}
-	inline constexpr ConsoleTextAttrChangePrint blue(std::string_view string){return ConsoleTextAttrChangePrint{Background::blue, string};}
-	inline constexpr ConsoleTextAttrChangePrint green(std::string_view string){return ConsoleTextAttrChangePrint{Background::green, string};}
-	inline constexpr ConsoleTextAttrChangePrint aqua(std::string_view string){return ConsoleTextAttrChangePrint{Background::aqua, string};}
-	inline constexpr ConsoleTextAttrChangePrint red(std::string_view string){return ConsoleTextAttrChangePrint{Background::red, string};}
-	inline constexpr ConsoleTextAttrChangePrint purple(std::string_view string){return ConsoleTextAttrChangePrint{Background::purple, string};}
-	inline constexpr ConsoleTextAttrChangePrint yellow(std::string_view string){return ConsoleTextAttrChangePrint{Background::yellow, string};}
-	inline constexpr ConsoleTextAttrChangePrint white(std::string_view string){return ConsoleTextAttrChangePrint{Background::white, string};}
-	inline constexpr ConsoleTextAttrChangePrint grey(std::string_view string){return ConsoleTextAttrChangePrint{Background::grey, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_blue(std::string_view string){return ConsoleTextAttrChangePrint{Background::light_blue, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_green(std::string_view string){return ConsoleTextAttrChangePrint{Background::light_green, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_aqua(std::string_view string){return ConsoleTextAttrChangePrint{Background::light_aqua, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_red(std::string_view string){return ConsoleTextAttrChangePrint{Background::light_red, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_purple(std::string_view string){return ConsoleTextAttrChangePrint{Background::light_purple, string};}
-	inline constexpr ConsoleTextAttrChangePrint light_yellow(std::string_view string){return ConsoleTextAttrChangePrint{Background::light_yellow, string};}
-	inline constexpr ConsoleTextAttrChangePrint bright_white(std::string_view string){return ConsoleTextAttrChangePrint{Background::bright_white, string};}
-	
-	inline constexpr ConsoleTextAttrChangePrint black(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::black | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint blue(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::blue | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint green(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::green | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint aqua(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::aqua | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint red(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::red | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint purple(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::purple | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint yellow(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::yellow | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint white(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::white | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint grey(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::grey | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_blue(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::light_blue | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_green(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::light_green | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_aqua(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::light_aqua | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_red(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::light_red | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_purple(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::light_purple | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint light_yellow(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::light_yellow | formatedString.attributes, formatedString.string};}
-	inline constexpr ConsoleTextAttrChangePrint bright_white(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Background::bright_white | formatedString.attributes, formatedString.string};}
+
+
+/**
+	prints the string in 'attr' with the applied attributes for the text and then changes the text back to its previous font.
+	The previous attributes are remembered on the attribute stack, 
+	so this costs no query of the console and at most two attribute writes, even for nested spans.
+	Streams with an attribute state remember them in the span itself, so no stack is shared with other threads.
+*/
+template<class OStream, class Payload, enable_if_stream_t<OStream> = 0>
+OStream& operator << (OStream& stream, const BasicConsoleTextAttrChangePrint<Payload>& attr){
+	if(AttrState* state = attr_state(stream)){
+		const ConsoleTextAttr previous = state->attributes();
+		state->change(attr.attributes);
+		stream << attr.string;
+		state->set_attributes(previous);
+		return stream;
+	}
+	ConsoleState& console = console_state();
+	console.push(stream, attr.attributes);
+	stream << attr.string;
+	console.pop(stream);
+	return stream;
 }
 
-inline constexpr ConsoleTextAttrChangePrint Underline(std::string_view string){return ConsoleTextAttrChangePrint{Bar::bottom, string};}
+/**BasicConsoleWriter
+	A buffered console sink that collects text together with its attributes as runs in one contiguous buffer.
+	Attribute changes do not call the console, they only change the attributes of the text that follows.
+	At a flush point the runs are drained with one 'SetConsoleTextAttribute' and one 'WriteConsoleW' per run,
+	so there is no need to flush after every colour change to keep the colours correct.
+	With the virtual terminal backend the escape sequences are stored in-band with the text 
+	and the whole buffer is written with a single call.
+	
+	The writer does not use any dynamic memory, the capacities of the text buffer (in bytes of UTF-8 text)
+	and of the run table are given as template parameters. If one of them is full the writer flushes itself. 
+	The writer is also flushed on destruction.
+	
+	cc::ConsoleWriter out;
+	out << "Normal text " << Text::red << "This text is red" << '\n';
+	out << "In this text we " << Dye::yellow("dyed") << " this text piece" << '\n';
+	out.flush();
+*/
+template<std::size_t TextCapacity, std::size_t RunCapacity>
+class BasicConsoleWriter : public AttrSink<BasicConsoleWriter<TextCapacity, RunCapacity>>{
+	static_assert(TextCapacity >= 2 * vt::max_sgr_size, "the text buffer has to be able to hold at least one escape sequence and one UTF-8 code point");
+	static_assert(RunCapacity >= 1, "the run table has to be able to hold at least one run");
+	
+public:
+	explicit BasicConsoleWriter(ConsoleState& console = console_state()) 
+		: console_(console)
+		, attributes_(console.attributes()){}
+	
+	BasicConsoleWriter(const BasicConsoleWriter&) = delete;
+	BasicConsoleWriter& operator = (const BasicConsoleWriter&) = delete;
+	
+	~BasicConsoleWriter(){
+		this->flush();
+	}
+	
+	/**
+		Returns the attributes that will be applied to the next text that is written
+	*/
+	ConsoleTextAttr attributes() const {return this->attributes_;}
+	
+	/**
+		Writes the text with the current attributes into the buffer
+	*/
+	void write(std::string_view text){
+		if(text.empty()) return;
+		
+		// text that looks the same with the attributes of the previous text is written with them, 
+		// so the change is not written at all
+		const ConsoleTextAttr previous = this->previous_attributes();
+		const ConsoleTextAttr attributes = ((this->run_count_ != 0 || this->console_.is_known()) && renders_alike(previous, this->attributes_, text)) 
+			? previous : this->attributes_;
+		this->count_collapsed_changes(previous, attributes);
+		
+		while(!text.empty()){
+			if(this->text_size_ == TextCapacity) this->flush();
+			
+			// start a new run only if the attributes have changed since the last text
+			if(this->run_count_ == 0 || this->runs_[this->run_count_-1].attributes != attributes.value){
+				if(this->run_count_ == RunCapacity || this->text_size_ + vt::max_sgr_size >= TextCapacity) this->flush();
+				this->begin_run(attributes);
+			}
+			
+			std::size_t size = std::min(text.size(), TextCapacity - this->text_size_);
+			if(size < text.size()){
+				// do not split UTF-8 code points between two flushes
+				while(size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) --size;
+				if(size == 0){
+					this->flush();
+					continue;
+				}
+			}
+			
+			std::memcpy(this->text_ + this->text_size_, text.data(), size);
+			this->text_size_ += size;
+			this->runs_[this->run_count_-1].size += static_cast<std::uint32_t>(size);
+			text.remove_prefix(size);
+		}
+	}
+	
+	/**
+		Writes all buffered runs to the console and empties the buffer
+	*/
+	void flush(){
+		if(this->run_count_ == 0) return;
+		
+		if(this->console_.backend() != Backend::win32){
+			// the escape sequences are already in-band with the text, or there are none for redirected output
+			this->write_console(this->text_, this->text_size_);
+			this->console_.track(ConsoleTextAttr{this->runs_[this->run_count_-1].attributes});
+		}else{
+			const char* text = this->text_;
+			for(std::size_t i = 0; i < this->run_count_; ++i){
+				const Run run = this->runs_[i];
+				this->console_.set(ConsoleTextAttr{run.attributes});
+				this->write_console(text, run.size);
+				text += run.size;
+			}
+		}
+		this->text_size_ = 0;
+		this->run_count_ = 0;
+	}
+	
+	/**
+		Changes the attributes of the text that is written next, this does not call the console
+	*/
+	void set_attributes(ConsoleTextAttr attributes){
+		this->attributes_ = attributes;
+		++this->pending_changes_;
+	}
+	
+private:
+	struct Run{
+		unsigned int attributes;
+		std::uint32_t size;
+	};
+	
+	/**
+		Consecutive changes without text in between collapse into at most one write.
+		The skipped ones are counted as elided changes of the console.
+	*/
+	void count_collapsed_changes(ConsoleTextAttr previous, ConsoleTextAttr attributes){
+		if(this->pending_changes_ == 0) return;
+		const bool changed = previous.value != attributes.value;
+		this->console_.count_elided(this->pending_changes_ - (changed ? 1 : 0));
+		this->pending_changes_ = 0;
+	}
+	
+	/// the attributes of the last run, or of the console if the buffer is empty
+	ConsoleTextAttr previous_attributes() const {
+		return (this->run_count_ == 0) ? this->console_.attributes() : ConsoleTextAttr{this->runs_[this->run_count_-1].attributes};
+	}
+	
+	void begin_run(ConsoleTextAttr attributes){
+		if(this->console_.backend() == Backend::vt){
+			const vt::Sgr sgr = (this->run_count_ == 0 && !this->console_.is_known()) 
+				? vt::sgr(attributes) 
+				: vt::sgr(attributes, vt::difference_mask(this->previous_attributes(), attributes));
+			std::memcpy(this->text_ + this->text_size_, sgr.data, sgr.size);
+			this->text_size_ += sgr.size;
+		}
+		this->runs_[this->run_count_++] = Run{attributes.value, 0};
+	}
+	
+	void write_console(const char* text, std::size_t size){
+#ifdef _WIN32
+		if(!this->console_.is_console()) return this->console_.write(std::string_view(text, size));
+		const std::size_t wide_size = utf8::to_utf16(std::string_view(text, size), this->wide_);
+		count_written_bytes(wide_size * sizeof(wchar_t));
+		platform::write_utf16(this->console_.handle(), this->wide_, wide_size);
+#else
+		this->console_.write(std::string_view(text, size));
+#endif
+	}
+	
+	ConsoleState& console_;
+	ConsoleTextAttr attributes_;
+	std::size_t text_size_ = 0;
+	std::size_t run_count_ = 0;
+	std::uint32_t pending_changes_ = 0;
+	Run runs_[RunCapacity];
+	char text_[TextCapacity];
+#ifdef _WIN32
+	wchar_t wide_[TextCapacity];
+#endif
+};
+
+using ConsoleWriter = BasicConsoleWriter<4096, 256>;
+
 
-inline constexpr ConsoleTextAttrChangePrint Underline(ConsoleTextAttrChangePrint formatedString){return ConsoleTextAttrChangePrint{Bar::bottom | formatedString.attributes, formatedString.string};}
 
 }//namespace cc
 
+#ifndef OMEGA_COLOR_CONSOLE_COMPILED_BACKEND
+	#ifdef _WIN32
+		#include "colour_console_win32.h"
+	#else
+		#include "colour_console_posix.h"
+	#endif
+#endif
+
 #endif //OMEGA_COLOR_CONSOLE_H
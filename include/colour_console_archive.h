@@ -0,0 +1,477 @@
+/*
+	Description
+	-----------
+
+	A compact binary file format for archiving coloured console output, that can be searched and replayed
+	without parsing escape sequences.
+
+	```C++
+	static cc::ArchiveWriter archive("console.ccar");
+
+	archive.entry() << Text::red << "error: " << Preset::Default << "in " << Dye::yellow(file) << '\n';
+	```
+
+	```C++
+	cc::ArchiveReader archive("console.ccar");
+	cc::ConsoleWriter out;
+	archive.for_each_entry_in_time(from, to, [&](const cc::ArchiveEntry& entry){cc::replay_entry(entry, out);});
+	```
+
+	The file starts with a header of 32 bytes:
+		- the magic "ccarchv1"
+		- the block size as 32 bit value
+		- 20 reserved bytes
+	followed by blocks of 'block size' bytes, only the last block may be shorter. Every block starts with a header of 32 bytes:
+		- the magic "ccb1"
+		- the size of the entries in the block as 32 bit value
+		- the time of the first and the last entry in the block as 64 bit values
+		- the number of entries in the block as 32 bit value
+		- 4 reserved bytes
+	followed by the entries. Every entry is a header of 12 bytes, the 64 bit time and the 32 bit size of the runs,
+	followed by the runs in the binary format of 'colour_console_render.h': a header of 4 bytes with
+	the 16 bit attributes and the 16 bit size of the text, followed by the UTF-8 text.
+	All values are little endian, the times are nanoseconds since the epoch of the system clock.
+
+	The block headers are the index of the file: an entry never crosses a block, so the entries of any time
+	or offset range are found with a binary search over the blocks of the memory mapped file.
+	The writer keeps the times increasing and writes every block only when it is full or flushed,
+	blocks that are damaged, for example by a crash while writing, are skipped by the reader.
+
+	The writer holds one block and one entry, so with the default block size of 64 KiB it should be static or a member.
+	No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_ARCHIVE_H
+#define OMEGA_COLOR_CONSOLE_ARCHIVE_H
+
+#include "colour_console.h"
+#include "colour_console_bulk.h"
+#include "colour_console_render.h"
+
+#ifdef _WIN32
+	#include "colour_console_win32.h"
+#else
+	//posix
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+//std
+#include <chrono>
+#include <cstdint>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+namespace archive{
+
+inline constexpr std::string_view file_magic = "ccarchv1";
+inline constexpr std::string_view block_magic = "ccb1";
+
+inline constexpr std::size_t file_header_size = 32;
+inline constexpr std::size_t block_header_size = 32;
+inline constexpr std::size_t entry_header_size = 12;
+
+/// stores the lowest 'size' bytes of the value in little endian
+inline void store(char* out, std::uint64_t value, std::size_t size){
+	for(std::size_t i = 0; i < size; ++i) out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+/// loads a little endian value of 'size' bytes
+inline std::uint64_t load(const char* in, std::size_t size){
+	std::uint64_t value = 0;
+	for(std::size_t i = 0; i < size; ++i) value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+	return value;
+}
+
+/**
+	Returns the current time in the unit of the archive
+*/
+inline std::uint64_t now(){
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+}//namespace archive
+
+/**BasicArchiveWriter
+	Writes entries of attribute runs into an archive file with blocks of 'BlockSize' bytes.
+	An existing file is replaced. Must only be used by one thread at a time.
+*/
+template<std::size_t BlockSize = 65536>
+class BasicArchiveWriter{
+	static_assert(BlockSize >= 1024, "the blocks have to be large enough to hold some entries");
+	static_assert(BlockSize <= 0xFFFFFFFF, "the block size is stored with 32 bit");
+
+public:
+	/// the largest size of the runs of an entry, larger entries are split into several entries
+	static constexpr std::size_t max_entry_size = BlockSize - archive::block_header_size - archive::entry_header_size;
+
+	/**Entry
+		The sink that formats one entry of the archive.
+		The entry is added when it is destroyed, with the time it was created at.
+	*/
+	class Entry : public AttrSink<Entry>{
+	public:
+		Entry(BasicArchiveWriter& writer, std::uint64_t time)
+			: writer_(writer)
+			, time_(time){}
+
+		Entry(const Entry&) = delete;
+		Entry& operator = (const Entry&) = delete;
+
+		~Entry(){
+			this->writer_.commit(this->time_);
+		}
+
+		ConsoleTextAttr attributes() const {return this->writer_.entry_.attributes();}
+
+		void set_attributes(ConsoleTextAttr attributes){this->writer_.entry_.set_attributes(attributes);}
+
+		void write(std::string_view text){
+			BufferWriter& entry = this->writer_.entry_;
+			while(!text.empty()){
+				// a piece that leaves room for the header of a new run always fits
+				const std::size_t space = max_entry_size - entry.size();
+				if(space <= run_header_size){
+					this->writer_.commit(this->time_);
+					continue;
+				}
+				const std::size_t size = std::min(text.size(), space - run_header_size);
+				entry.write(text.substr(0, size));
+				text.remove_prefix(size);
+			}
+		}
+
+	private:
+		BasicArchiveWriter& writer_;
+		std::uint64_t time_;
+	};
+
+	explicit BasicArchiveWriter(const char* path, ConsoleTextAttr attributes = Preset::Default)
+		: entry_(entry_data_, sizeof(entry_data_), RenderFormat::runs, attributes){
+		char header[archive::file_header_size] = {};
+		std::memcpy(header, archive::file_magic.data(), archive::file_magic.size());
+		archive::store(header + 8, BlockSize, 4);
+#ifdef _WIN32
+		this->file_ = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(this->file_ == INVALID_HANDLE_VALUE) return;
+#else
+		this->file_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(this->file_ < 0) return;
+#endif
+		this->good_ = this->write_at(0, header, sizeof(header));
+	}
+
+	BasicArchiveWriter(const BasicArchiveWriter&) = delete;
+	BasicArchiveWriter& operator = (const BasicArchiveWriter&) = delete;
+
+	~BasicArchiveWriter(){
+		this->flush();
+#ifdef _WIN32
+		if(this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+#else
+		if(this->file_ >= 0) ::close(this->file_);
+#endif
+	}
+
+	/**
+		Returns false if the file could not be created or a write has failed
+	*/
+	bool good() const {return this->good_;}
+
+	/**
+		Returns a sink for a new entry with the current time
+	*/
+	Entry entry(){return Entry(*this, archive::now());}
+
+	/**
+		Returns a sink for a new entry with the time in nanoseconds since the epoch of the system clock
+	*/
+	Entry entry(std::uint64_t time){return Entry(*this, time);}
+
+	/**
+		Adds an entry of runs that have already been rendered in the binary run format, for example with a 'BufferWriter'.
+		Runs that are larger than 'max_entry_size' are ignored and false is returned.
+	*/
+	bool append(std::uint64_t time, std::string_view runs){
+		if(runs.size() > max_entry_size) return false;
+		if(!runs.empty()) this->append_entry(time, runs);
+		return true;
+	}
+
+	/**
+		Writes the current block, so the file contains all entries that have been added until now
+	*/
+	void flush(){
+		if(this->entry_count_ == 0) return;
+		char* const header = this->block_;
+		std::memcpy(header, archive::block_magic.data(), archive::block_magic.size());
+		archive::store(header + 4, this->used_, 4);
+		archive::store(header + 8, this->first_time_, 8);
+		archive::store(header + 16, this->last_time_, 8);
+		archive::store(header + 24, this->entry_count_, 4);
+		archive::store(header + 28, 0, 4);
+		const std::uint64_t offset = archive::file_header_size + this->block_index_ * static_cast<std::uint64_t>(BlockSize);
+		if(this->good_) this->good_ = this->write_at(offset, this->block_, archive::block_header_size + this->used_);
+	}
+
+private:
+	void commit(std::uint64_t time){
+		if(this->entry_.size() != 0) this->append_entry(time, this->entry_.view());
+		this->entry_.clear();
+	}
+
+	void append_entry(std::uint64_t time, std::string_view runs){
+		// the times never decrease, so the blocks can be searched, even if the system clock is set back
+		if(time < this->last_time_) time = this->last_time_;
+		if(archive::block_header_size + this->used_ + archive::entry_header_size + runs.size() > BlockSize){
+			this->flush();
+			++this->block_index_;
+			this->used_ = 0;
+			this->entry_count_ = 0;
+		}
+		if(this->entry_count_ == 0) this->first_time_ = time;
+		char* const entry = this->block_ + archive::block_header_size + this->used_;
+		archive::store(entry, time, 8);
+		archive::store(entry + 8, runs.size(), 4);
+		std::memcpy(entry + archive::entry_header_size, runs.data(), runs.size());
+		this->used_ += archive::entry_header_size + runs.size();
+		this->last_time_ = time;
+		++this->entry_count_;
+	}
+
+	bool write_at(std::uint64_t offset, const char* data, std::size_t size){
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD written;
+		return WriteFile(this->file_, data, static_cast<DWORD>(size), &written, &overlapped) && written == size;
+#else
+		while(size != 0){
+			const ssize_t written = ::pwrite(this->file_, data, size, static_cast<off_t>(offset));
+			if(written <= 0) return false;
+			data += written;
+			size -= static_cast<std::size_t>(written);
+			offset += static_cast<std::uint64_t>(written);
+		}
+		return true;
+#endif
+	}
+
+#ifdef _WIN32
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+	int file_ = -1;
+#endif
+	bool good_ = false;
+
+	std::uint64_t block_index_ = 0;
+	std::size_t used_ = 0;			///< the size of the entries in the current block
+	std::size_t entry_count_ = 0;
+	std::uint64_t first_time_ = 0;
+	std::uint64_t last_time_ = 0;
+	char block_[BlockSize];
+
+	char entry_data_[max_entry_size];
+	BufferWriter entry_;
+};
+
+using ArchiveWriter = BasicArchiveWriter<>;
+
+/**ArchiveEntry
+	An entry of an archive, the runs point into the memory mapped file
+*/
+struct ArchiveEntry{
+	std::uint64_t time = 0;		///< nanoseconds since the epoch of the system clock
+	std::size_t offset = 0;		///< the offset of the entry in the file
+	std::string_view runs;		///< the runs in the binary run format
+};
+
+/**ArchiveBlock
+	The header and the entries of a block of an archive
+*/
+struct ArchiveBlock{
+	bool valid = false;			///< false if the block is damaged or missing
+	std::size_t offset = 0;		///< the offset of the block in the file
+	std::uint64_t first_time = 0;
+	std::uint64_t last_time = 0;
+	std::size_t entry_count = 0;
+	std::string_view entries;
+};
+
+/**ArchiveReader
+	Reads an archive from a memory mapped file
+*/
+class ArchiveReader{
+public:
+	explicit ArchiveReader(const char* path)
+		: file_(path){
+		const std::string_view data = this->file_.text();
+		if(data.size() < archive::file_header_size || data.substr(0, archive::file_magic.size()) != archive::file_magic) return;
+		this->block_size_ = static_cast<std::size_t>(archive::load(data.data() + 8, 4));
+		if(this->block_size_ <= archive::block_header_size) return;
+		this->block_count_ = (data.size() - archive::file_header_size + this->block_size_ - 1) / this->block_size_;
+		this->open_ = true;
+	}
+
+	ArchiveReader(const ArchiveReader&) = delete;
+	ArchiveReader& operator = (const ArchiveReader&) = delete;
+
+	/**
+		Returns false if the file could not be mapped or is not an archive
+	*/
+	bool is_open() const {return this->open_;}
+
+	std::size_t size() const {return this->file_.text().size();}
+	std::size_t block_size() const {return this->block_size_;}
+	std::size_t block_count() const {return this->block_count_;}
+
+	/**
+		Returns the block with the index, damaged blocks and indices that are too large return an invalid block
+	*/
+	ArchiveBlock block(std::size_t index) const {
+		ArchiveBlock block;
+		if(index >= this->block_count_) return block;
+		const std::string_view data = this->file_.text();
+		block.offset = archive::file_header_size + index * this->block_size_;
+		const std::string_view bytes = data.substr(block.offset, this->block_size_);
+		if(bytes.size() < archive::block_header_size || bytes.substr(0, archive::block_magic.size()) != archive::block_magic) return block;
+		const std::size_t used = static_cast<std::size_t>(archive::load(bytes.data() + 4, 4));
+		if(used > bytes.size() - archive::block_header_size) return block;
+		block.first_time = archive::load(bytes.data() + 8, 8);
+		block.last_time = archive::load(bytes.data() + 16, 8);
+		block.entry_count = static_cast<std::size_t>(archive::load(bytes.data() + 24, 4));
+		block.entries = bytes.substr(archive::block_header_size, used);
+		block.valid = true;
+		return block;
+	}
+
+	/**
+		Returns the index of the first block that may contain entries at or after the time,
+		or 'block_count()' if there is none
+	*/
+	std::size_t find_time(std::uint64_t time) const {
+		std::size_t first = 0;
+		std::size_t count = this->block_count_;
+		while(count > 0){
+			const std::size_t half = count / 2;
+			const std::size_t middle = first + half;
+			if(this->last_time_from(middle) < time){
+				first = middle + 1;
+				count -= half + 1;
+			}else{
+				count = half;
+			}
+		}
+		return first;
+	}
+
+	/**
+		Returns the index of the block that contains the offset
+	*/
+	std::size_t find_offset(std::size_t offset) const {
+		if(offset < archive::file_header_size || this->block_size_ == 0) return 0;
+		return std::min((offset - archive::file_header_size) / this->block_size_, this->block_count_);
+	}
+
+	/**
+		Calls the function with every entry of the block as an 'ArchiveEntry'.
+		Returns false if the block is invalid or ends in the middle of an entry.
+	*/
+	template<class Function>
+	bool for_each_entry(const ArchiveBlock& block, Function&& function) const {
+		if(!block.valid) return false;
+		std::string_view entries = block.entries;
+		std::size_t offset = block.offset + archive::block_header_size;
+		while(!entries.empty()){
+			if(entries.size() < archive::entry_header_size) return false;
+			const std::uint64_t time = archive::load(entries.data(), 8);
+			const std::size_t size = static_cast<std::size_t>(archive::load(entries.data() + 8, 4));
+			if(entries.size() - archive::entry_header_size < size) return false;
+			function(ArchiveEntry{time, offset, entries.substr(archive::entry_header_size, size)});
+			entries.remove_prefix(archive::entry_header_size + size);
+			offset += archive::entry_header_size + size;
+		}
+		return true;
+	}
+
+	/**
+		Calls the function with every entry whose time is in the range ['from', 'to')
+	*/
+	template<class Function>
+	void for_each_entry_in_time(std::uint64_t from, std::uint64_t to, Function&& function) const {
+		for(std::size_t index = this->find_time(from); index < this->block_count_; ++index){
+			const ArchiveBlock block = this->block(index);
+			if(!block.valid) continue;
+			if(block.first_time >= to) return;
+			this->for_each_entry(block, [&](const ArchiveEntry& entry){
+				if(entry.time >= from && entry.time < to) function(entry);
+			});
+		}
+	}
+
+	/**
+		Calls the function with every entry that starts in the range ['from', 'to') of offsets in the file
+	*/
+	template<class Function>
+	void for_each_entry_in_offsets(std::size_t from, std::size_t to, Function&& function) const {
+		for(std::size_t index = this->find_offset(from); index < this->block_count_; ++index){
+			const ArchiveBlock block = this->block(index);
+			if(block.offset >= to) return;
+			this->for_each_entry(block, [&](const ArchiveEntry& entry){
+				if(entry.offset >= from && entry.offset < to) function(entry);
+			});
+		}
+	}
+
+	/**
+		Returns the time of the first entry in the archive or 0 if it is empty
+	*/
+	std::uint64_t first_time() const {
+		for(std::size_t index = 0; index < this->block_count_; ++index){
+			const ArchiveBlock block = this->block(index);
+			if(block.valid && block.entry_count != 0) return block.first_time;
+		}
+		return 0;
+	}
+
+	/**
+		Returns the time of the last entry in the archive or 0 if it is empty
+	*/
+	std::uint64_t last_time() const {
+		for(std::size_t index = this->block_count_; index > 0; --index){
+			const ArchiveBlock block = this->block(index - 1);
+			if(block.valid && block.entry_count != 0) return block.last_time;
+		}
+		return 0;
+	}
+
+private:
+	/// the last time of the block or of the next valid block, so damaged blocks do not break the binary search
+	std::uint64_t last_time_from(std::size_t index) const {
+		for(; index < this->block_count_; ++index){
+			const ArchiveBlock block = this->block(index);
+			if(block.valid) return block.last_time;
+		}
+		return ~std::uint64_t(0);
+	}
+
+	MappedFile file_;
+	std::size_t block_size_ = 0;
+	std::size_t block_count_ = 0;
+	bool open_ = false;
+};
+
+/**
+	Writes the runs of the entry into a stream or sink, for example a 'ConsoleWriter'.
+	Returns false if the entry ends in the middle of a run.
+*/
+template<class Out>
+inline bool replay_entry(const ArchiveEntry& entry, Out& out){
+	return replay_runs(entry.runs, out);
+}
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_ARCHIVE_H
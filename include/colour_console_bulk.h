@@ -0,0 +1,309 @@
+/*
+	Description
+	-----------
+
+	Bulk output of text that is already formatted into attribute runs,
+	for example large reports or diffs with hundreds of thousands of coloured lines.
+
+	The runs are written without going through a stream and without copying the text into a buffer first:
+		- Consecutive runs with the same attributes, whose text is contiguous in memory, are written with one call,
+		  so the output is only split at attribute boundaries. Blank runs that only change the foreground colour
+		  do not split the output either.
+		- On posix the escape sequences and the texts of many runs are gathered into one 'writev' call.
+		- With the win32 backend the attributes are set once per run and the text is written directly.
+		- Redirected output that drops the attributes writes contiguous text with one call, regardless of the attributes.
+
+	```C++
+	const cc::AttrRun runs[] = {{Preset::Default, "unchanged line\n"}, {TextSet::red, "-removed line\n"}, {TextSet::green, "+added line\n"}};
+	cc::write_runs(runs);
+	```
+
+	The text can also come from a memory mapped file with a parallel table of attribute runs,
+	each run covers the next 'size' bytes of the text:
+
+	```C++
+	cc::MappedFile report("report.txt");
+	const cc::AttrRunSize table[] = {{Preset::Default, 120}, {TextSet::red, 40}, {Preset::Default, 2000}};
+	cc::write_runs(report.text(), table);
+	```
+
+	No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_BULK_H
+#define OMEGA_COLOR_CONSOLE_BULK_H
+
+#include "colour_console.h"
+
+#ifdef _WIN32
+	#include "colour_console_win32.h"
+#else
+	//posix
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <sys/uio.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+//std
+#include <iterator>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**AttrRunSize
+	The attributes of the next 'size' bytes of a text, used for run tables that are stored apart from the text
+*/
+struct AttrRunSize{
+	ConsoleTextAttr attributes;
+	std::size_t size;
+};
+
+/**BulkWriter
+	Writes a sequence of runs to the console with as few calls as possible and without copying the text.
+	The runs are added in order with 'add()', 'finish()' writes everything that is still pending.
+	The text of the runs has to stay valid until 'finish()' has returned.
+*/
+class BulkWriter{
+public:
+	explicit BulkWriter(ConsoleState& console = console_state())
+		: console_(console){}
+
+	BulkWriter(const BulkWriter&) = delete;
+	BulkWriter& operator = (const BulkWriter&) = delete;
+
+	~BulkWriter(){
+		this->finish();
+	}
+
+	void add(ConsoleTextAttr attributes, std::string_view text){
+		if(text.empty()) return;
+		if(!this->pending_.empty() && this->pending_.data() + this->pending_.size() == text.data()
+			&& (renders_alike(this->pending_attributes_, attributes, text) || this->console_.backend() == Backend::none)){
+			// contiguous text that does not need a visible attribute change in between is written with the same call
+			this->pending_ = std::string_view(this->pending_.data(), this->pending_.size() + text.size());
+			return;
+		}
+		this->emit();
+		this->pending_ = text;
+		this->pending_attributes_ = attributes;
+	}
+
+	void finish(){
+		this->emit();
+#ifndef _WIN32
+		this->write_gathered();
+#endif
+	}
+
+private:
+	void emit(){
+		if(this->pending_.empty()) return;
+		const std::string_view text = this->pending_;
+		ConsoleTextAttr attributes = this->pending_attributes_;
+		this->pending_ = std::string_view();
+		// blank text keeps the current attributes if that looks the same
+		if(this->console_.is_known() && renders_alike(this->console_.attributes(), attributes, text)) attributes = this->console_.attributes();
+
+		switch(this->console_.backend()){
+			case Backend::win32:
+				this->console_.set(attributes);
+				this->console_.write_text(text);
+				break;
+			case Backend::none:
+				this->console_.track(attributes);
+#ifdef _WIN32
+				this->console_.write_text(text);
+#else
+				this->gather(vt::Sgr(), text);
+#endif
+				break;
+			case Backend::vt:{
+				const ConsoleTextAttr current = this->console_.attributes();
+				vt::Sgr sgr;
+				if(!this->console_.is_known()){
+					sgr = vt::sgr(attributes);
+					this->console_.track(attributes);
+				}else if(current.value != attributes.value){
+					sgr = vt::sgr(attributes, vt::difference_mask(current, attributes));
+					this->console_.track(attributes);
+				}
+#ifdef _WIN32
+				if(!sgr.empty()) this->console_.write_text(sgr.view());
+				this->console_.write_text(text);
+#else
+				this->gather(sgr, text);
+#endif
+			}break;
+		}
+	}
+
+#ifndef _WIN32
+	static constexpr std::size_t max_vectors = 64;
+
+	/// queues the escape sequence and the text for the next 'writev'
+	void gather(const vt::Sgr& sgr, std::string_view text){
+		if(this->vector_count_ + 2 > max_vectors) this->write_gathered();
+		if(!sgr.empty()){
+			vt::Sgr& stored = this->sgrs_[this->vector_count_];
+			stored = sgr;
+			this->vectors_[this->vector_count_++] = iovec{stored.data, stored.size};
+		}
+		this->vectors_[this->vector_count_++] = iovec{const_cast<char*>(text.data()), text.size()};
+	}
+
+	void write_gathered(){
+		iovec* vectors = this->vectors_;
+		std::size_t count = this->vector_count_;
+		this->vector_count_ = 0;
+
+		for(std::size_t i = 0; i < count; ++i) count_written_bytes(vectors[i].iov_len);
+		while(count != 0){
+			const ssize_t written = kernel_call(KernelCall::write_file, [&]{return ::writev(this->console_.handle(), vectors, static_cast<int>(count));});
+			if(written < 0){
+				if(errno == EINTR) continue;
+				return;
+			}
+			// skip what has been written, 'writev' may stop in the middle of a vector
+			std::size_t remaining = static_cast<std::size_t>(written);
+			while(count != 0 && remaining >= vectors->iov_len){
+				remaining -= vectors->iov_len;
+				++vectors;
+				--count;
+			}
+			if(count != 0){
+				vectors->iov_base = static_cast<char*>(vectors->iov_base) + remaining;
+				vectors->iov_len -= remaining;
+			}
+		}
+	}
+
+	// the escape sequence of a run is stored at the index of its vector, so it stays valid until the write
+	vt::Sgr sgrs_[max_vectors];
+	iovec vectors_[max_vectors];
+	std::size_t vector_count_ = 0;
+#endif
+
+	ConsoleState& console_;
+	std::string_view pending_;
+	ConsoleTextAttr pending_attributes_;
+};
+
+/**
+	Writes the runs to the console, see 'BulkWriter'
+*/
+inline void write_runs(const AttrRun* runs, std::size_t count, ConsoleState& console = console_state()){
+	BulkWriter writer(console);
+	for(std::size_t i = 0; i < count; ++i) writer.add(runs[i].attributes, runs[i].text);
+}
+
+/**
+	Writes the text with the attributes of the parallel run table, each run covers the next 'size' bytes of the text.
+	Text that is not covered by the table is not written.
+*/
+inline void write_runs(std::string_view text, const AttrRunSize* runs, std::size_t count, ConsoleState& console = console_state()){
+	BulkWriter writer(console);
+	for(std::size_t i = 0; i < count && !text.empty(); ++i){
+		const std::size_t size = std::min(runs[i].size, text.size());
+		writer.add(runs[i].attributes, text.substr(0, size));
+		text.remove_prefix(size);
+	}
+}
+
+/**
+	Writes a contiguous container of 'AttrRun', for example an array or a 'std::vector'
+*/
+template<class Runs>
+inline auto write_runs(const Runs& runs, ConsoleState& console = console_state()) -> decltype(static_cast<const AttrRun*>(std::data(runs)), void()){
+	write_runs(std::data(runs), std::size(runs), console);
+}
+
+/**
+	Writes the text with a contiguous container of 'AttrRunSize' as the run table
+*/
+template<class Runs>
+inline auto write_runs(std::string_view text, const Runs& runs, ConsoleState& console = console_state()) -> decltype(static_cast<const AttrRunSize*>(std::data(runs)), void()){
+	write_runs(text, std::data(runs), std::size(runs), console);
+}
+
+/**MappedFile
+	A read only memory mapped file, so large texts can be written without reading them into a buffer first.
+	If the file cannot be opened or mapped 'is_open()' returns false and the text is empty.
+*/
+class MappedFile{
+public:
+	explicit MappedFile(const char* path){
+#ifdef _WIN32
+		this->file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(this->file_ == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(this->file_, &size)) return;
+		this->open_ = true;
+		if(size.QuadPart == 0) return;
+		this->mapping_ = CreateFileMappingA(this->file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(this->mapping_ == nullptr){
+			this->open_ = false;
+			return;
+		}
+		this->data_ = static_cast<const char*>(MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0));
+		if(this->data_ == nullptr){
+			this->open_ = false;
+			return;
+		}
+		this->size_ = static_cast<std::size_t>(size.QuadPart);
+#else
+		const int file = ::open(path, O_RDONLY);
+		if(file < 0) return;
+		struct stat info;
+		if(::fstat(file, &info) == 0){
+			this->open_ = true;
+			if(info.st_size > 0){
+				void* data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+				if(data != MAP_FAILED){
+					this->data_ = static_cast<const char*>(data);
+					this->size_ = static_cast<std::size_t>(info.st_size);
+				}else{
+					this->open_ = false;
+				}
+			}
+		}
+		// the mapping stays valid after the file has been closed
+		::close(file);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+
+	~MappedFile(){
+#ifdef _WIN32
+		if(this->data_ != nullptr) UnmapViewOfFile(this->data_);
+		if(this->mapping_ != nullptr) CloseHandle(this->mapping_);
+		if(this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+#else
+		if(this->data_ != nullptr) ::munmap(const_cast<char*>(this->data_), this->size_);
+#endif
+	}
+
+	bool is_open() const {return this->open_;}
+
+	/**
+		Returns the content of the file
+	*/
+	std::string_view text() const {return std::string_view(this->data_, this->size_);}
+
+private:
+#ifdef _WIN32
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = nullptr;
+#endif
+	const char* data_ = nullptr;
+	std::size_t size_ = 0;
+	bool open_ = false;
+};
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_BULK_H
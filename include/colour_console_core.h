@@ -0,0 +1,896 @@
+/*
+	Description
+	-----------
+	
+	The core of this library: the console attributes, the colour constants ('Text', 'Background', 'Bar', ...),
+	their composition and the translation into virtual terminal escape sequences, together with the sinks
+	that keep track of the attributes themselves ('AttrSink').
+	
+	Everything in this header is constexpr or inline and independent of the platform,
+	it does not include '<windows.h>' or any other system header. The numeric values of the attributes
+	are the same as those of the windows 'FOREGROUND_*', 'BACKGROUND_*' and 'COMMON_LVB_*' macros,
+	'colour_console_win32.h' checks that they match.
+	
+	Headers of your own that only pass attributes around or build coloured text into a sink only need this one.
+	Include 'colour_console.h' to write to the console and to colour standard streams.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_CORE_H
+#define OMEGA_COLOR_CONSOLE_CORE_H
+
+//std
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+#endif
+
+/// expands to 'export' when the headers are compiled as the module 'cc', see 'colour_console.cppm'
+#ifndef OMEGA_COLOR_CONSOLE_EXPORT
+	#define OMEGA_COLOR_CONSOLE_EXPORT
+#endif
+
+/// expands to 'inline' for the functions with static variables and the key functions of classes,
+/// the module 'cc' compiles them once into its object instead, see 'colour_console.cppm'
+#ifndef OMEGA_COLOR_CONSOLE_MODULE_INLINE
+	#define OMEGA_COLOR_CONSOLE_MODULE_INLINE inline
+#endif
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/** Attribute
+	The bits of the console attributes. 
+	Those have the same values as the windows 'FOREGROUND_*', 'BACKGROUND_*' and 'COMMON_LVB_*' macros,
+	but are also available on platforms that do not have the windows headers.
+*/
+namespace Attribute{
+	inline constexpr unsigned int foreground_blue = 0x0001;
+	inline constexpr unsigned int foreground_green = 0x0002;
+	inline constexpr unsigned int foreground_red = 0x0004;
+	inline constexpr unsigned int foreground_intensity = 0x0008;
+	inline constexpr unsigned int background_blue = 0x0010;
+	inline constexpr unsigned int background_green = 0x0020;
+	inline constexpr unsigned int background_red = 0x0040;
+	inline constexpr unsigned int background_intensity = 0x0080;
+	inline constexpr unsigned int grid_horizontal = 0x0400;
+	inline constexpr unsigned int grid_lvertical = 0x0800;
+	inline constexpr unsigned int grid_rvertical = 0x1000;
+	inline constexpr unsigned int reverse_video = 0x4000;
+	inline constexpr unsigned int underscore = 0x8000;
+	
+	inline constexpr unsigned int foreground = foreground_blue | foreground_green | foreground_red | foreground_intensity;
+	inline constexpr unsigned int background = background_blue | background_green | background_red | background_intensity;
+	inline constexpr unsigned int all = foreground | background | grid_horizontal | grid_lvertical | grid_rvertical | reverse_video | underscore;
+}
+
+/**ConsoleTextAttr
+	Used to set specific attributes, all other attributes will be reset when printed.
+*/
+struct ConsoleTextAttr{
+	unsigned int value = 0;
+};
+
+inline constexpr ConsoleTextAttr operator | (ConsoleTextAttr lhs, ConsoleTextAttr rhs){
+	return ConsoleTextAttr{lhs.value | rhs.value};
+}
+
+/**ConsoleTextAttrChange
+	Used to change a specific set of attributes, all other attributes will reman as they were before.
+*/
+struct ConsoleTextAttrChange{
+	unsigned int value = 0;
+	unsigned int mask = 0;
+};
+
+inline constexpr ConsoleTextAttrChange operator | (ConsoleTextAttrChange lhs, ConsoleTextAttrChange rhs){
+	return ConsoleTextAttrChange{lhs.value | rhs.value, lhs.mask | rhs.mask};
+}
+
+/**
+	Returns the attributes that result from applying the change to the given attributes.
+	Only the settings that are set in the mask will be changed, everything else is kept.
+*/
+inline constexpr ConsoleTextAttr apply_change(ConsoleTextAttr attributes, ConsoleTextAttrChange change){
+	return ConsoleTextAttr{(attributes.value & ~change.mask) | (change.value & change.mask)};
+}
+
+/** vt
+	Translation of the console attributes into virtual terminal (ANSI) 'SGR' escape sequences.
+	
+	The windows colour bits are ordered blue, green, red whereas the ANSI colour index is ordered red, green, blue.
+	Underscore, reverse video and the top bar (as overline) have SGR equivalents. 
+	For the left and right bars there is no SGR equivalent, so they are ignored.
+	
+	Everything in here is 'constexpr', so the escape sequences of all the constants in the namespaces 
+	'Text', 'Background', 'Bar', 'Invert', 'Preset' and of their compositions with the '|' operator 
+	can be generated at compile time. Emitting them is then just a copy of a few bytes:
+	
+		constexpr auto my_preset = Text::blue | Background::white | Bar::bottom;
+		constexpr vt::Sgr my_preset_sgr = vt::sgr(my_preset);	// "\x1b[34;47;4m"
+		
+	The variable template 'vt::sgr_v<value, mask>' forces the evaluation at compile time.
+*/
+namespace vt{
+	
+	/// the maximal number of characters of a single escape sequence, including the 24-bit colours of 'colour_console_extended.h'
+	inline constexpr std::size_t max_sgr_size = 64;
+	
+	/**Sgr
+		An escape sequence that is stored in place, so that it can be generated at compile time
+	*/
+	struct Sgr{
+		char data[max_sgr_size] = {};
+		std::size_t size = 0;
+		
+		constexpr std::string_view view() const {return std::string_view(data, size);}
+		constexpr bool empty() const {return size == 0;}
+	};
+	
+	/**Code
+		The decimal digits of a single SGR parameter
+	*/
+	struct Code{
+		char data[4] = {};
+		std::size_t size = 0;
+	};
+	
+	inline constexpr Code make_code(unsigned int number){
+		Code code;
+		if(number >= 100) code.data[code.size++] = static_cast<char>('0' + number / 100);
+		if(number >= 10) code.data[code.size++] = static_cast<char>('0' + (number / 10) % 10);
+		code.data[code.size++] = static_cast<char>('0' + number % 10);
+		return code;
+	}
+	
+	/// converts the 4 windows colour bits (blue, green, red, intensity) into the ANSI colour index without intensity
+	inline constexpr unsigned int ansi_colour_index(unsigned int colour){
+		return ((colour & 0x4) >> 2) | (colour & 0x2) | ((colour & 0x1) << 2);
+	}
+	
+	/**ColourCodes
+		The SGR parameters of all 16 colours, indexed by the 4 windows colour bits
+	*/
+	struct ColourCodes{
+		Code codes[16] = {};
+		
+		constexpr const Code& operator[](unsigned int colour) const {return codes[colour];}
+	};
+	
+	inline constexpr ColourCodes make_colour_codes(unsigned int normal, unsigned int bright){
+		ColourCodes table;
+		for(unsigned int colour = 0; colour < 16; ++colour){
+			table.codes[colour] = make_code(((colour & 0x8) ? bright : normal) + ansi_colour_index(colour));
+		}
+		return table;
+	}
+	
+	inline constexpr ColourCodes foreground_codes = make_colour_codes(30, 90);
+	inline constexpr ColourCodes background_codes = make_colour_codes(40, 100);
+	inline constexpr Code reset_code = make_code(0);
+	inline constexpr Code underscore_codes[2] = {make_code(24), make_code(4)};
+	inline constexpr Code reverse_video_codes[2] = {make_code(27), make_code(7)};
+	inline constexpr Code overline_codes[2] = {make_code(55), make_code(53)};
+	
+	/// appends a parameter to the sequence that is being built
+	inline constexpr void append(Sgr& sgr, const Code& code){
+		if(sgr.size == 0){
+			sgr.data[sgr.size++] = '\x1b';
+			sgr.data[sgr.size++] = '[';
+		}else{
+			sgr.data[sgr.size++] = ';';
+		}
+		for(std::size_t i = 0; i < code.size; ++i) sgr.data[sgr.size++] = code.data[i];
+	}
+	
+	/// appends the parameters of all fields that are touched by the mask, the field values are taken from the attributes
+	inline constexpr void append_fields(Sgr& sgr, ConsoleTextAttr attributes, unsigned int mask){
+		if(mask & Attribute::foreground) append(sgr, foreground_codes[attributes.value & Attribute::foreground]);
+		if(mask & Attribute::background) append(sgr, background_codes[(attributes.value & Attribute::background) >> 4]);
+		if(mask & Attribute::underscore) append(sgr, underscore_codes[(attributes.value & Attribute::underscore) ? 1 : 0]);
+		if(mask & Attribute::reverse_video) append(sgr, reverse_video_codes[(attributes.value & Attribute::reverse_video) ? 1 : 0]);
+		if(mask & Attribute::grid_horizontal) append(sgr, overline_codes[(attributes.value & Attribute::grid_horizontal) ? 1 : 0]);
+	}
+	
+	/// terminates the sequence, empty sequences stay empty
+	inline constexpr Sgr& finish(Sgr& sgr){
+		if(sgr.size != 0) sgr.data[sgr.size++] = 'm';
+		return sgr;
+	}
+	
+	/**
+		Returns the escape sequence that sets exactly the given attributes
+	*/
+	inline constexpr Sgr sgr(ConsoleTextAttr attributes){
+		Sgr result;
+		append(result, reset_code);
+		append_fields(result, attributes, Attribute::foreground | Attribute::background);
+		append_fields(result, attributes, attributes.value & (Attribute::underscore | Attribute::reverse_video | Attribute::grid_horizontal));
+		return finish(result);
+	}
+	
+	/**
+		Returns the escape sequence that writes all fields touched by the mask with the values from 'resolved',
+		which are the attributes after a change has been applied.
+	*/
+	inline constexpr Sgr sgr(ConsoleTextAttr resolved, unsigned int mask){
+		Sgr result;
+		append_fields(result, resolved, mask);
+		return finish(result);
+	}
+	
+	/**
+		Returns true if the change either replaces a whole colour or leaves it untouched.
+		Only then the escape sequence of the change does not depend on the current attributes.
+		All constants of this library satisfy this.
+	*/
+	inline constexpr bool is_field_aligned(ConsoleTextAttrChange change){
+		const unsigned int foreground = change.mask & Attribute::foreground;
+		const unsigned int background = change.mask & Attribute::background;
+		return (foreground == 0 || foreground == Attribute::foreground) && (background == 0 || background == Attribute::background);
+	}
+	
+	/**
+		Returns the escape sequence of a change that does not depend on the current attributes.
+		The change has to be field aligned, see 'is_field_aligned()'.
+	*/
+	inline constexpr Sgr sgr(ConsoleTextAttrChange change){
+		return sgr(ConsoleTextAttr{change.value & change.mask}, change.mask);
+	}
+	
+	/**
+		The escape sequence of a change, guaranteed to be generated at compile time
+	*/
+	template<unsigned int Value, unsigned int Mask>
+	inline constexpr Sgr sgr_v = sgr(ConsoleTextAttrChange{Value, Mask});
+	
+	/**
+		Returns a mask of all fields in which the two attributes differ
+	*/
+	inline constexpr unsigned int difference_mask(ConsoleTextAttr lhs, ConsoleTextAttr rhs){
+		const unsigned int difference = lhs.value ^ rhs.value;
+		unsigned int mask = difference & ~(Attribute::foreground | Attribute::background);
+		if(difference & Attribute::foreground) mask |= Attribute::foreground;
+		if(difference & Attribute::background) mask |= Attribute::background;
+		return mask;
+	}
+	
+}//namespace vt
+
+/** utf8
+	Minimal UTF-8 decoding for sinks that work on characters instead of bytes
+*/
+namespace utf8{
+	
+	/// the code point that replaces invalid sequences
+	inline constexpr char32_t replacement = 0xFFFD;
+	
+	/**
+		Decodes the next code point and removes it from the front of the text.
+		Invalid and truncated sequences are decoded as one 'replacement' per byte.
+		The text must not be empty.
+	*/
+	inline constexpr char32_t next(std::string_view& text){
+		const unsigned char lead = static_cast<unsigned char>(text[0]);
+		if(lead < 0x80){
+			text.remove_prefix(1);
+			return lead;
+		}
+		
+		const std::size_t size = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : (lead >= 0xC0) ? 2 : 0;
+		if(size == 0 || lead >= 0xF8 || text.size() < size){
+			text.remove_prefix(1);
+			return replacement;
+		}
+		
+		char32_t code_point = lead & (0x7F >> size);
+		for(std::size_t i = 1; i < size; ++i){
+			const unsigned char continuation = static_cast<unsigned char>(text[i]);
+			if((continuation & 0xC0) != 0x80){
+				text.remove_prefix(1);
+				return replacement;
+			}
+			code_point = (code_point << 6) | (continuation & 0x3F);
+		}
+		text.remove_prefix(size);
+		return code_point;
+	}
+	
+	/**
+		Encodes the code point into the buffer, which has to hold at least 4 bytes, and returns the number of bytes
+	*/
+	inline constexpr std::size_t encode(char32_t code_point, char* out){
+		if(code_point < 0x80){
+			out[0] = static_cast<char>(code_point);
+			return 1;
+		}else if(code_point < 0x800){
+			out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+			out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+			return 2;
+		}else if(code_point < 0x10000){
+			out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+			out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+			return 3;
+		}else{
+			out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+			out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+			out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+			out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+			return 4;
+		}
+	}
+	
+	/**
+		Converts the UTF-8 text to UTF-16 and returns the number of code units that have been written.
+		'out' has to hold at least 'text.size()' code units, UTF-16 never needs more code units than UTF-8 needs bytes.
+		Invalid sequences are converted like with 'next()'.
+		
+		Runs of ASCII are widened 32 (AVX2), 16 (SSE2) or 8 (64-bit words) bytes at a time, 
+		so mostly ASCII text is converted at memory bandwidth. Everything else is decoded code point by code point.
+	*/
+	template<class Char>
+	inline std::size_t to_utf16(std::string_view text, Char* out){
+		static_assert(sizeof(Char) >= 2, "UTF-16 needs code units of at least 16 bits");
+		Char* const begin = out;
+		const char* in = text.data();
+		const char* const end = in + text.size();
+		
+		while(in != end){
+			if constexpr (sizeof(Char) == 2){
+#if defined(__AVX2__)
+				while(end - in >= 32){
+					const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+					if(_mm256_movemask_epi8(bytes) != 0) break;
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+					in += 32;
+					out += 32;
+				}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+				const __m128i zero = _mm_setzero_si128();
+				while(end - in >= 16){
+					const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+					if(_mm_movemask_epi8(bytes) != 0) break;
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(bytes, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(bytes, zero));
+					in += 16;
+					out += 16;
+				}
+#endif
+			}
+			
+			while(end - in >= 8){
+				std::uint64_t word;
+				std::memcpy(&word, in, sizeof(word));
+				if((word & 0x8080808080808080ull) != 0) break;
+				for(std::size_t i = 0; i < 8; ++i) out[i] = static_cast<Char>(static_cast<unsigned char>(in[i]));
+				in += 8;
+				out += 8;
+			}
+			if(in == end) break;
+			
+			// decode code point by code point until the next ASCII byte, then try the wide path again
+			do{
+				std::string_view rest(in, static_cast<std::size_t>(end - in));
+				char32_t code_point = next(rest);
+				in = rest.data();
+				if(code_point > 0x10FFFF) code_point = replacement;
+				if(code_point >= 0x10000){
+					code_point -= 0x10000;
+					*out++ = static_cast<Char>(0xD800 + (code_point >> 10));
+					*out++ = static_cast<Char>(0xDC00 + (code_point & 0x3FF));
+				}else{
+					*out++ = static_cast<Char>(code_point);
+				}
+			}while(in != end && static_cast<unsigned char>(*in) >= 0x80);
+		}
+		return static_cast<std::size_t>(out - begin);
+	}
+	
+}//namespace utf8
+
+/**BasicTextAttrStack
+	A fixed size stack of attributes that is used to restore the attributes after a formatted span.
+	It does not use any dynamic memory. 
+	Pushes beyond the capacity are only counted, so that pushes and pops stay balanced,
+	but the pops that belong to them can not restore the attributes.
+*/
+template<std::size_t Capacity>
+class BasicTextAttrStack{
+public:
+	/**
+		Stores the attributes on top of the stack
+	*/
+	constexpr void push(ConsoleTextAttr attributes){
+		if(this->size_ < Capacity){
+			this->entries_[this->size_++] = attributes;
+		}else{
+			++this->overflow_;
+		}
+	}
+	
+	/**
+		Removes the attributes on top of the stack and writes them into 'restored'.
+		Returns false if the stack is empty or the matching push has overflown.
+	*/
+	constexpr bool pop(ConsoleTextAttr& restored){
+		if(this->overflow_ != 0){
+			--this->overflow_;
+			return false;
+		}
+		if(this->size_ == 0) return false;
+		restored = this->entries_[--this->size_];
+		return true;
+	}
+	
+	constexpr std::size_t size() const {return this->size_ + this->overflow_;}
+	constexpr bool empty() const {return this->size() == 0;}
+	
+private:
+	ConsoleTextAttr entries_[Capacity] = {};
+	std::size_t size_ = 0;
+	std::size_t overflow_ = 0;
+};
+
+using TextAttrStack = BasicTextAttrStack<32>;
+
+template<class Derived>
+class AttrSink;
+
+/**
+	True for all sinks that keep track of the attributes themselves and derive from 'AttrSink', 
+	the generic stream operators do not apply to them.
+*/
+template<class T>
+struct is_attribute_sink : std::is_base_of<AttrSink<T>, T>{};
+
+template<class T>
+using enable_if_stream_t = std::enable_if_t<!is_attribute_sink<T>::value, int>;
+
+/**ConsoleTextAttrPush
+	Remembers the current attributes on the attribute stack and applies the change when printed.
+	The attributes are restored by printing the matching 'pop' token.
+	
+	std::cout << push(Text::red) << "This text is red " << Dye::green("this is green") << " and red again" << pop << std::endl;
+*/
+struct ConsoleTextAttrPush{
+	ConsoleTextAttrChange attributes;
+};
+
+inline constexpr ConsoleTextAttrPush push(ConsoleTextAttrChange attributes){return ConsoleTextAttrPush{attributes};}
+
+/**ConsoleTextAttrPop
+	Restores the attributes of the matching 'push()' when printed
+*/
+struct ConsoleTextAttrPop{};
+
+inline constexpr ConsoleTextAttrPop pop{};
+
+/**ConsoleTextAttrPrint
+	Used to print a specific text in a specific style and then restores the previous text attributes.
+	
+	The payload can be anything that can be written into the stream. 
+	Everything that is convertible to a 'std::string_view' is stored as a view, everything else is stored by value.
+	No dynamic memory is used.
+*/
+template<class Payload>
+struct BasicConsoleTextAttrChangePrint{
+	ConsoleTextAttrChange attributes;
+	Payload string;
+};
+
+using ConsoleTextAttrChangePrint = BasicConsoleTextAttrChangePrint<std::string_view>;
+
+template<class T>
+struct is_console_text_attr_change_print : std::false_type{};
+
+template<class Payload>
+struct is_console_text_attr_change_print<BasicConsoleTextAttrChangePrint<Payload>> : std::true_type{};
+
+/**
+	The type in which a payload is stored in a 'BasicConsoleTextAttrChangePrint'
+*/
+template<class T>
+using console_print_payload_t = std::conditional_t<std::is_convertible_v<const T&, std::string_view>, std::string_view, std::decay_t<T>>;
+
+/**
+	Applies the attributes to the payload.
+	If the payload is already formatted, then the attributes are composed with the ones of the payload.
+*/
+template<class T>
+inline constexpr auto attr_print(ConsoleTextAttrChange attributes, const T& payload){
+	if constexpr (is_console_text_attr_change_print<T>::value){
+		return T{attributes | payload.attributes, payload.string};
+	}else{
+		return BasicConsoleTextAttrChangePrint<console_print_payload_t<T>>{attributes, payload};
+	}
+}
+
+/**AttrRun
+	A piece of text together with the attributes it is printed with
+*/
+struct AttrRun{
+	ConsoleTextAttr attributes;
+	std::string_view text;
+};
+
+/**
+	Returns true if the text only consists of spaces, tabs and line breaks
+*/
+inline constexpr bool is_blank(std::string_view text){
+	for(const char c : text){
+		if(c != ' ' && c != '\t' && c != '\n' && c != '\r') return false;
+	}
+	return true;
+}
+
+/**
+	Returns true if the text looks the same with both attributes.
+	Blank text shows no foreground colour, so it can stay in the run of the previous text
+	if only the foreground colours differ. Bars, underscores and inverted colours are drawn
+	in the foreground colour, so with them the foreground stays visible.
+*/
+inline constexpr bool renders_alike(ConsoleTextAttr a, ConsoleTextAttr b, std::string_view text){
+	constexpr unsigned int shows_foreground = Attribute::grid_horizontal | Attribute::grid_lvertical | Attribute::grid_rvertical 
+		| Attribute::reverse_video | Attribute::underscore;
+	const unsigned int difference = a.value ^ b.value;
+	return difference == 0 || ((difference & ~Attribute::foreground) == 0 && (a.value & shows_foreground) == 0 && is_blank(text));
+}
+
+/**BasicAttrRunBuffer
+	A fixed size buffer of text runs, each with its resolved attributes.
+	The text of all runs is stored in one contiguous buffer, no dynamic memory is used.
+	Text that is appended with the same attributes as the last run, or that would look the same with them, extends that run.
+*/
+template<std::size_t TextCapacity, std::size_t RunCapacity>
+class BasicAttrRunBuffer{
+	static_assert(TextCapacity >= 4, "the text buffer has to be able to hold at least one UTF-8 code point");
+	static_assert(RunCapacity >= 1, "the run table has to be able to hold at least one run");
+	
+public:
+	static constexpr std::size_t text_capacity = TextCapacity;
+	static constexpr std::size_t run_capacity = RunCapacity;
+	
+	/**
+		Appends as much of the text as fits, without splitting UTF-8 code points, and returns how many bytes have been appended
+	*/
+	std::size_t append(ConsoleTextAttr attributes, std::string_view text){
+		if(text.empty()) return 0;
+		if(this->run_count_ == 0 || !renders_alike(ConsoleTextAttr{this->runs_[this->run_count_-1].attributes}, attributes, text)){
+			if(this->run_count_ == RunCapacity) return 0;
+			this->runs_[this->run_count_++] = Run{attributes.value, 0};
+		}
+		
+		std::size_t size = std::min(text.size(), TextCapacity - this->text_size_);
+		if(size < text.size()){
+			while(size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) --size;
+		}
+		
+		std::memcpy(this->text_ + this->text_size_, text.data(), size);
+		this->text_size_ += size;
+		this->runs_[this->run_count_-1].size += static_cast<std::uint32_t>(size);
+		if(this->runs_[this->run_count_-1].size == 0) --this->run_count_;
+		return size;
+	}
+	
+	/**
+		Replaces the content with the content of the other buffer, only the used part is copied
+	*/
+	void assign(const BasicAttrRunBuffer& other){
+		std::memcpy(this->runs_, other.runs_, other.run_count_ * sizeof(Run));
+		std::memcpy(this->text_, other.text_, other.text_size_);
+		this->run_count_ = other.run_count_;
+		this->text_size_ = other.text_size_;
+	}
+	
+	void clear(){
+		this->run_count_ = 0;
+		this->text_size_ = 0;
+	}
+	
+	bool empty() const {return this->run_count_ == 0;}
+	std::size_t run_count() const {return this->run_count_;}
+	std::size_t text_size() const {return this->text_size_;}
+	
+	/**
+		Calls the function with every run in order as an 'AttrRun'
+	*/
+	template<class Function>
+	void for_each(Function&& function) const {
+		const char* text = this->text_;
+		for(std::size_t i = 0; i < this->run_count_; ++i){
+			function(AttrRun{ConsoleTextAttr{this->runs_[i].attributes}, std::string_view(text, this->runs_[i].size)});
+			text += this->runs_[i].size;
+		}
+	}
+	
+private:
+	struct Run{
+		unsigned int attributes;
+		std::uint32_t size;
+	};
+	
+	std::size_t run_count_ = 0;
+	std::size_t text_size_ = 0;
+	Run runs_[RunCapacity];
+	char text_[TextCapacity];
+};
+
+/**AttrSink
+	The common stream operators of all sinks that keep track of the attributes themselves,
+	like the 'BasicConsoleWriter'. Attribute changes are resolved against the logical attributes of the sink
+	and never call the console.
+	
+	The derived sink provides:
+		ConsoleTextAttr attributes() const;			the attributes of the next text
+		void set_attributes(ConsoleTextAttr);		changes the attributes of the next text
+		void write(std::string_view);				writes text with the current attributes
+*/
+template<class Derived>
+class AttrSink{
+public:
+	Derived& operator << (ConsoleTextAttr attr){
+		this->derived().set_attributes(attr);
+		return this->derived();
+	}
+	
+	Derived& operator << (ConsoleTextAttrChange attr){
+		this->derived().set_attributes(apply_change(this->derived().attributes(), attr));
+		return this->derived();
+	}
+	
+	template<class Payload>
+	Derived& operator << (const BasicConsoleTextAttrChangePrint<Payload>& attr){
+		const ConsoleTextAttr previous = this->derived().attributes();
+		this->derived() << attr.attributes << attr.string << previous;
+		return this->derived();
+	}
+	
+	Derived& operator << (ConsoleTextAttrPush attr){
+		this->stack_.push(this->derived().attributes());
+		return this->derived() << attr.attributes;
+	}
+	
+	Derived& operator << (ConsoleTextAttrPop){
+		ConsoleTextAttr restored;
+		if(this->stack_.pop(restored)) this->derived() << restored;
+		return this->derived();
+	}
+	
+	/**
+		Writes all runs of the buffer with their attributes
+	*/
+	template<std::size_t TextCapacity, std::size_t RunCapacity>
+	Derived& operator << (const BasicAttrRunBuffer<TextCapacity, RunCapacity>& runs){
+		runs.for_each([this](AttrRun run){this->derived() << run.attributes << run.text;});
+		return this->derived();
+	}
+	
+	Derived& operator << (std::string_view text){
+		this->derived().write(text);
+		return this->derived();
+	}
+	
+	Derived& operator << (const char* text){
+		this->derived().write(std::string_view(text));
+		return this->derived();
+	}
+	
+	Derived& operator << (char c){
+		this->derived().write(std::string_view(&c, 1));
+		return this->derived();
+	}
+	
+	/**
+		Formats integer and floating point numbers into the sink
+	*/
+	template<class Number, std::enable_if_t<std::is_arithmetic_v<Number> && !std::is_same_v<Number, char> && !std::is_same_v<Number, bool>, int> = 0>
+	Derived& operator << (Number number){
+		char buffer[64];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+		this->derived().write(std::string_view(buffer, static_cast<std::size_t>(result.ptr - buffer)));
+		return this->derived();
+	}
+	
+protected:
+	TextAttrStack stack_;
+	
+private:
+	Derived& derived(){return static_cast<Derived&>(*this);}
+};
+
+/// the attributes of 'Preset::Default', white text on black
+inline constexpr ConsoleTextAttr default_attributes{Attribute::foreground_red | Attribute::foreground_green | Attribute::foreground_blue};
+
+/** TextColour
+	This is used to change the foreground colour of the text.
+	Just write it in the output stream and the colour of the text will change.
+	
+	std::cout << TextColour::red << "Everything after this is in red" << std::endl;
+*/	
+
+namespace Text{	
+	inline constexpr unsigned int mask = Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_blue | Attribute::foreground_green;
+	inline constexpr ConsoleTextAttrChange black{0, mask};
+	inline constexpr ConsoleTextAttrChange blue{Attribute::foreground_blue, mask};
+	inline constexpr ConsoleTextAttrChange green{Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange aqua{Attribute::foreground_blue | Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange red{Attribute::foreground_red, mask};
+	inline constexpr ConsoleTextAttrChange purple{Attribute::foreground_red | Attribute::foreground_blue, mask};
+	inline constexpr ConsoleTextAttrChange yellow{Attribute::foreground_red | Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange white{Attribute::foreground_red | Attribute::foreground_blue | Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange grey{Attribute::foreground_intensity, mask};
+	inline constexpr ConsoleTextAttrChange light_blue{Attribute::foreground_intensity | Attribute::foreground_blue, mask};
+	inline constexpr ConsoleTextAttrChange light_green{Attribute::foreground_intensity | Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange light_aqua{Attribute::foreground_intensity | Attribute::foreground_blue | Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange light_red{Attribute::foreground_intensity | Attribute::foreground_red, mask};
+	inline constexpr ConsoleTextAttrChange light_purple{Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_blue, mask};
+	inline constexpr ConsoleTextAttrChange light_yellow{Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_green, mask};
+	inline constexpr ConsoleTextAttrChange bright_white{Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_blue | Attribute::foreground_green, mask};
+}
+
+/**
+	TextSetColour elements will when printed override all attributes, whereas TextColour elements will change the text colour and leafe all other attributes as is.
+	So for example when printed:
+	
+	std::cout << TextSetColour::red << "Text" << std::endl;
+	
+	The text will be red, the background will be set to black and all bars will be set to off. 
+	However you may compose different 'set' elements
+	
+	Since the default is black there is also no black text that can be set
+*/
+namespace TextSet{
+	inline constexpr ConsoleTextAttr blue{Attribute::foreground_blue};
+	inline constexpr ConsoleTextAttr green{Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr aqua{Attribute::foreground_blue | Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr red{Attribute::foreground_red};
+	inline constexpr ConsoleTextAttr purple{Attribute::foreground_red | Attribute::foreground_blue};
+	inline constexpr ConsoleTextAttr yellow{Attribute::foreground_red | Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr white{Attribute::foreground_red | Attribute::foreground_blue | Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr grey{Attribute::foreground_intensity};
+	inline constexpr ConsoleTextAttr light_blue{Attribute::foreground_intensity | Attribute::foreground_blue};
+	inline constexpr ConsoleTextAttr light_green{Attribute::foreground_intensity | Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr light_aqua{Attribute::foreground_intensity | Attribute::foreground_blue | Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr light_red{Attribute::foreground_intensity | Attribute::foreground_red};
+	inline constexpr ConsoleTextAttr light_purple{Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_blue};
+	inline constexpr ConsoleTextAttr light_yellow{Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_green};
+	inline constexpr ConsoleTextAttr bright_white{Attribute::foreground_intensity | Attribute::foreground_red | Attribute::foreground_blue | Attribute::foreground_green};
+}
+
+/** BackgroundColour (background colour)
+	this enum is used to change the background colour of the output stream. 
+	Every symbol that is being printed after a BackgroundColour is being printed in that colour.
+*/	
+
+namespace Background{	
+	inline constexpr unsigned int mask = Attribute::background_intensity | Attribute::background_red | Attribute::background_blue | Attribute::background_green;
+	inline constexpr ConsoleTextAttrChange black{0, mask};
+	inline constexpr ConsoleTextAttrChange blue{Attribute::background_blue, mask};
+	inline constexpr ConsoleTextAttrChange green{Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange aqua{Attribute::background_blue | Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange red{Attribute::background_red, mask};
+	inline constexpr ConsoleTextAttrChange purple{Attribute::background_red | Attribute::background_blue, mask};
+	inline constexpr ConsoleTextAttrChange yellow{Attribute::background_red | Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange white{Attribute::background_red | Attribute::background_blue | Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange grey{Attribute::background_intensity, mask};
+	inline constexpr ConsoleTextAttrChange light_blue{Attribute::background_intensity | Attribute::background_blue, mask};
+	inline constexpr ConsoleTextAttrChange light_green{Attribute::background_intensity | Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange light_aqua{Attribute::background_intensity | Attribute::background_blue | Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange light_red{Attribute::background_intensity | Attribute::background_red, mask};
+	inline constexpr ConsoleTextAttrChange light_purple{Attribute::background_intensity | Attribute::background_red | Attribute::background_blue, mask};
+	inline constexpr ConsoleTextAttrChange light_yellow{Attribute::background_intensity | Attribute::background_red | Attribute::background_green, mask};
+	inline constexpr ConsoleTextAttrChange bright_white{Attribute::background_intensity | Attribute::background_red | Attribute::background_blue | Attribute::background_green, mask};
+}
+
+namespace BackgroundSet{	
+	inline constexpr unsigned int mask = Attribute::background_intensity | Attribute::background_red | Attribute::background_blue | Attribute::background_green;
+	inline constexpr ConsoleTextAttr blue{Attribute::background_blue};
+	inline constexpr ConsoleTextAttr green{Attribute::background_green};
+	inline constexpr ConsoleTextAttr aqua{Attribute::background_blue | Attribute::background_green};
+	inline constexpr ConsoleTextAttr red{Attribute::background_red};
+	inline constexpr ConsoleTextAttr purple{Attribute::background_red | Attribute::background_blue};
+	inline constexpr ConsoleTextAttr yellow{Attribute::background_red | Attribute::background_green};
+	inline constexpr ConsoleTextAttr white{Attribute::background_red | Attribute::background_blue | Attribute::background_green};
+	inline constexpr ConsoleTextAttr grey{Attribute::background_intensity};
+	inline constexpr ConsoleTextAttr light_blue{Attribute::background_intensity | Attribute::background_blue};
+	inline constexpr ConsoleTextAttr light_green{Attribute::background_intensity | Attribute::background_green};
+	inline constexpr ConsoleTextAttr light_aqua{Attribute::background_intensity | Attribute::background_blue | Attribute::background_green};
+	inline constexpr ConsoleTextAttr light_red{Attribute::background_intensity | Attribute::background_red};
+	inline constexpr ConsoleTextAttr light_purple{Attribute::background_intensity | Attribute::background_red | Attribute::background_blue};
+	inline constexpr ConsoleTextAttr light_yellow{Attribute::background_intensity | Attribute::background_red | Attribute::background_green};
+	inline constexpr ConsoleTextAttr bright_white{Attribute::background_intensity | Attribute::background_red | Attribute::background_blue | Attribute::background_green};
+}
+
+/**
+	With the Bar one can set lines above the text, underscores, lines left of each symbol and right of each symbol
+*/
+namespace Bar{
+	inline constexpr ConsoleTextAttrChange top{Attribute::grid_horizontal, Attribute::grid_horizontal};
+	inline constexpr ConsoleTextAttrChange top_off{0, Attribute::grid_horizontal};
+	
+	inline constexpr ConsoleTextAttrChange bottom{Attribute::underscore, Attribute::underscore};
+	inline constexpr ConsoleTextAttrChange bottom_off{0, Attribute::underscore};
+	
+	inline constexpr ConsoleTextAttrChange left{Attribute::grid_lvertical, Attribute::grid_lvertical};
+	inline constexpr ConsoleTextAttrChange left_off{0, Attribute::grid_lvertical};
+	
+	inline constexpr ConsoleTextAttrChange right{Attribute::grid_rvertical, Attribute::grid_rvertical};
+	inline constexpr ConsoleTextAttrChange right_off{0, Attribute::grid_rvertical};
+	
+	inline constexpr ConsoleTextAttrChange all{Attribute::grid_horizontal | Attribute::underscore | Attribute::grid_lvertical | Attribute::grid_rvertical, Attribute::grid_horizontal | Attribute::underscore | Attribute::grid_lvertical | Attribute::grid_rvertical};
+	inline constexpr ConsoleTextAttrChange all_off{0, Attribute::grid_horizontal | Attribute::underscore | Attribute::grid_lvertical | Attribute::grid_rvertical};
+}
+
+namespace BarSet{
+	inline constexpr ConsoleTextAttr top{Attribute::grid_horizontal};
+	inline constexpr ConsoleTextAttr bottom{Attribute::underscore};
+	inline constexpr ConsoleTextAttr left{Attribute::grid_lvertical};
+	inline constexpr ConsoleTextAttr right{Attribute::grid_rvertical};
+	inline constexpr ConsoleTextAttr all{Attribute::grid_horizontal | Attribute::underscore | Attribute::grid_lvertical | Attribute::grid_rvertical};
+}
+
+namespace Invert{
+	inline constexpr ConsoleTextAttrChange on{Attribute::reverse_video, Attribute::reverse_video};
+	inline constexpr ConsoleTextAttrChange off{0, Attribute::reverse_video};
+}
+
+namespace Preset{
+	inline constexpr ConsoleTextAttr Default = TextSet::white;
+	inline constexpr ConsoleTextAttr link = TextSet::blue | BarSet::bottom;
+	inline constexpr ConsoleTextAttr active_link = TextSet::purple | BarSet::bottom;
+}
+
+static_assert(Preset::Default.value == default_attributes.value);
+
+namespace Dye{
+	template<class String> inline constexpr auto black(const String& string){return attr_print(Text::black, string);}
+	template<class String> inline constexpr auto blue(const String& string){return attr_print(Text::blue, string);}
+	template<class String> inline constexpr auto green(const String& string){return attr_print(Text::green, string);}
+	template<class String> inline constexpr auto aqua(const String& string){return attr_print(Text::aqua, string);}
+	template<class String> inline constexpr auto red(const String& string){return attr_print(Text::red, string);}
+	template<class String> inline constexpr auto purple(const String& string){return attr_print(Text::purple, string);}
+	template<class String> inline constexpr auto yellow(const String& string){return attr_print(Text::yellow, string);}
+	template<class String> inline constexpr auto white(const String& string){return attr_print(Text::white, string);}
+	template<class String> inline constexpr auto grey(const String& string){return attr_print(Text::grey, string);}
+	template<class String> inline constexpr auto light_blue(const String& string){return attr_print(Text::light_blue, string);}
+	template<class String> inline constexpr auto light_green(const String& string){return attr_print(Text::light_green, string);}
+	template<class String> inline constexpr auto light_aqua(const String& string){return attr_print(Text::light_aqua, string);}
+	template<class String> inline constexpr auto light_red(const String& string){return attr_print(Text::light_red, string);}
+	template<class String> inline constexpr auto light_purple(const String& string){return attr_print(Text::light_purple, string);}
+	template<class String> inline constexpr auto light_yellow(const String& string){return attr_print(Text::light_yellow, string);}
+	template<class String> inline constexpr auto bright_white(const String& string){return attr_print(Text::bright_white, string);}
+}
+
+namespace Mark{
+	template<class String> inline constexpr auto black(const String& string){return attr_print(Background::black, string);}
+	template<class String> inline constexpr auto blue(const String& string){return attr_print(Background::blue, string);}
+	template<class String> inline constexpr auto green(const String& string){return attr_print(Background::green, string);}
+	template<class String> inline constexpr auto aqua(const String& string){return attr_print(Background::aqua, string);}
+	template<class String> inline constexpr auto red(const String& string){return attr_print(Background::red, string);}
+	template<class String> inline constexpr auto purple(const String& string){return attr_print(Background::purple, string);}
+	template<class String> inline constexpr auto yellow(const String& string){return attr_print(Background::yellow, string);}
+	template<class String> inline constexpr auto white(const String& string){return attr_print(Background::white, string);}
+	template<class String> inline constexpr auto grey(const String& string){return attr_print(Background::grey, string);}
+	template<class String> inline constexpr auto light_blue(const String& string){return attr_print(Background::light_blue, string);}
+	template<class String> inline constexpr auto light_green(const String& string){return attr_print(Background::light_green, string);}
+	template<class String> inline constexpr auto light_aqua(const String& string){return attr_print(Background::light_aqua, string);}
+	template<class String> inline constexpr auto light_red(const String& string){return attr_print(Background::light_red, string);}
+	template<class String> inline constexpr auto light_purple(const String& string){return attr_print(Background::light_purple, string);}
+	template<class String> inline constexpr auto light_yellow(const String& string){return attr_print(Background::light_yellow, string);}
+	template<class String> inline constexpr auto bright_white(const String& string){return attr_print(Background::bright_white, string);}
+}
+
+template<class String> inline constexpr auto Underline(const String& string){return attr_print(Bar::bottom, string);}
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_CORE_H
@@ -0,0 +1,505 @@
+/*
+	Description
+	-----------
+
+	Extended colours: xterm-256 palette colours and 24-bit RGB colours.
+
+	The extended attributes are packed into a single 64-bit word with a foreground field, a background field
+	and the flags of the console attributes. They compose with the '|' operator just like the attributes
+	of the namespaces 'Text', 'Background', 'Bar' and 'Invert', also with those, and everything is 'constexpr':
+
+	```C++
+	std::cout << Text::rgb(255, 128, 0) << "orange " << (Text::palette(196) | Background::rgb(20, 20, 40) | Bar::bottom) << "red on navy" << std::endl;
+	```
+
+	With the virtual terminal backend the shortest valid escape sequence is written:
+		- the first 16 palette colours as the classic 30-37 / 90-97 and 40-47 / 100-107 codes
+		- RGB colours that are exactly part of the 256 colour palette as '38;5;n'
+		- all other RGB colours as '38;2;r;g;b'
+
+	With the win32 backend and in the attribute sinks, which only know the 16 console colours,
+	the extended colours are mapped to the nearest console colour through lookup tables
+	that have been generated at compile time, so there is no distance search at runtime.
+	RGB colours are looked up in a table of the nearest console colour of every colour of a 32x32x32 grid.
+	That table has 32KB and is evaluated by the compiler in every translation unit that includes this header,
+	on MSVC the constexpr step limit may have to be raised with '/constexpr:steps'.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_EXTENDED_H
+#define OMEGA_COLOR_CONSOLE_EXTENDED_H
+
+#include "colour_console.h"
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/** Colour
+	The encoding of a single extended colour in 26 bits:
+	the kind of the colour in the bits 24 and 25 and the colour itself in the lower 24 bits.
+*/
+namespace Colour{
+	inline constexpr std::uint32_t kind_mask = 0x3000000;
+	inline constexpr std::uint32_t legacy = 0x0000000;		///< one of the 16 console colours, as the 4 windows colour bits
+	inline constexpr std::uint32_t palette = 0x1000000;		///< an index into the xterm-256 palette
+	inline constexpr std::uint32_t rgb = 0x2000000;			///< a 24-bit colour as 0xRRGGBB
+	inline constexpr std::uint32_t value_mask = 0x0FFFFFF;
+
+	inline constexpr std::uint32_t make_legacy(unsigned int colour){return legacy | (colour & 0xF);}
+	inline constexpr std::uint32_t make_palette(std::uint8_t index){return palette | index;}
+	inline constexpr std::uint32_t make_rgb(std::uint8_t red, std::uint8_t green, std::uint8_t blue){
+		return rgb | (static_cast<std::uint32_t>(red) << 16) | (static_cast<std::uint32_t>(green) << 8) | blue;
+	}
+
+	inline constexpr std::uint32_t kind(std::uint32_t colour){return colour & kind_mask;}
+	inline constexpr std::uint32_t value(std::uint32_t colour){return colour & value_mask;}
+}
+
+/** ExtendedAttribute
+	The fields of the packed 64-bit extended attributes
+*/
+namespace ExtendedAttribute{
+	inline constexpr unsigned int foreground_shift = 0;
+	inline constexpr unsigned int background_shift = 26;
+	inline constexpr unsigned int flags_shift = 52;
+
+	inline constexpr std::uint64_t foreground = 0x3FFFFFFull << foreground_shift;
+	inline constexpr std::uint64_t background = 0x3FFFFFFull << background_shift;
+	/// the flags are the upper byte of the console attributes (bars, reverse video and underscore)
+	inline constexpr std::uint64_t flags = 0xFFull << flags_shift;
+	inline constexpr std::uint64_t all = foreground | background | flags;
+}
+
+/**ExtendedTextAttr
+	Used to set specific extended attributes, all other attributes will be reset when printed.
+*/
+struct ExtendedTextAttr{
+	std::uint64_t value = 0;
+
+	constexpr std::uint32_t foreground() const {return static_cast<std::uint32_t>((value & ExtendedAttribute::foreground) >> ExtendedAttribute::foreground_shift);}
+	constexpr std::uint32_t background() const {return static_cast<std::uint32_t>((value & ExtendedAttribute::background) >> ExtendedAttribute::background_shift);}
+	constexpr unsigned int flags() const {return static_cast<unsigned int>((value & ExtendedAttribute::flags) >> ExtendedAttribute::flags_shift) << 8;}
+};
+
+/**ExtendedTextAttrChange
+	Used to change a specific set of extended attributes, all other attributes will reman as they were before.
+	The colours are always changed as a whole, the flags bit by bit.
+*/
+struct ExtendedTextAttrChange{
+	std::uint64_t value = 0;
+	std::uint64_t mask = 0;
+};
+
+inline constexpr ExtendedTextAttr make_extended(std::uint32_t foreground, std::uint32_t background, unsigned int flags = 0){
+	return ExtendedTextAttr{
+		(static_cast<std::uint64_t>(foreground) << ExtendedAttribute::foreground_shift)
+		| (static_cast<std::uint64_t>(background) << ExtendedAttribute::background_shift)
+		| (static_cast<std::uint64_t>((flags >> 8) & 0xFF) << ExtendedAttribute::flags_shift)};
+}
+
+/**
+	Converts the console attributes into extended attributes
+*/
+inline constexpr ExtendedTextAttr extend(ConsoleTextAttr attributes){
+	return make_extended(Colour::make_legacy(attributes.value & Attribute::foreground), Colour::make_legacy((attributes.value & Attribute::background) >> 4), attributes.value);
+}
+
+/**
+	Converts a change of the console attributes into a change of extended attributes.
+	A colour that is touched by the mask is replaced as a whole, like all constants of this library do.
+*/
+inline constexpr ExtendedTextAttrChange extend(ConsoleTextAttrChange change){
+	std::uint64_t mask = static_cast<std::uint64_t>((change.mask >> 8) & 0xFF) << ExtendedAttribute::flags_shift;
+	if(change.mask & Attribute::foreground) mask |= ExtendedAttribute::foreground;
+	if(change.mask & Attribute::background) mask |= ExtendedAttribute::background;
+	return ExtendedTextAttrChange{extend(ConsoleTextAttr{change.value & change.mask}).value & mask, mask};
+}
+
+/**
+	Composes two colours of the same field like the console attributes do:
+	two console colours are combined bit by bit, otherwise the right colour replaces the left one as a whole,
+	unless it is the empty console colour 0, which leaves the left one as it is
+*/
+inline constexpr std::uint32_t compose_colour(std::uint32_t lhs, std::uint32_t rhs){
+	if(rhs == 0) return lhs;
+	if(Colour::kind(lhs) == Colour::legacy && Colour::kind(rhs) == Colour::legacy) return lhs | rhs;
+	return rhs;
+}
+
+/**
+	Composes the attributes field by field, the flags are combined bit by bit, see 'compose_colour()' for the colours
+*/
+inline constexpr ExtendedTextAttr operator | (ExtendedTextAttr lhs, ExtendedTextAttr rhs){
+	return ExtendedTextAttr{
+		(static_cast<std::uint64_t>(compose_colour(lhs.foreground(), rhs.foreground())) << ExtendedAttribute::foreground_shift)
+		| (static_cast<std::uint64_t>(compose_colour(lhs.background(), rhs.background())) << ExtendedAttribute::background_shift)
+		| ((lhs.value | rhs.value) & ExtendedAttribute::flags)};
+}
+
+inline constexpr ExtendedTextAttr operator | (ExtendedTextAttr lhs, ConsoleTextAttr rhs){return lhs | extend(rhs);}
+inline constexpr ExtendedTextAttr operator | (ConsoleTextAttr lhs, ExtendedTextAttr rhs){return extend(lhs) | rhs;}
+
+inline constexpr ExtendedTextAttrChange operator | (ExtendedTextAttrChange lhs, ExtendedTextAttrChange rhs){
+	return ExtendedTextAttrChange{(lhs.value & ~rhs.mask) | (rhs.value & rhs.mask), lhs.mask | rhs.mask};
+}
+
+inline constexpr ExtendedTextAttrChange operator | (ExtendedTextAttrChange lhs, ConsoleTextAttrChange rhs){return lhs | extend(rhs);}
+inline constexpr ExtendedTextAttrChange operator | (ConsoleTextAttrChange lhs, ExtendedTextAttrChange rhs){return extend(lhs) | rhs;}
+
+/**
+	Returns the attributes that result from applying the change to the given attributes
+*/
+inline constexpr ExtendedTextAttr apply_change(ExtendedTextAttr attributes, ExtendedTextAttrChange change){
+	return ExtendedTextAttr{(attributes.value & ~change.mask) | (change.value & change.mask)};
+}
+
+/** quantise
+	Mapping of the extended colours to the 16 console colours.
+	The tables are generated at compile time with a nearest colour search, at runtime they are plain lookups.
+*/
+namespace quantise{
+
+	struct Rgb{
+		std::uint8_t red = 0;
+		std::uint8_t green = 0;
+		std::uint8_t blue = 0;
+	};
+
+	/// the levels of the 6x6x6 colour cube of the xterm-256 palette
+	inline constexpr std::uint8_t cube_levels[6] = {0, 95, 135, 175, 215, 255};
+
+	/// the colours of the classic console palette, indexed by the 4 windows colour bits
+	inline constexpr Rgb console_palette[16] = {
+		{0, 0, 0}, {0, 0, 128}, {0, 128, 0}, {0, 128, 128}, {128, 0, 0}, {128, 0, 128}, {128, 128, 0}, {192, 192, 192},
+		{128, 128, 128}, {0, 0, 255}, {0, 255, 0}, {0, 255, 255}, {255, 0, 0}, {255, 0, 255}, {255, 255, 0}, {255, 255, 255}};
+
+	/// returns the colour of the xterm-256 palette entry, the first 16 are the xterm defaults
+	inline constexpr Rgb palette_rgb(unsigned int index){
+		constexpr Rgb system[16] = {
+			{0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0}, {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+			{127, 127, 127}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0}, {92, 92, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255}};
+		if(index < 16) return system[index];
+		if(index < 232){
+			const unsigned int cube = index - 16;
+			return Rgb{cube_levels[cube / 36], cube_levels[(cube / 6) % 6], cube_levels[cube % 6]};
+		}
+		const std::uint8_t grey = static_cast<std::uint8_t>(8 + 10 * (index - 232));
+		return Rgb{grey, grey, grey};
+	}
+
+	inline constexpr unsigned int distance(Rgb lhs, Rgb rhs){
+		const int red = int(lhs.red) - int(rhs.red);
+		const int green = int(lhs.green) - int(rhs.green);
+		const int blue = int(lhs.blue) - int(rhs.blue);
+		return static_cast<unsigned int>(red * red + green * green + blue * blue);
+	}
+
+	/// returns the 4 windows colour bits of the console colour that is nearest to the given colour, only meant for compile time
+	inline constexpr unsigned int nearest_console_colour(Rgb colour){
+		unsigned int best = 0;
+		unsigned int best_distance = distance(colour, console_palette[0]);
+		for(unsigned int candidate = 1; candidate < 16; ++candidate){
+			const unsigned int candidate_distance = distance(colour, console_palette[candidate]);
+			if(candidate_distance < best_distance){
+				best = candidate;
+				best_distance = candidate_distance;
+			}
+		}
+		return best;
+	}
+
+	/// the number of bits of each channel that select the entry of the table
+	inline constexpr unsigned int table_bits = 5;
+	inline constexpr std::size_t table_size = std::size_t(1) << (3 * table_bits);
+
+	/**RgbTable
+		The nearest console colour (4 windows colour bits) of every colour of the grid,
+		with 3 bytes of padding so that the entries can be gathered as 32-bit values
+	*/
+	struct RgbTable{
+		std::uint8_t entries[table_size + 3] = {};
+
+		constexpr unsigned int operator[](std::size_t index) const {return entries[index];}
+	};
+
+	inline constexpr RgbTable make_rgb_table(){
+		RgbTable table;
+		constexpr unsigned int levels = 1u << table_bits;
+		constexpr unsigned int half = 1u << (7 - table_bits);
+		// |colour - candidate|^2 = |colour|^2 + (|candidate|^2 - 2 colour * candidate), the first term is the same for all candidates,
+		// the second is linear in each channel, so the search per entry only needs one multiplication per candidate
+		for(unsigned int red = 0; red < levels; ++red){
+			for(unsigned int green = 0; green < levels; ++green){
+				// every entry stands for the centre of its cell of the grid
+				const int r = static_cast<int>((red << (8 - table_bits)) | half);
+				const int g = static_cast<int>((green << (8 - table_bits)) | half);
+				int base[16] = {};
+				for(unsigned int candidate = 0; candidate < 16; ++candidate){
+					const Rgb c = console_palette[candidate];
+					base[candidate] = c.red * c.red + c.green * c.green + c.blue * c.blue - 2 * (r * c.red + g * c.green);
+				}
+				for(unsigned int blue = 0; blue < levels; ++blue){
+					const int b = static_cast<int>((blue << (8 - table_bits)) | half);
+					unsigned int best = 0;
+					int best_score = base[0] - 2 * b * console_palette[0].blue;
+					for(unsigned int candidate = 1; candidate < 16; ++candidate){
+						const int score = base[candidate] - 2 * b * console_palette[candidate].blue;
+						if(score < best_score){
+							best = candidate;
+							best_score = score;
+						}
+					}
+					table.entries[(red << (2 * table_bits)) | (green << table_bits) | blue] = static_cast<std::uint8_t>(best);
+				}
+			}
+		}
+		return table;
+	}
+
+	inline constexpr RgbTable rgb_table = make_rgb_table();
+
+	/**
+		Returns the index of the entry of the table for a colour given as 0xRRGGBB
+	*/
+	inline constexpr std::uint32_t table_index(std::uint32_t rgb){
+		return ((rgb >> 9) & 0x7C00) | ((rgb >> 6) & 0x03E0) | ((rgb >> 3) & 0x001F);
+	}
+
+	/**
+		Returns the 4 windows colour bits of the console colour that is nearest to the colour given as 0xRRGGBB
+	*/
+	inline constexpr unsigned int nearest(std::uint32_t rgb){
+		return rgb_table[table_index(rgb)];
+	}
+
+	/**PaletteTable
+		The nearest console colour of every entry of the xterm-256 palette
+	*/
+	struct PaletteTable{
+		std::uint8_t entries[256] = {};
+
+		constexpr unsigned int operator[](std::uint8_t index) const {return entries[index];}
+	};
+
+	inline constexpr PaletteTable make_palette_table(){
+		PaletteTable table;
+		for(unsigned int index = 0; index < 256; ++index){
+			// the first 16 entries are the ANSI colours, which have an exact console colour
+			table.entries[index] = static_cast<std::uint8_t>((index < 16)
+				? (vt::ansi_colour_index(index & 0x7) | (index & 0x8))
+				: nearest_console_colour(palette_rgb(index)));
+		}
+		return table;
+	}
+
+	inline constexpr PaletteTable palette_to_console = make_palette_table();
+
+	/// returns the level of the colour cube that is nearest to the channel value
+	inline constexpr unsigned int cube_level(std::uint8_t channel){
+		return (channel < 48) ? 0 : (channel < 115) ? 1 : (channel - 35) / 40;
+	}
+
+	/// returns the index of the entry of the colour cube of the xterm-256 palette that is nearest to the colour
+	inline constexpr std::uint8_t cube_index(std::uint8_t red, std::uint8_t green, std::uint8_t blue){
+		return static_cast<std::uint8_t>(16 + 36 * cube_level(red) + 6 * cube_level(green) + cube_level(blue));
+	}
+
+	/**
+		Returns the 4 windows colour bits of the console colour that is nearest to the extended colour
+	*/
+	inline constexpr unsigned int to_console(std::uint32_t colour){
+		const std::uint32_t value = Colour::value(colour);
+		switch(Colour::kind(colour)){
+			case Colour::palette:
+				return palette_to_console[static_cast<std::uint8_t>(value)];
+			case Colour::rgb:
+				return nearest(value);
+			default:
+				return value & 0xF;
+		}
+	}
+
+	/**
+		Returns the xterm-256 palette index that represents the RGB colour exactly, or -1 if there is none
+	*/
+	inline constexpr int exact_palette_index(std::uint32_t rgb){
+		const std::uint8_t red = static_cast<std::uint8_t>(rgb >> 16);
+		const std::uint8_t green = static_cast<std::uint8_t>(rgb >> 8);
+		const std::uint8_t blue = static_cast<std::uint8_t>(rgb);
+		const std::uint8_t cube = cube_index(red, green, blue);
+		const Rgb cube_colour = palette_rgb(cube);
+		if(cube_colour.red == red && cube_colour.green == green && cube_colour.blue == blue) return cube;
+		if(red == green && green == blue && red >= 8 && red <= 238 && (red - 8) % 10 == 0) return 232 + (red - 8) / 10;
+		return -1;
+	}
+
+}//namespace quantise
+
+/**
+	Returns the console attributes that are nearest to the extended attributes
+*/
+inline constexpr ConsoleTextAttr to_console(ExtendedTextAttr attributes){
+	return ConsoleTextAttr{quantise::to_console(attributes.foreground()) | (quantise::to_console(attributes.background()) << 4) | attributes.flags()};
+}
+
+/**
+	Returns the change of the console attributes that is nearest to the change of the extended attributes
+*/
+inline constexpr ConsoleTextAttrChange to_console(ExtendedTextAttrChange change){
+	unsigned int mask = static_cast<unsigned int>((change.mask & ExtendedAttribute::flags) >> ExtendedAttribute::flags_shift) << 8;
+	if(change.mask & ExtendedAttribute::foreground) mask |= Attribute::foreground;
+	if(change.mask & ExtendedAttribute::background) mask |= Attribute::background;
+	return ConsoleTextAttrChange{to_console(ExtendedTextAttr{change.value & change.mask}).value & mask, mask};
+}
+
+namespace vt{
+
+	/// appends the parameters of an extended colour, 'base' is 30 for the foreground and 40 for the background
+	inline constexpr void append_colour(Sgr& sgr, std::uint32_t colour, unsigned int base){
+		const std::uint32_t value = Colour::value(colour);
+		switch(Colour::kind(colour)){
+			case Colour::palette:
+				if(value < 16){
+					// the ANSI colours are shorter as classic codes
+					append(sgr, make_code(((value & 0x8) ? base + 60 : base) + (value & 0x7)));
+				}else{
+					append(sgr, make_code(base + 8));
+					append(sgr, make_code(5));
+					append(sgr, make_code(value));
+				}
+				break;
+			case Colour::rgb:{
+				const int index = quantise::exact_palette_index(value);
+				append(sgr, make_code(base + 8));
+				if(index >= 0){
+					append(sgr, make_code(5));
+					append(sgr, make_code(static_cast<unsigned int>(index)));
+				}else{
+					append(sgr, make_code(2));
+					append(sgr, make_code((value >> 16) & 0xFF));
+					append(sgr, make_code((value >> 8) & 0xFF));
+					append(sgr, make_code(value & 0xFF));
+				}
+			}break;
+			default:
+				append(sgr, (base == 30) ? foreground_codes[value & 0xF] : background_codes[value & 0xF]);
+				break;
+		}
+	}
+
+	/// appends the parameters of all fields that are touched by the mask, the field values are taken from the attributes
+	inline constexpr void append_fields(Sgr& sgr, ExtendedTextAttr attributes, std::uint64_t mask){
+		if(mask & ExtendedAttribute::foreground) append_colour(sgr, attributes.foreground(), 30);
+		if(mask & ExtendedAttribute::background) append_colour(sgr, attributes.background(), 40);
+		const unsigned int flag_mask = static_cast<unsigned int>((mask & ExtendedAttribute::flags) >> ExtendedAttribute::flags_shift) << 8;
+		append_fields(sgr, ConsoleTextAttr{attributes.flags()}, flag_mask & ~(Attribute::foreground | Attribute::background));
+	}
+
+	/**
+		Returns the escape sequence that sets exactly the given extended attributes
+	*/
+	inline constexpr Sgr sgr(ExtendedTextAttr attributes){
+		Sgr result;
+		append(result, reset_code);
+		append_fields(result, attributes, ExtendedAttribute::foreground | ExtendedAttribute::background);
+		append_fields(result, ConsoleTextAttr{attributes.flags()}, attributes.flags() & (Attribute::underscore | Attribute::reverse_video | Attribute::grid_horizontal));
+		return finish(result);
+	}
+
+	/**
+		Returns the escape sequence that writes all fields touched by the mask with the values from 'resolved'
+	*/
+	inline constexpr Sgr sgr(ExtendedTextAttr resolved, std::uint64_t mask){
+		Sgr result;
+		append_fields(result, resolved, mask);
+		return finish(result);
+	}
+
+	/**
+		Returns the escape sequence of the change, it does not depend on the current attributes
+	*/
+	inline constexpr Sgr sgr(ExtendedTextAttrChange change){
+		return sgr(ExtendedTextAttr{change.value & change.mask}, change.mask);
+	}
+
+}//namespace vt
+
+/**
+	Set the extended attributes within the stream.
+	With the virtual terminal backend the escape sequence is written into the stream,
+	otherwise the nearest console attributes are set.
+*/
+template<class OStream, enable_if_stream_t<OStream> = 0>
+OStream& operator << (OStream& stream, ExtendedTextAttr attr){
+	if(AttrState* state = attr_state(stream)){
+		state->set_attributes(to_console(attr));
+		return stream;
+	}
+	ConsoleState& console = console_state();
+	if(console.backend() == Backend::vt){
+		stream << vt::sgr(attr).view();
+		// the shadow copy only approximates the extended colours
+		console.track(to_console(attr));
+		console.invalidate();
+	}else{
+		console.set(to_console(attr));
+	}
+	return stream;
+}
+
+/**
+	Change the extended attributes within the stream.
+	With the virtual terminal backend the escape sequence is written into the stream,
+	otherwise the nearest console attributes are changed.
+*/
+template<class OStream, enable_if_stream_t<OStream> = 0>
+OStream& operator << (OStream& stream, ExtendedTextAttrChange attr){
+	if(AttrState* state = attr_state(stream)){
+		state->change(to_console(attr));
+		return stream;
+	}
+	ConsoleState& console = console_state();
+	if(console.backend() == Backend::vt){
+		stream << vt::sgr(attr).view();
+		console.track(apply_change(console.attributes(), to_console(attr)));
+		console.invalidate();
+	}else{
+		console.change(to_console(attr));
+	}
+	return stream;
+}
+
+/**
+	The attribute sinks only know the console colours, they get the nearest ones
+*/
+template<class Sink, std::enable_if_t<is_attribute_sink<Sink>::value, int> = 0>
+Sink& operator << (Sink& sink, ExtendedTextAttr attr){
+	return sink << to_console(attr);
+}
+
+template<class Sink, std::enable_if_t<is_attribute_sink<Sink>::value, int> = 0>
+Sink& operator << (Sink& sink, ExtendedTextAttrChange attr){
+	return sink << to_console(attr);
+}
+
+namespace Text{
+	inline constexpr ExtendedTextAttrChange rgb(std::uint8_t red, std::uint8_t green, std::uint8_t blue){
+		return ExtendedTextAttrChange{static_cast<std::uint64_t>(Colour::make_rgb(red, green, blue)) << ExtendedAttribute::foreground_shift, ExtendedAttribute::foreground};
+	}
+
+	inline constexpr ExtendedTextAttrChange palette(std::uint8_t index){
+		return ExtendedTextAttrChange{static_cast<std::uint64_t>(Colour::make_palette(index)) << ExtendedAttribute::foreground_shift, ExtendedAttribute::foreground};
+	}
+}
+
+namespace Background{
+	inline constexpr ExtendedTextAttrChange rgb(std::uint8_t red, std::uint8_t green, std::uint8_t blue){
+		return ExtendedTextAttrChange{static_cast<std::uint64_t>(Colour::make_rgb(red, green, blue)) << ExtendedAttribute::background_shift, ExtendedAttribute::background};
+	}
+
+	inline constexpr ExtendedTextAttrChange palette(std::uint8_t index){
+		return ExtendedTextAttrChange{static_cast<std::uint64_t>(Colour::make_palette(index)) << ExtendedAttribute::background_shift, ExtendedAttribute::background};
+	}
+}
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_EXTENDED_H
@@ -0,0 +1,403 @@
+/*
+	Description
+	-----------
+
+	A live region of lines at the bottom of the console, for example one progress line per parallel job,
+	with ordinary log output scrolling above it.
+
+	```C++
+	static cc::LiveRegion region;	// 8 lines
+
+	// from any thread, as often as needed
+	region.line(job) << "job " << job << ' ' << cc::ProgressBar{done, 40} << ' ' << Dye::light_green(percent) << '%';
+
+	// log output is printed above the region
+	region.log() << Text::red << "error: " << Preset::Default << "job " << job << " failed\n";
+	```
+
+	Updating a line only formats the new content into a buffer of that line and publishes it with one atomic exchange.
+	A drawing thread brings the changes to the console at most once per frame interval,
+	so updates hundreds of times per second do not saturate the console and intermediate states are skipped.
+	Only the lines that changed since the last frame are redrawn.
+
+	Logged lines are queued like the records of the 'Logger' and printed above the region at the next frame,
+	the region is then drawn again below them.
+
+	With the virtual terminal backend a frame is written with one call, lines that are wider than the console
+	are cut off instead of wrapping. With the win32 backend the lines are positioned with 'SetConsoleCursorPosition',
+	there the lines have to be shorter than the console is wide.
+	If the output is redirected only the logged lines are written while the region exists
+	and the lines of the region once at the end.
+
+	The region should start at the beginning of a line and all other output should go through 'log()' while it exists.
+	No dynamic memory is used, so the region is quite large and should have static storage duration.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_LIVE_H
+#define OMEGA_COLOR_CONSOLE_LIVE_H
+
+#include "colour_console.h"
+#ifdef _WIN32
+	#include "colour_console_win32.h"
+#endif
+#include "colour_console_logger.h"
+#include "colour_console_region.h"
+
+//std
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**ProgressBar
+	A bar of 'width' cells, the done part is printed with 'done' and the rest with 'remaining'.
+	The bar is made of spaces, so the changes should set the background colour.
+*/
+struct ProgressBar{
+	double fraction = 0.0;
+	std::size_t width = 20;
+	ConsoleTextAttrChange done = Background::green;
+	ConsoleTextAttrChange remaining = Background::grey;
+};
+
+template<class Derived>
+inline Derived& operator << (AttrSink<Derived>& sink, const ProgressBar& bar){
+	constexpr std::string_view spaces = "                                ";
+	const double fraction = (bar.fraction < 0.0) ? 0.0 : (bar.fraction > 1.0) ? 1.0 : bar.fraction;
+	const std::size_t done = static_cast<std::size_t>(fraction * static_cast<double>(bar.width) + 0.5);
+	Derived& out = static_cast<Derived&>(sink);
+	const auto write_spaces = [&](std::size_t count){
+		for(; count > spaces.size(); count -= spaces.size()) out << spaces;
+		out << spaces.substr(0, count);
+	};
+	out << push(bar.done);
+	write_spaces(done);
+	out << pop << push(bar.remaining);
+	write_spaces(bar.width - done);
+	return out << pop;
+}
+
+/** LiveRegionOptions
+	The configuration of a live region
+*/
+struct LiveRegionOptions{
+	/// the minimal time between two frames
+	std::chrono::milliseconds frame_interval{50};
+
+	/// what logging threads do when the queue of logged lines is full
+	OverflowPolicy overflow = OverflowPolicy::block;
+};
+
+/**BasicLiveRegion
+	Owns 'Lines' lines at the bottom of the console.
+	Each line holds up to 'LineTextCapacity' bytes of text in up to 'LineRunCapacity' runs, text that does not fit is dropped.
+	Up to 'LogQueueCapacity' logged lines can be queued between two frames, it has to be a power of two.
+
+	Every line is triple buffered: the updating thread formats into the back buffer and swaps it with the middle one,
+	the drawing thread swaps the middle buffer with the front one if it has been updated.
+	Threads that update different lines never wait for each other, updates of the same line are serialised
+	by a short spin lock of that line. The drawing thread never takes it.
+*/
+template<std::size_t Lines, std::size_t LineTextCapacity = 256, std::size_t LineRunCapacity = 16, std::size_t LogQueueCapacity = 256>
+class BasicLiveRegion{
+	static_assert(Lines >= 1, "the region needs at least one line");
+
+public:
+	using Content = BasicAttrRunBuffer<LineTextCapacity, LineRunCapacity>;
+	using LogRecord = BasicAttrRunBuffer<512, 32>;
+	using LogQueue = BasicRecordQueue<LogRecord, LogQueueCapacity>;
+
+	/**Line
+		The sink that formats the new content of a line, the content is shown when the sink is destroyed.
+		The attributes start with the attributes of the console from when the region has been constructed.
+	*/
+	class Line : public AttrSink<Line>{
+	public:
+		Line(BasicLiveRegion& region, std::size_t index)
+			: slot_(region.slots_[(index < Lines) ? index : Lines - 1])
+			, attributes_(region.base_attributes_){
+			while(this->slot_.writing.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+			this->content_ = &this->slot_.buffers[this->slot_.back];
+			this->content_->clear();
+		}
+
+		Line(const Line&) = delete;
+		Line& operator = (const Line&) = delete;
+
+		~Line(){
+			this->slot_.back = this->slot_.middle.exchange(static_cast<unsigned char>(this->slot_.back | Slot::fresh), std::memory_order_acq_rel) & Slot::index;
+			this->slot_.writing.clear(std::memory_order_release);
+		}
+
+		ConsoleTextAttr attributes() const {return this->attributes_;}
+
+		void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+		void write(std::string_view text){this->content_->append(this->attributes_, text);}
+
+	private:
+		typename BasicLiveRegion::Slot& slot_;
+		Content* content_ = nullptr;
+		ConsoleTextAttr attributes_;
+	};
+
+	/**Log
+		The sink that formats a logged line into a record of its own, it is queued when the sink is destroyed
+		and printed above the region. The attributes of each thread are kept from line to line.
+	*/
+	using Log = BasicRecordSink<LogQueue>;
+
+	explicit BasicLiveRegion(LiveRegionOptions options = LiveRegionOptions(), ConsoleState& console = console_state())
+		: options_(options)
+		, console_(console)
+		, base_attributes_(console.attributes())
+		, queue_(options.overflow)
+		, writer_(console)
+		, drawer_([this]{this->draw();}){}
+
+	BasicLiveRegion(const BasicLiveRegion&) = delete;
+	BasicLiveRegion& operator = (const BasicLiveRegion&) = delete;
+
+	/**
+		Draws the last frame and leaves the cursor on the line below the region
+	*/
+	~BasicLiveRegion(){
+		this->running_.store(false, std::memory_order_release);
+		this->drawer_.join();
+	}
+
+	/**
+		Returns the sink for the new content of the line with the given index, may be called from any thread
+	*/
+	Line line(std::size_t index){return Line(*this, index);}
+
+	/**
+		Returns the sink for a line that is printed above the region, may be called from any thread
+	*/
+	Log log(){
+		return Log(this->queue_, this->id_, this->base_attributes_);
+	}
+
+	static constexpr std::size_t lines(){return Lines;}
+
+	/**
+		Returns how many frames have been drawn
+	*/
+	std::uint64_t frames() const {return this->frames_.load(std::memory_order_relaxed);}
+
+	/**
+		Returns how many logged lines have been dropped because the queue was full
+	*/
+	std::uint64_t dropped() const {return this->queue_.dropped();}
+
+	const LiveRegionOptions& options() const {return this->options_;}
+
+private:
+	struct Slot{
+		static constexpr unsigned char index = 0x03;
+		static constexpr unsigned char fresh = 0x04;
+
+		Content buffers[3];
+		std::atomic<unsigned char> middle{1};
+		unsigned char back = 0;		///< owned by the thread that holds 'writing'
+		unsigned char front = 2;	///< owned by the drawing thread
+		std::atomic_flag writing = ATOMIC_FLAG_INIT;
+	};
+
+	void draw(){
+		using Clock = std::chrono::steady_clock;
+		constexpr auto poll = std::chrono::milliseconds(5);
+
+		Clock::time_point next = Clock::now();
+		while(this->running_.load(std::memory_order_acquire)){
+			const Clock::time_point now = Clock::now();
+			if(now < next){
+				// sleep in short steps, so the destruction does not wait for a whole frame interval
+				std::this_thread::sleep_for(std::min<Clock::duration>(next - now, poll));
+				continue;
+			}
+			this->draw_frame();
+			next = std::max(next + this->options_.frame_interval, now);
+		}
+		this->draw_frame();
+		this->finish();
+	}
+
+	/// takes the updated lines and the logged lines and brings them to the console
+	void draw_frame(){
+		bool changed[Lines] = {};
+		bool any = false;
+		for(std::size_t i = 0; i < Lines; ++i){
+			Slot& slot = this->slots_[i];
+			if(slot.middle.load(std::memory_order_relaxed) & Slot::fresh){
+				slot.front = slot.middle.exchange(slot.front, std::memory_order_acq_rel) & Slot::index;
+				changed[i] = true;
+				any = true;
+			}
+		}
+		const bool logged = !this->queue_.empty();
+		if(!any && !logged && this->drawn_) return;
+
+		switch(this->console_.backend()){
+			case Backend::none:
+				this->write_logged();
+				break;
+			case Backend::vt:
+				this->draw_vt(changed, logged || !this->drawn_);
+				break;
+			case Backend::win32:
+				this->draw_win32(changed, logged || !this->drawn_);
+				break;
+		}
+		this->writer_.flush();
+		this->drawn_ = true;
+		this->frames_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// writes all queued logged lines, each ends with a line break
+	void write_logged(){
+		while(this->queue_.try_pop([this](LogRecord& record){
+			bool line_break = false;
+			record.for_each([&](AttrRun run){line_break = !run.text.empty() && run.text.back() == '\n';});
+			this->writer_ << record;
+			if(!line_break) this->writer_ << this->base_attributes_ << '\n';
+		})){}
+	}
+
+	void write_line(std::size_t index){
+		this->writer_ << this->slots_[index].buffers[this->slots_[index].front] << this->base_attributes_;
+	}
+
+	/**
+		The cursor stays in the region line 'cursor_line_' and is moved relatively,
+		so the region moves up together with the rest of the screen when the output scrolls
+	*/
+	void draw_vt(const bool (&changed)[Lines], bool full){
+		if(full){
+			if(this->drawn_){
+				this->writer_ << this->base_attributes_;
+				this->move_vt(0);
+				this->writer_.write("\x1b[J");
+			}
+			this->write_logged();
+			for(std::size_t i = 0; i < Lines; ++i){
+				this->writer_.write("\x1b[?7l");
+				this->write_line(i);
+				this->writer_.write((i + 1 < Lines) ? "\x1b[?7h\n" : "\x1b[?7h");
+			}
+			this->cursor_line_ = Lines - 1;
+			return;
+		}
+		for(std::size_t i = 0; i < Lines; ++i){
+			if(!changed[i]) continue;
+			this->writer_ << this->base_attributes_;
+			this->move_vt(i);
+			this->writer_.write("\x1b[2K" "\x1b[?7l");
+			this->write_line(i);
+			this->writer_.write("\x1b[?7h");
+		}
+	}
+
+	/// moves the cursor to the beginning of the region line 'line'
+	void move_vt(std::size_t line){
+		char buffer[32] = "\r\x1b[";
+		char* out = buffer + 3;
+		if(line < this->cursor_line_){
+			out = std::to_chars(out, buffer + 24, this->cursor_line_ - line).ptr;
+			*out++ = 'A';
+		}else if(line > this->cursor_line_){
+			out = std::to_chars(out, buffer + 24, line - this->cursor_line_).ptr;
+			*out++ = 'B';
+		}else{
+			out = buffer + 1;
+		}
+		this->writer_.write(std::string_view(buffer, static_cast<std::size_t>(out - buffer)));
+		this->cursor_line_ = line;
+	}
+
+	/**
+		The region is positioned absolutely, 'top_' is the row of its first line in the screen buffer.
+		After a full redraw it is taken from the position of the cursor, because the output may have scrolled.
+	*/
+	void draw_win32(const bool (&changed)[Lines], bool full){
+#ifdef _WIN32
+		const HANDLE handle = this->console_.handle();
+		if(full){
+			if(this->drawn_){
+				clear_lines(this->top_, Lines, this->base_attributes_, this->console_);
+				kernel_call(KernelCall::set_cursor_position, [&]{return SetConsoleCursorPosition(handle, COORD{0, static_cast<SHORT>(this->top_)});});
+			}
+			this->write_logged();
+			for(std::size_t i = 0; i < Lines; ++i){
+				this->write_line(i);
+				if(i + 1 < Lines) this->writer_ << '\n';
+			}
+			this->writer_.flush();
+			CONSOLE_SCREEN_BUFFER_INFO info;
+			if(kernel_call(KernelCall::get_screen_buffer_info, [&]{return GetConsoleScreenBufferInfo(handle, &info);})){
+				this->top_ = static_cast<std::size_t>(std::max<int>(0, info.dwCursorPosition.Y - static_cast<int>(Lines - 1)));
+			}
+			return;
+		}
+		for(std::size_t i = 0; i < Lines; ++i){
+			if(!changed[i]) continue;
+			clear_line(this->top_ + i, this->base_attributes_, this->console_);
+			kernel_call(KernelCall::set_cursor_position, [&]{return SetConsoleCursorPosition(handle, COORD{0, static_cast<SHORT>(this->top_ + i)});});
+			this->write_line(i);
+			this->writer_.flush();
+		}
+		// the cursor rests at the end of the region, where the next output is expected
+		kernel_call(KernelCall::set_cursor_position, [&]{return SetConsoleCursorPosition(handle, COORD{0, static_cast<SHORT>(this->top_ + Lines - 1)});});
+#else
+		static_cast<void>(changed);
+		static_cast<void>(full);
+#endif
+	}
+
+	/// leaves the cursor on the line below the region, redirected output gets the final lines
+	void finish(){
+		switch(this->console_.backend()){
+			case Backend::none:
+				for(std::size_t i = 0; i < Lines; ++i){
+					this->write_line(i);
+					this->writer_ << '\n';
+				}
+				break;
+			case Backend::vt:
+				this->move_vt(Lines - 1);
+				this->writer_ << '\n';
+				break;
+			case Backend::win32:
+#ifdef _WIN32
+				kernel_call(KernelCall::set_cursor_position, [&]{return SetConsoleCursorPosition(this->console_.handle(), COORD{0, static_cast<SHORT>(this->top_ + Lines - 1)});});
+#endif
+				this->writer_ << '\n';
+				break;
+		}
+		this->writer_.flush();
+	}
+
+	LiveRegionOptions options_;
+	ConsoleState& console_;
+	const std::uint64_t id_ = next_thread_attributes_id();
+	ConsoleTextAttr base_attributes_;
+	Slot slots_[Lines];
+	LogQueue queue_;
+
+	// owned by the drawing thread
+	ConsoleWriter writer_;
+	bool drawn_ = false;
+	std::size_t cursor_line_ = 0;
+	std::size_t top_ = 0;
+
+	std::atomic<std::uint64_t> frames_{0};
+	std::atomic<bool> running_{true};
+	std::thread drawer_;
+};
+
+using LiveRegion = BasicLiveRegion<8>;
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_LIVE_H
@@ -0,0 +1,614 @@
+/*
+	Description
+	-----------
+
+	A thread safe, lock-free multi-producer front-end for coloured console output.
+
+	Every line is formatted into a record of attribute runs of its own, on the stack of the calling thread.
+	Each run stores the resolved attributes together with its text, so the colours of a record
+	do not depend on what other threads have printed before.
+	Whole records are pushed through a lock-free bounded multi-producer single-consumer queue
+	to one consumer thread, that applies them to the console with the batched 'ConsoleWriter'.
+	That way a colour span is never split by the output of another thread
+	and the producers never wait on the console.
+
+	```C++
+	static cc::Logger logger;
+
+	logger.line() << Text::red << "error: " << Preset::Default << "in " << Dye::yellow(file) << '\n';
+	```
+
+	The logger works asynchronously, the producers only enqueue their records.
+	The maximal latency until a record reaches the console and what happens when the queue is full
+	can be configured with the 'LoggerOptions':
+
+	```C++
+	static cc::Logger logger(cc::LoggerOptions{std::chrono::milliseconds(5), cc::OverflowPolicy::drop_oldest});
+	```
+
+	A record is submitted when the temporary returned by 'line()' is destroyed,
+	that is at the end of the full expression. The attributes are kept from line to line,
+	separately for every thread and every logger. Lines that are larger than a record
+	are submitted as multiple records that keep their colours, but the output of other threads
+	may be printed in between.
+
+	Existing call sites of 'std::cout' become asynchronous with one call, without any change.
+	Every thread formats into a record of its own, each line or flush of a thread submits its record:
+
+	```C++
+	static cc::Logger logger;
+	logger.install(std::cout);		// until 'logger.uninstall()' or the destruction of the logger
+
+	std::cout << Text::red << "error: " << Preset::Default << "in " << Dye::yellow(file) << '\n';	// from any thread
+	```
+
+	Other 'std::ostream' objects that are used by one thread can also feed the logger through a stream buffer,
+	every flush of the stream, for example by 'std::endl', submits one record:
+
+	```C++
+	static cc::Logger logger;
+	cc::Logger::Streambuf buffer(logger);
+	std::ostream log(&buffer);
+
+	log << Text::red << "error: " << Preset::Default << "in " << Dye::yellow(file) << std::endl;
+	```
+
+	The logger does not use dynamic memory for the records, so it is quite large
+	and should have static storage duration.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_LOGGER_H
+#define OMEGA_COLOR_CONSOLE_LOGGER_H
+
+#include "colour_console.h"
+#include "colour_console_streambuf.h"
+
+//std
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**BasicMpscQueue
+	A bounded lock-free multi-producer single-consumer queue.
+
+	Every slot carries a sequence number that tells producers and the consumer whether the slot is free or filled,
+	producers claim slots with a compare exchange on the tail. The values are constructed in place
+	and filled and consumed by reference, so large records are not copied more than once.
+	The head is also claimed with a compare exchange, so that producers can drop the oldest value
+	with 'try_drop()' to make room while the consumer is popping.
+	The capacity has to be a power of two.
+*/
+template<class T, std::size_t Capacity>
+class BasicMpscQueue{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "the capacity has to be a power of two");
+
+public:
+	BasicMpscQueue(){
+		for(std::size_t i = 0; i < Capacity; ++i){
+			this->slots_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	BasicMpscQueue(const BasicMpscQueue&) = delete;
+	BasicMpscQueue& operator = (const BasicMpscQueue&) = delete;
+
+	/**
+		Claims a free slot and calls 'fill' with a reference to its value.
+		Returns false without calling 'fill' if the queue is full.
+		May be called from any thread.
+	*/
+	template<class Fill>
+	bool try_push(Fill&& fill){
+		std::size_t position = this->tail_.load(std::memory_order_relaxed);
+		for(;;){
+			Slot& slot = this->slots_[position & (Capacity - 1)];
+			const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if(difference == 0){
+				if(this->tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+					fill(slot.value);
+					slot.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}else if(difference < 0){
+				return false;
+			}else{
+				position = this->tail_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+		Calls 'consume' with a reference to the oldest value and frees its slot afterwards.
+		Returns false if the queue is empty.
+	*/
+	template<class Consume>
+	bool try_pop(Consume&& consume){
+		std::size_t position = this->head_.load(std::memory_order_relaxed);
+		for(;;){
+			Slot& slot = this->slots_[position & (Capacity - 1)];
+			const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+			if(difference == 0){
+				if(this->head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+					consume(slot.value);
+					slot.sequence.store(position + Capacity, std::memory_order_release);
+					return true;
+				}
+			}else if(difference < 0){
+				return false;
+			}else{
+				position = this->head_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+		Drops the oldest value without reading it to make room for a new one.
+		Returns false if the queue is empty.
+		May be called from any thread.
+	*/
+	bool try_drop(){
+		return this->try_pop([](T&){});
+	}
+
+	/**
+		Returns true if there is no filled slot, may be outdated as soon as it returns
+	*/
+	bool empty() const {
+		const std::size_t position = this->head_.load(std::memory_order_relaxed);
+		return this->slots_[position & (Capacity - 1)].sequence.load(std::memory_order_acquire) != position + 1;
+	}
+
+	static constexpr std::size_t capacity(){return Capacity;}
+
+private:
+	struct Slot{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	alignas(64) std::atomic<std::size_t> tail_{0};
+	alignas(64) std::atomic<std::size_t> head_{0};
+	Slot slots_[Capacity];
+};
+
+/**
+	Returns a new id for an object that keeps attributes per thread, ids are never reused
+*/
+OMEGA_COLOR_CONSOLE_MODULE_INLINE std::uint64_t next_thread_attributes_id(){
+	static std::atomic<std::uint64_t> id{0};
+	return id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+/**ThreadAttributes
+	The attributes that a thread has left for one owner, for example a logger
+*/
+struct ThreadAttributes{
+	std::uint64_t owner = 0;
+	ConsoleTextAttr attributes;
+};
+
+inline constexpr std::size_t thread_attributes_capacity = 8;
+
+/**
+	Returns the table of the calling thread, the most recently stored attributes are first
+*/
+OMEGA_COLOR_CONSOLE_MODULE_INLINE ThreadAttributes* thread_attributes_table(){
+	thread_local ThreadAttributes table[thread_attributes_capacity];
+	return table;
+}
+
+/**
+	Returns the attributes that the calling thread has stored for the owner, or 'initial' if there are none.
+	A thread remembers the attributes of the last 'thread_attributes_capacity' owners it has used,
+	the owners are identified by the ids of 'next_thread_attributes_id()', so a new logger never inherits
+	the attributes of a destroyed one.
+*/
+inline ConsoleTextAttr load_thread_attributes(std::uint64_t owner, ConsoleTextAttr initial){
+	const ThreadAttributes* const table = thread_attributes_table();
+	for(std::size_t i = 0; i < thread_attributes_capacity; ++i){
+		if(table[i].owner == owner) return table[i].attributes;
+	}
+	return initial;
+}
+
+/**
+	Stores the attributes of the calling thread for the owner, the least recently used owner is forgotten if the table is full
+*/
+inline void store_thread_attributes(std::uint64_t owner, ConsoleTextAttr attributes){
+	ThreadAttributes* const table = thread_attributes_table();
+	std::size_t index = 0;
+	while(index + 1 < thread_attributes_capacity && table[index].owner != owner) ++index;
+	for(; index > 0; --index) table[index] = table[index - 1];
+	table[0] = ThreadAttributes{owner, attributes};
+}
+
+/** OverflowPolicy
+	What the producers do when the queue of the logger is full
+*/
+enum class OverflowPolicy{
+	block,			///< wait until the consumer has made room
+	drop_oldest,	///< drop the oldest queued record and count it
+	drop			///< drop the new record and count it
+};
+
+/** LoggerOptions
+	The configuration of a logger
+*/
+struct LoggerOptions{
+	/// the maximal time between a record being taken from the queue and being written to the console, 
+	/// it also bounds how long the idle consumer thread sleeps
+	std::chrono::microseconds max_latency{1000};
+	
+	/// what the producers do when the queue is full
+	OverflowPolicy overflow = OverflowPolicy::block;
+};
+
+/**BasicRecordQueue
+	The queue of records of attribute runs between many producers and one consumer, for example of a logger.
+	Full queues are handled with the overflow policy, dropped records are counted.
+*/
+template<class RecordType, std::size_t Capacity>
+class BasicRecordQueue{
+public:
+	using Record = RecordType;
+
+	explicit BasicRecordQueue(OverflowPolicy overflow)
+		: overflow_(overflow){}
+
+	/**
+		Pushes the record into the queue and clears it, 
+		if the queue is full the overflow policy decides what happens
+	*/
+	void submit(Record& record){
+		if(record.empty()) return;
+		const auto fill = [&record](Record& slot){slot.assign(record);};
+		while(!this->queue_.try_push(fill)){
+			if(this->overflow_ == OverflowPolicy::drop){
+				this->dropped_.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}else if(this->overflow_ == OverflowPolicy::drop_oldest){
+				if(this->queue_.try_drop()) this->dropped_.fetch_add(1, std::memory_order_relaxed);
+			}else{
+				std::this_thread::yield();
+			}
+		}
+		record.clear();
+	}
+
+	/**
+		Appends the text with the attributes to the record, every time the record is full it is submitted,
+		so text that is larger than a record is split into several
+	*/
+	void append(Record& record, ConsoleTextAttr attributes, std::string_view text){
+		while(!text.empty()){
+			const std::size_t appended = record.append(attributes, text);
+			// stray continuation bytes that do not fit into an empty record are dropped
+			text.remove_prefix((appended == 0 && record.empty()) ? 1 : appended);
+			if(!text.empty()) this->submit(record);
+		}
+	}
+
+	/**
+		Calls 'consume' with the oldest record, only to be called by the consumer.
+		Returns false if the queue is empty.
+	*/
+	template<class Consume>
+	bool try_pop(Consume&& consume){
+		return this->queue_.try_pop(std::forward<Consume>(consume));
+	}
+
+	bool empty() const {return this->queue_.empty();}
+
+	/**
+		Returns how many records have been dropped because the queue was full
+	*/
+	std::uint64_t dropped() const {return this->dropped_.load(std::memory_order_relaxed);}
+
+private:
+	const OverflowPolicy overflow_;
+	std::atomic<std::uint64_t> dropped_{0};
+	BasicMpscQueue<Record, Capacity> queue_;
+};
+
+/**BasicRecordSink
+	The sink that formats into a record of its own, the record is submitted to the queue when the sink is destroyed.
+	The attributes are kept for the next sink of the calling thread with the same owner, see 'load_thread_attributes()'.
+*/
+template<class Queue>
+class BasicRecordSink : public AttrSink<BasicRecordSink<Queue>>{
+public:
+	using Record = typename Queue::Record;
+
+	BasicRecordSink(Queue& queue, std::uint64_t owner, ConsoleTextAttr initial)
+		: queue_(queue)
+		, owner_(owner)
+		, attributes_(load_thread_attributes(owner, initial)){}
+
+	BasicRecordSink(const BasicRecordSink&) = delete;
+	BasicRecordSink& operator = (const BasicRecordSink&) = delete;
+
+	~BasicRecordSink(){
+		this->queue_.submit(this->record_);
+		store_thread_attributes(this->owner_, this->attributes_);
+	}
+
+	ConsoleTextAttr attributes() const {return this->attributes_;}
+
+	void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+	void write(std::string_view text){this->queue_.append(this->record_, this->attributes_, text);}
+
+private:
+	Queue& queue_;
+	const std::uint64_t owner_;
+	ConsoleTextAttr attributes_;
+	Record record_;
+};
+
+/**BasicLogger
+	The multi-producer front-end.
+	'RecordTextCapacity' and 'RecordRunCapacity' are the capacities of a single record,
+	'QueueCapacity' is the number of records that can be queued, it has to be a power of two.
+
+	The consumer thread is started on construction and works asynchronously:
+	Producers only enqueue records, the consumer drains them and writes them to the console
+	at the latest after the configured maximal latency, even while the producers keep it busy.
+	When the queue is full the configured overflow policy applies.
+	On destruction all queued records are written before the thread is joined.
+*/
+template<std::size_t RecordTextCapacity, std::size_t RecordRunCapacity, std::size_t QueueCapacity>
+class BasicLogger{
+public:
+	using Record = BasicAttrRunBuffer<RecordTextCapacity, RecordRunCapacity>;
+	using Queue = BasicRecordQueue<Record, QueueCapacity>;
+
+	/// the sink that formats into a record of its own, see 'line()'
+	using Line = BasicRecordSink<Queue>;
+
+	/**Writer
+		The sink of the 'Streambuf' of the logger, it formats into its own record and submits it on every flush.
+		Like the stream it belongs to, it must only be used by one thread at a time.
+	*/
+	class Writer{
+	public:
+		explicit Writer(BasicLogger& logger)
+			: logger_(logger)
+			, attributes_(logger.base_attributes_){}
+
+		Writer(const Writer&) = delete;
+		Writer& operator = (const Writer&) = delete;
+
+		~Writer(){
+			this->flush();
+		}
+
+		ConsoleTextAttr attributes() const {return this->attributes_;}
+
+		void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+		void write(std::string_view text){this->logger_.queue_.append(this->record_, this->attributes_, text);}
+
+		void flush(){this->logger_.submit(this->record_);}
+
+	private:
+		BasicLogger& logger_;
+		ConsoleTextAttr attributes_;
+		Record record_;
+	};
+
+	/// a stream buffer that feeds the logger, see 'colour_console_streambuf.h'
+	using Streambuf = BasicColourStreambuf<Writer>;
+
+	/**AsyncStreambuf
+		The stream buffer that 'install()' puts into a stream, so the ordinary stream operators of any thread feed the logger.
+		It has no put area, every thread formats into a pending record of its own and its attributes are kept like those of 'line()'.
+		A line break or a flush of the stream submits the record of the calling thread.
+		A thread keeps pending records for two loggers, an unfinished line of a third one is dropped.
+	*/
+	class AsyncStreambuf : public AttrStreambuf{
+	public:
+		explicit AsyncStreambuf(BasicLogger& logger)
+			: logger_(logger){
+			this->attach();
+		}
+
+		AsyncStreambuf(const AsyncStreambuf&) = delete;
+		AsyncStreambuf& operator = (const AsyncStreambuf&) = delete;
+
+		~AsyncStreambuf() override {
+			this->detach();
+		}
+
+		ConsoleTextAttr attributes() const override {
+			return load_thread_attributes(this->logger_.id_, this->logger_.base_attributes_);
+		}
+
+		void set_attributes(ConsoleTextAttr attributes) override {
+			store_thread_attributes(this->logger_.id_, attributes);
+		}
+
+		/// the attribute stack is kept per thread, next to its pending record
+		void push(ConsoleTextAttrChange change) override {
+			this->pending().stack.push(this->attributes());
+			this->change(change);
+		}
+
+		void pop() override {
+			ConsoleTextAttr restored;
+			if(this->pending().stack.pop(restored)) this->set_attributes(restored);
+		}
+
+	protected:
+		int_type overflow(int_type c) override {
+			if(!traits_type::eq_int_type(c, traits_type::eof())){
+				const char character = traits_type::to_char_type(c);
+				this->put(std::string_view(&character, 1));
+			}
+			return traits_type::not_eof(c);
+		}
+
+		std::streamsize xsputn(const char* text, std::streamsize count) override {
+			this->put(std::string_view(text, static_cast<std::size_t>(count)));
+			return count;
+		}
+
+		int sync() override {
+			this->logger_.submit(this->pending().record);
+			return 0;
+		}
+
+	private:
+		struct PendingRecord{
+			std::uint64_t owner = 0;
+			Record record;
+			TextAttrStack stack;
+		};
+
+		/// returns the pending record and the attribute stack of the calling thread
+		PendingRecord& pending() const {
+			thread_local PendingRecord records[2];
+			thread_local std::size_t next = 0;
+			for(PendingRecord& pending : records){
+				if(pending.owner == this->logger_.id_) return pending;
+			}
+			PendingRecord& pending = records[next++ % 2];
+			pending.owner = this->logger_.id_;
+			pending.record.clear();
+			pending.stack = TextAttrStack();
+			return pending;
+		}
+
+		void put(std::string_view text){
+			Record& record = this->pending().record;
+			const ConsoleTextAttr attributes = this->attributes();
+			while(!text.empty()){
+				const std::size_t end = text.find('\n');
+				const std::string_view part = text.substr(0, (end == std::string_view::npos) ? end : end + 1);
+				text.remove_prefix(part.size());
+				this->logger_.queue_.append(record, attributes, part);
+				if(end != std::string_view::npos) this->logger_.submit(record);
+			}
+		}
+
+		BasicLogger& logger_;
+	};
+
+	explicit BasicLogger(LoggerOptions options = LoggerOptions(), ConsoleState& console = console_state())
+		: options_(options)
+		, base_attributes_(console.attributes())
+		, queue_(options.overflow)
+		, writer_(console)
+		, consumer_([this]{this->consume();}){}
+
+	BasicLogger(const BasicLogger&) = delete;
+	BasicLogger& operator = (const BasicLogger&) = delete;
+
+	~BasicLogger(){
+		this->uninstall();
+		this->running_.store(false, std::memory_order_release);
+		this->consumer_.join();
+	}
+
+	/**
+		Returns a sink that formats a line of the calling thread.
+		The attributes of each thread are kept from line to line and start with the console attributes
+		at the time the logger has been constructed.
+	*/
+	Line line(){
+		return Line(this->queue_, this->id_, this->base_attributes_);
+	}
+
+	/**
+		Replaces the stream buffer of the stream, for example of 'std::cout', with the 'AsyncStreambuf' of the logger.
+		Then the stream operators of any thread only enqueue work and existing call sites do not change.
+		A previously installed stream gets its own buffer back. Should be called before other threads use the stream.
+	*/
+	void install(std::ostream& stream){
+		this->uninstall();
+		this->original_ = stream.rdbuf(&this->async_buffer_);
+		this->installed_ = &stream;
+	}
+
+	/**
+		Gives the installed stream its own stream buffer back, the pending record of the calling thread is submitted
+	*/
+	void uninstall(){
+		if(this->installed_ == nullptr) return;
+		this->async_buffer_.pubsync();
+		this->installed_->rdbuf(this->original_);
+		this->installed_ = nullptr;
+	}
+
+	/**
+		Pushes the record into the queue and clears it, 
+		if the queue is full the overflow policy decides what happens
+	*/
+	void submit(Record& record){
+		this->queue_.submit(record);
+	}
+	
+	/**
+		Returns how many records have been dropped because the queue was full
+	*/
+	std::uint64_t dropped() const {return this->queue_.dropped();}
+	
+	const LoggerOptions& options() const {return this->options_;}
+
+private:
+	void consume(){
+		using Clock = std::chrono::steady_clock;
+		
+		const auto idle_sleep = std::min<std::chrono::microseconds>(this->options_.max_latency / 2, std::chrono::microseconds(500));
+		unsigned int idle = 0;
+		bool pending = false;
+		Clock::time_point pending_since;
+		
+		for(;;){
+			if(this->queue_.try_pop([this](Record& record){this->writer_ << record;})){
+				idle = 0;
+				const auto now = Clock::now();
+				if(!pending){
+					pending = true;
+					pending_since = now;
+				}else if(now - pending_since >= this->options_.max_latency){
+					// a continuous stream of records must not delay the output for longer than the maximal latency
+					this->writer_.flush();
+					pending = false;
+				}
+				continue;
+			}
+
+			// the queue is empty: bring everything to the console and back off
+			this->writer_.flush();
+			pending = false;
+			if(!this->running_.load(std::memory_order_acquire) && this->queue_.empty()) return;
+			if(idle < 64){
+				++idle;
+				std::this_thread::yield();
+			}else{
+				std::this_thread::sleep_for(idle_sleep);
+			}
+		}
+	}
+
+	LoggerOptions options_;
+	const std::uint64_t id_ = next_thread_attributes_id();
+	ConsoleTextAttr base_attributes_;
+	std::atomic<bool> running_{true};
+	Queue queue_;
+	ConsoleWriter writer_;
+	AsyncStreambuf async_buffer_{*this};
+	std::ostream* installed_ = nullptr;
+	std::streambuf* original_ = nullptr;
+	std::thread consumer_;
+};
+
+using Logger = BasicLogger<512, 32, 1024>;
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_LOGGER_H
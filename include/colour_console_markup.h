@@ -0,0 +1,429 @@
+/*
+	Description
+	-----------
+
+	A small markup format for coloured text templates, so that a line does not have to be built
+	from a long chain of stream operators:
+
+	```C++
+	constexpr auto error_line = cc::markup::parse("{red}error{/} in {blue,u}{}{/}: {}\n");
+	static_assert(error_line.valid());
+
+	cc::markup::format(std::cout, error_line, file, message);
+	```
+
+	The template is parsed into a fixed array of pieces, each is either text or a placeholder for the next argument
+	and carries the attributes it is printed with. Parsing is 'constexpr', so templates that are constants
+	are parsed by the compiler and formatting only writes the pieces and the arguments.
+	With C++20 the template can also be given as a template argument, then an invalid template does not compile
+	and the array has exactly the size of the template:
+
+	```C++
+	using namespace cc::markup::literals;
+	cc::markup::format(std::cout, "{red}error{/} in {blue,u}{}{/}\n"_markup, file);
+	```
+
+	Templates that are only known at runtime, for example from a configuration file, are parsed with the same parser.
+	A 'BasicCache' keeps the parsed templates keyed by their text, so they are only parsed once.
+
+	Syntax
+	------
+
+		{a,b,...}	opens a tag that applies the comma separated attributes to the following text
+		{/}			closes the innermost open tag and restores the attributes from before it
+		{}			a placeholder for the next argument
+		{{ and }}	the characters '{' and '}'
+
+	The attributes of a tag are:
+		- the colour names of the namespace 'Text', like 'red' or 'light_green', for the text colour
+		- the same names prefixed with 'bg:', like 'bg:blue', for the background colour
+		- 'u' or 'underline', 'o' or 'overline', 'left' and 'right' for the bars
+		- 'invert' for inverted colours
+		- 'default' for the default attributes 'Preset::Default'
+
+	Tags can be nested, open tags are closed at the end of the template.
+	The attributes are relative to the attributes the stream or sink has when the template is formatted.
+	No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_MARKUP_H
+#define OMEGA_COLOR_CONSOLE_MARKUP_H
+
+#include "colour_console.h"
+
+//std
+#include <cstdint>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+namespace markup{
+
+	/**
+		Returns the change that applies 'inner' on top of 'outer', the settings of 'inner' win
+	*/
+	inline constexpr ConsoleTextAttrChange nest(ConsoleTextAttrChange outer, ConsoleTextAttrChange inner){
+		return ConsoleTextAttrChange{(outer.value & ~inner.mask) | (inner.value & inner.mask), outer.mask | inner.mask};
+	}
+
+	/**Piece
+		A part of a template, either text or a placeholder for the next argument,
+		together with the change relative to the attributes the template is formatted with
+	*/
+	struct Piece{
+		enum class Kind : std::uint8_t {text, argument};
+
+		Kind kind = Kind::text;
+		ConsoleTextAttrChange attributes;
+		std::string_view text;
+	};
+
+	/// the maximal nesting depth of the tags
+	inline constexpr std::size_t max_depth = 16;
+
+	/// the offset that 'error()' returns for a valid template
+	inline constexpr std::size_t no_error = static_cast<std::size_t>(-1);
+
+	struct NamedAttribute{
+		std::string_view name;
+		ConsoleTextAttrChange attributes;
+	};
+
+	inline constexpr NamedAttribute text_colours[] = {
+		{"black", Text::black}, {"blue", Text::blue}, {"green", Text::green}, {"aqua", Text::aqua},
+		{"red", Text::red}, {"purple", Text::purple}, {"yellow", Text::yellow}, {"white", Text::white},
+		{"grey", Text::grey}, {"light_blue", Text::light_blue}, {"light_green", Text::light_green}, {"light_aqua", Text::light_aqua},
+		{"light_red", Text::light_red}, {"light_purple", Text::light_purple}, {"light_yellow", Text::light_yellow}, {"bright_white", Text::bright_white},
+	};
+
+	inline constexpr NamedAttribute background_colours[] = {
+		{"black", Background::black}, {"blue", Background::blue}, {"green", Background::green}, {"aqua", Background::aqua},
+		{"red", Background::red}, {"purple", Background::purple}, {"yellow", Background::yellow}, {"white", Background::white},
+		{"grey", Background::grey}, {"light_blue", Background::light_blue}, {"light_green", Background::light_green}, {"light_aqua", Background::light_aqua},
+		{"light_red", Background::light_red}, {"light_purple", Background::light_purple}, {"light_yellow", Background::light_yellow}, {"bright_white", Background::bright_white},
+	};
+
+	inline constexpr NamedAttribute flags[] = {
+		{"u", Bar::bottom}, {"underline", Bar::bottom}, {"o", Bar::top}, {"overline", Bar::top},
+		{"left", Bar::left}, {"right", Bar::right}, {"invert", Invert::on},
+		{"default", ConsoleTextAttrChange{Preset::Default.value, Attribute::all}},
+	};
+
+	template<std::size_t N>
+	inline constexpr bool find(const NamedAttribute (&table)[N], std::string_view name, ConsoleTextAttrChange& result){
+		for(const NamedAttribute& entry : table){
+			if(entry.name == name){
+				result = entry.attributes;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+		Parses the comma separated attributes of a tag, returns false if one of them is unknown
+	*/
+	inline constexpr bool parse_tag(std::string_view tag, ConsoleTextAttrChange& result){
+		constexpr std::string_view background_prefix = "bg:";
+		result = ConsoleTextAttrChange{};
+		while(true){
+			const std::size_t comma = tag.find(',');
+			std::string_view item = tag.substr(0, comma);
+			while(!item.empty() && item.front() == ' ') item.remove_prefix(1);
+			while(!item.empty() && item.back() == ' ') item.remove_suffix(1);
+
+			ConsoleTextAttrChange attributes;
+			const bool found = (item.substr(0, background_prefix.size()) == background_prefix)
+				? find(background_colours, item.substr(background_prefix.size()), attributes)
+				: (find(text_colours, item, attributes) || find(flags, item, attributes));
+			if(!found) return false;
+			result = nest(result, attributes);
+
+			if(comma == std::string_view::npos) return true;
+			tag.remove_prefix(comma + 1);
+		}
+	}
+
+	/**
+		Parses the template and calls 'piece(Piece)' for every piece in order.
+		Returns the offset of the first error in the template or 'no_error'.
+		Adjacent text with the same attributes is handed over as one piece if it is contiguous in the template.
+	*/
+	template<class Function>
+	inline constexpr std::size_t parse_pieces(std::string_view source, Function&& piece){
+		ConsoleTextAttrChange stack[max_depth + 1] = {};
+		std::size_t depth = 0;
+		Piece text;	// the pending text
+
+		const auto flush = [&]{
+			if(!text.text.empty()) piece(text);
+			text = Piece{};
+		};
+		const auto add_text = [&](std::size_t begin, std::size_t end){
+			if(begin == end) return;
+			if(!text.text.empty() && text.text.data() + text.text.size() == source.data() + begin
+				&& text.attributes.value == stack[depth].value && text.attributes.mask == stack[depth].mask){
+				text.text = std::string_view(text.text.data(), text.text.size() + (end - begin));
+				return;
+			}
+			flush();
+			text = Piece{Piece::Kind::text, stack[depth], source.substr(begin, end - begin)};
+		};
+
+		std::size_t begin = 0;
+		std::size_t i = 0;
+		while(i < source.size()){
+			const char c = source[i];
+			if(c == '}'){
+				if(i + 1 >= source.size() || source[i + 1] != '}') return i;
+				add_text(begin, i + 1);
+				i += 2;
+				begin = i;
+			}else if(c != '{'){
+				++i;
+			}else if(i + 1 < source.size() && source[i + 1] == '{'){
+				add_text(begin, i + 1);
+				i += 2;
+				begin = i;
+			}else{
+				add_text(begin, i);
+				const std::size_t close = source.find('}', i);
+				if(close == std::string_view::npos) return i;
+				const std::string_view tag = source.substr(i + 1, close - i - 1);
+				if(tag.empty()){
+					flush();
+					piece(Piece{Piece::Kind::argument, stack[depth], std::string_view()});
+				}else if(tag == "/"){
+					if(depth == 0) return i;
+					--depth;
+				}else{
+					ConsoleTextAttrChange attributes;
+					if(depth == max_depth || !parse_tag(tag, attributes)) return i;
+					stack[depth + 1] = nest(stack[depth], attributes);
+					++depth;
+				}
+				i = close + 1;
+				begin = i;
+			}
+		}
+		add_text(begin, source.size());
+		flush();
+		return no_error;
+	}
+
+	/**BasicTemplate
+		A parsed template with place for 'Capacity' pieces
+	*/
+	template<std::size_t Capacity>
+	class BasicTemplate{
+	public:
+		static constexpr std::size_t capacity = Capacity;
+
+		constexpr bool valid() const {return this->error_ == no_error;}
+
+		/**
+			Returns the offset in the template at which parsing failed, or 'no_error'
+		*/
+		constexpr std::size_t error() const {return this->error_;}
+
+		constexpr std::size_t size() const {return this->size_;}
+		constexpr const Piece& operator[](std::size_t index) const {return this->pieces_[index];}
+		constexpr const Piece* begin() const {return this->pieces_;}
+		constexpr const Piece* end() const {return this->pieces_ + this->size_;}
+
+		/**
+			Returns the number of placeholders
+		*/
+		constexpr std::size_t arguments() const {
+			std::size_t count = 0;
+			for(std::size_t i = 0; i < this->size_; ++i) count += (this->pieces_[i].kind == Piece::Kind::argument) ? 1 : 0;
+			return count;
+		}
+
+		/**
+			Parses the template into this, the pieces refer to the text of the template.
+			If the template is invalid or has more pieces than fit, 'valid()' returns false.
+		*/
+		constexpr void assign(std::string_view source){
+			this->size_ = 0;
+			bool overflow = false;
+			this->error_ = parse_pieces(source, [&](const Piece& piece){
+				if(this->size_ == Capacity){
+					overflow = true;
+					return;
+				}
+				this->pieces_[this->size_++] = piece;
+			});
+			// a template that does not fit fails at its end
+			if(overflow && this->error_ == no_error) this->error_ = source.size();
+			if(!this->valid()) this->size_ = 0;
+		}
+
+	private:
+		Piece pieces_[Capacity] = {};
+		std::size_t size_ = 0;
+		std::size_t error_ = no_error;
+	};
+
+	/**
+		Parses a template that is only known at runtime, the text has to outlive the result
+	*/
+	template<std::size_t Capacity>
+	inline constexpr BasicTemplate<Capacity> parse(std::string_view source){
+		BasicTemplate<Capacity> result;
+		result.assign(source);
+		return result;
+	}
+
+	/**
+		Parses a string literal, there is place for the most pieces a template of that length can have
+	*/
+	template<std::size_t N>
+	inline constexpr BasicTemplate<N / 2 + 1> parse(const char (&source)[N]){
+		return parse<N / 2 + 1>(std::string_view(source, N - 1));
+	}
+
+	/**
+		Writes the argument with the given index
+	*/
+	template<class Out, class... Args>
+	inline void write_argument(Out& out, std::size_t index, const Args&... args){
+		std::size_t i = 0;
+		((i++ == index ? static_cast<void>(out << args) : static_cast<void>(0)), ...);
+	}
+
+	/**
+		Writes the pieces of the template into a stream or sink, the placeholders are replaced by the arguments in order.
+		Placeholders without an argument are left empty and unused arguments are ignored.
+		The attributes of the stream or sink are the same afterwards.
+	*/
+	template<class Out, std::size_t Capacity, class... Args>
+	inline Out& format(Out& out, const BasicTemplate<Capacity>& markup, const Args&... args){
+		std::size_t argument = 0;
+		for(const Piece& piece : markup){
+			const bool changed = piece.attributes.mask != 0;
+			if(changed) out << push(piece.attributes);
+			if(piece.kind == Piece::Kind::text){
+				out << piece.text;
+			}else{
+				write_argument(out, argument++, args...);
+			}
+			if(changed) out << pop;
+		}
+		return out;
+	}
+
+	/**BasicCache
+		Parsed runtime templates, keyed by their text. A template is only parsed the first time it is looked up.
+		The cache keeps its own copy of the text, so the text that is looked up does not have to outlive the cache.
+		Up to 'Entries' templates with up to 'TextCapacity' bytes and 'PieceCapacity' pieces each are kept,
+		when the cache is full the oldest entry is replaced.
+
+		The cache is not synchronised, use one per thread.
+	*/
+	template<std::size_t Entries, std::size_t TextCapacity, std::size_t PieceCapacity>
+	class BasicCache{
+		static_assert(Entries >= 1, "the cache needs at least one entry");
+
+	public:
+		using Template = BasicTemplate<PieceCapacity>;
+
+		/**
+			Returns the parsed template, or nullptr if it is invalid or too large.
+			The result stays valid until a template that is not in the cache is looked up.
+		*/
+		const Template* find(std::string_view source){
+			const std::uint64_t key = hash(source);
+			for(Entry& entry : this->entries_){
+				if(entry.used && entry.key == key && std::string_view(entry.source, entry.size) == source){
+					return entry.markup.valid() ? &entry.markup : nullptr;
+				}
+			}
+			if(source.size() > TextCapacity) return nullptr;
+
+			Entry& entry = this->entries_[this->next_];
+			this->next_ = (this->next_ + 1) % Entries;
+			std::memcpy(entry.source, source.data(), source.size());
+			entry.size = source.size();
+			entry.key = key;
+			entry.used = true;
+			entry.markup.assign(std::string_view(entry.source, entry.size));
+			return entry.markup.valid() ? &entry.markup : nullptr;
+		}
+
+		void clear(){
+			for(Entry& entry : this->entries_) entry.used = false;
+			this->next_ = 0;
+		}
+
+	private:
+		/// FNV-1a
+		static constexpr std::uint64_t hash(std::string_view text){
+			std::uint64_t result = 14695981039346656037ull;
+			for(const char c : text) result = (result ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+			return result;
+		}
+
+		struct Entry{
+			std::uint64_t key = 0;
+			std::size_t size = 0;
+			bool used = false;
+			char source[TextCapacity];
+			Template markup;
+		};
+
+		Entry entries_[Entries];
+		std::size_t next_ = 0;
+	};
+
+	using Cache = BasicCache<32, 256, 32>;
+
+	/**
+		Formats a runtime template that is looked up in the cache, invalid templates write nothing.
+		Returns false if the template is invalid or too large for the cache.
+	*/
+	template<class Out, std::size_t Entries, std::size_t TextCapacity, std::size_t PieceCapacity, class... Args>
+	inline bool format(Out& out, BasicCache<Entries, TextCapacity, PieceCapacity>& cache, std::string_view source, const Args&... args){
+		const auto* markup = cache.find(source);
+		if(markup == nullptr) return false;
+		format(out, *markup, args...);
+		return true;
+	}
+
+#if defined(__cpp_consteval) && defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+	/**FixedString
+		A string literal as a template argument
+	*/
+	template<std::size_t N>
+	struct FixedString{
+		char data[N] = {};
+
+		consteval FixedString(const char (&text)[N]){
+			for(std::size_t i = 0; i < N; ++i) this->data[i] = text[i];
+		}
+
+		constexpr std::string_view view() const {return std::string_view(this->data, N - 1);}
+	};
+
+	/**
+		Returns the number of pieces of the template, an invalid template does not compile
+	*/
+	template<FixedString Source>
+	consteval std::size_t piece_count(){
+		std::size_t count = 0;
+		if(parse_pieces(Source.view(), [&](const Piece&){++count;}) != no_error) throw "invalid colour markup";
+		return count;
+	}
+
+	/// the template parsed at compile time, with exactly as many pieces as it needs
+	template<FixedString Source>
+	inline constexpr BasicTemplate<(piece_count<Source>() == 0) ? 1 : piece_count<Source>()> compiled = parse<(piece_count<Source>() == 0) ? 1 : piece_count<Source>()>(Source.view());
+
+	namespace literals{
+		template<FixedString Source>
+		consteval const auto& operator""_markup(){return compiled<Source>;}
+	}
+#endif
+
+}//namespace markup
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_MARKUP_H
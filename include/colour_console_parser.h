@@ -0,0 +1,360 @@
+/*
+	Description
+	-----------
+
+	A streaming parser for the output of other programs, that translates their virtual terminal colour sequences ('SGR')
+	into 'ConsoleTextAttr' runs, for example to relay the output of a child process to a legacy console
+	that would print the escape sequences as garbage.
+
+	```C++
+	cc::VtParser parser;
+	cc::ConsoleWriter out;
+
+	char buffer[65536];
+	while(const std::size_t size = read_from_child(buffer, sizeof(buffer))){
+		parser.feed(std::string_view(buffer, size), out);
+	}
+	```
+
+	The output can be any stream or sink, the runs can also be taken directly with 'parse()':
+	their text points into the input and is never copied by the parser.
+
+	The parser is a state machine with the states of the VT500 parser that are needed to find the end of every sequence,
+	so sequences can be split across calls in any place. Only 'SGR' is translated:
+		- 0 resets to the base attributes, 39 and 49 reset the foreground and background to those of the base attributes
+		- 30 - 37, 90 - 97, 40 - 47 and 100 - 107 select the colours
+		- 38 and 48 with the 256 colours (5) and 24-bit colours (2), both with ';' and ':', select the nearest console colour
+		- 1 and 22 switch the intensity of the foreground on and off, like the windows console does for bold text
+		- 4 (and 21) and 24 underscore, 53 and 55 overline and 7 and 27 reverse video
+	All other parameters, sequences and strings (OSC, DCS, ...) are removed. C1 control bytes are not recognised,
+	because they are part of UTF-8 characters.
+
+	Between sequences the input is scanned for the next escape byte 32 (AVX2) or 16 (SSE2) bytes at a time,
+	so text without sequences is passed on at memory bandwidth. No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_PARSER_H
+#define OMEGA_COLOR_CONSOLE_PARSER_H
+
+#include "colour_console.h"
+#include "colour_console_extended.h"
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+namespace parser{
+
+/**
+	Returns the index of the lowest set bit, the mask must not be 0
+*/
+inline unsigned int lowest_set_bit(std::uint32_t mask){
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<unsigned int>(index);
+#else
+	return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+/**
+	Returns a pointer to the first escape byte in the range or 'end' if there is none
+*/
+inline const char* find_escape(const char* begin, const char* end){
+#if defined(__AVX2__)
+	const __m256i escape = _mm256_set1_epi8('\x1b');
+	while(end - begin >= 32){
+		const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		const std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, escape)));
+		if(mask != 0) return begin + lowest_set_bit(mask);
+		begin += 32;
+	}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const __m128i escape = _mm_set1_epi8('\x1b');
+	while(end - begin >= 16){
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, escape)));
+		if(mask != 0) return begin + lowest_set_bit(mask);
+		begin += 16;
+	}
+#endif
+	// a zero byte in the word marks the escape bytes
+	while(end - begin >= 8){
+		std::uint64_t word;
+		std::memcpy(&word, begin, sizeof(word));
+		word ^= 0x1b1b1b1b1b1b1b1bull;
+		if(((word - 0x0101010101010101ull) & ~word & 0x8080808080808080ull) != 0) break;
+		begin += 8;
+	}
+	while(begin != end && *begin != '\x1b') ++begin;
+	return begin;
+}
+
+}//namespace parser
+
+/**VtParser
+	Translates text with virtual terminal escape sequences into runs of text and 'ConsoleTextAttr'
+*/
+class VtParser{
+public:
+	/// the number of parameters of a control sequence that are kept, further parameters are ignored
+	static constexpr std::size_t max_parameters = 32;
+
+	/**
+		The base attributes are the attributes at the beginning and after a reset
+	*/
+	explicit VtParser(ConsoleTextAttr base = Preset::Default)
+		: base_(base)
+		, colours_(base.value & (Attribute::foreground | Attribute::background))
+		, flags_(base.value & ~(Attribute::foreground | Attribute::background) & Attribute::all){}
+
+	/**
+		Returns the attributes of the next text
+	*/
+	ConsoleTextAttr attributes() const {return ConsoleTextAttr{this->colours_ | this->flags_ | (this->bold_ ? 0x8u : 0u)};}
+
+	/**
+		Returns the base attributes, the attributes after a reset
+	*/
+	ConsoleTextAttr base() const {return this->base_;}
+
+	/**
+		Returns true if the input ended in the middle of an escape sequence
+	*/
+	bool in_sequence() const {return this->state_ != State::ground;}
+
+	/**
+		Forgets a sequence that has not been finished and resets the attributes to the base attributes
+	*/
+	void reset(){
+		this->state_ = State::ground;
+		this->reset_attributes();
+	}
+
+	/**
+		Calls the function with every run of text of the input as an 'AttrRun', the text points into the input.
+		Escape sequences change the attributes of the following runs and are not part of any run.
+	*/
+	template<class Function>
+	void parse(std::string_view input, Function&& function){
+		const char* in = input.data();
+		const char* const end = in + input.size();
+		while(in != end){
+			if(this->state_ == State::ground){
+				const char* const escape = parser::find_escape(in, end);
+				if(escape != in) function(AttrRun{this->attributes(), std::string_view(in, static_cast<std::size_t>(escape - in))});
+				if(escape == end) return;
+				in = escape + 1;
+				this->state_ = State::escape;
+				continue;
+			}
+			this->consume(static_cast<unsigned char>(*in++));
+		}
+	}
+
+	/**
+		Writes the text of the input with the translated attributes into a stream or sink, for example a 'ConsoleWriter'
+	*/
+	template<class Out>
+	void feed(std::string_view input, Out& out){
+		this->parse(input, [&](AttrRun run){out << run.attributes << run.text;});
+	}
+
+private:
+	enum class State : unsigned char{
+		ground,
+		escape,					///< after the escape byte
+		escape_intermediate,	///< an escape sequence with intermediate bytes
+		csi_parameter,			///< the parameters of a control sequence
+		csi_ignore,				///< the rest of a control sequence that is not 'SGR'
+		string,					///< a string (OSC, DCS, SOS, PM, APC) until the string terminator or BEL
+		string_escape			///< an escape byte in a string, that may start the string terminator
+	};
+
+	void consume(unsigned char byte){
+		// CAN and SUB cancel every sequence, an escape byte starts a new one
+		if(byte == 0x18 || byte == 0x1A){
+			if(this->state_ != State::string && this->state_ != State::string_escape){
+				this->state_ = State::ground;
+				return;
+			}
+		}
+		switch(this->state_){
+			case State::ground:
+				break;
+			case State::escape:
+				if(byte == '\x1b'){
+					// stays in the escape state
+				}else if(byte == '['){
+					this->begin_control_sequence();
+				}else if(byte == ']' || byte == 'P' || byte == 'X' || byte == '^' || byte == '_'){
+					this->state_ = State::string;
+				}else if(byte >= 0x20 && byte <= 0x2F){
+					this->state_ = State::escape_intermediate;
+				}else if(byte >= 0x30 && byte <= 0x7E){
+					this->state_ = State::ground;
+				}
+				break;
+			case State::escape_intermediate:
+				if(byte == '\x1b') this->state_ = State::escape;
+				else if(byte >= 0x30 && byte <= 0x7E) this->state_ = State::ground;
+				break;
+			case State::csi_parameter:
+				if(byte >= '0' && byte <= '9'){
+					std::uint32_t& parameter = this->parameters_[this->parameter_count_];
+					parameter = std::min<std::uint32_t>(parameter * 10 + (byte - '0'), 0xFFFF);
+				}else if(byte == ';' || byte == ':'){
+					this->next_parameter(byte == ':');
+				}else if(byte == 'm'){
+					this->next_parameter(false);
+					this->select_graphic_rendition();
+					this->state_ = State::ground;
+				}else if(byte == '\x1b'){
+					this->state_ = State::escape;
+				}else if(byte >= 0x40 && byte <= 0x7E){
+					this->state_ = State::ground;
+				}else if(byte >= 0x20){
+					// private markers and intermediate bytes are not part of 'SGR'
+					this->state_ = State::csi_ignore;
+				}
+				break;
+			case State::csi_ignore:
+				if(byte == '\x1b') this->state_ = State::escape;
+				else if(byte >= 0x40 && byte <= 0x7E) this->state_ = State::ground;
+				break;
+			case State::string:
+				if(byte == 0x07) this->state_ = State::ground;
+				else if(byte == '\x1b') this->state_ = State::string_escape;
+				break;
+			case State::string_escape:
+				if(byte == '\\') this->state_ = State::ground;
+				else if(byte != '\x1b') this->state_ = State::string;
+				break;
+		}
+	}
+
+	void begin_control_sequence(){
+		this->state_ = State::csi_parameter;
+		this->parameter_count_ = 0;
+		this->parameters_[0] = 0;
+		this->sub_parameters_ = 0;
+	}
+
+	/// finishes the current parameter, the next one is a sub parameter if it follows a ':'
+	void next_parameter(bool sub_parameter){
+		// once all parameters are taken, the further ones are parsed into the spare entry and dropped
+		if(this->parameter_count_ < max_parameters) ++this->parameter_count_;
+		this->parameters_[this->parameter_count_] = 0;
+		if(sub_parameter && this->parameter_count_ < max_parameters) this->sub_parameters_ |= std::uint64_t(1) << this->parameter_count_;
+	}
+
+	bool is_sub_parameter(std::size_t index) const {return (this->sub_parameters_ >> index) & 1;}
+
+	void reset_attributes(){
+		this->colours_ = this->base_.value & (Attribute::foreground | Attribute::background);
+		this->flags_ = this->base_.value & ~(Attribute::foreground | Attribute::background) & Attribute::all;
+		this->bold_ = false;
+	}
+
+	void set_foreground(unsigned int colour){this->colours_ = (this->colours_ & ~Attribute::foreground) | (colour & 0xF);}
+	void set_background(unsigned int colour){this->colours_ = (this->colours_ & ~Attribute::background) | ((colour & 0xF) << 4);}
+	void set_flag(unsigned int flag, bool on){this->flags_ = on ? (this->flags_ | flag) : (this->flags_ & ~flag);}
+
+	/// returns the console colour that is nearest to the 24-bit colour in the three parameters that start at 'index'
+	unsigned int rgb_colour(std::size_t index) const {
+		const auto channel = [&](std::size_t i){return static_cast<std::uint8_t>(std::min<std::uint32_t>(this->parameters_[i], 255));};
+		return quantise::to_console(Colour::make_rgb(channel(index), channel(index + 1), channel(index + 2)));
+	}
+
+	/**
+		Reads the colour of 38, 48 or 58 that starts at the parameter 'index' and returns the index of its last parameter.
+		'colour' receives the 4 windows colour bits or -1 if the colour is not valid.
+	*/
+	std::size_t read_extended_colour(std::size_t index, int& colour) const {
+		colour = -1;
+		const std::size_t count = this->parameter_count_;
+		const auto parameter = [&](std::size_t i){return (i < count) ? this->parameters_[i] : 0u;};
+		if(index + 1 < count && this->is_sub_parameter(index + 1)){
+			// 38:5:n, 38:2:r:g:b or 38:2:space:r:g:b, all sub parameters belong to the colour
+			std::size_t last = index + 1;
+			while(last + 1 < count && this->is_sub_parameter(last + 1)) ++last;
+			const std::size_t subs = last - index;
+			if(parameter(index + 1) == 5 && subs >= 2){
+				colour = static_cast<int>(quantise::palette_to_console[static_cast<std::uint8_t>(parameter(index + 2))]);
+			}else if(parameter(index + 1) == 2 && subs >= 4){
+				const std::size_t rgb = (subs >= 5) ? index + 3 : index + 2;
+				colour = static_cast<int>(this->rgb_colour(rgb));
+			}
+			return last;
+		}
+		// 38;5;n or 38;2;r;g;b
+		if(parameter(index + 1) == 5){
+			if(index + 2 < count) colour = static_cast<int>(quantise::palette_to_console[static_cast<std::uint8_t>(parameter(index + 2))]);
+			return std::min(index + 2, count - 1);
+		}
+		if(parameter(index + 1) == 2){
+			if(index + 4 < count) colour = static_cast<int>(this->rgb_colour(index + 2));
+			return std::min(index + 4, count - 1);
+		}
+		return std::min(index + 1, count - 1);
+	}
+
+	void select_graphic_rendition(){
+		for(std::size_t i = 0; i < this->parameter_count_; ++i){
+			const unsigned int parameter = this->parameters_[i];
+			// sub parameters of parameters that do not take any are skipped
+			std::size_t last = i;
+			while(parameter != 38 && parameter != 48 && parameter != 58 && last + 1 < this->parameter_count_ && this->is_sub_parameter(last + 1)) ++last;
+
+			if(parameter >= 30 && parameter <= 37){
+				this->set_foreground(vt::ansi_colour_index(parameter - 30));
+			}else if(parameter >= 90 && parameter <= 97){
+				this->set_foreground(vt::ansi_colour_index(parameter - 90) | 0x8);
+			}else if(parameter >= 40 && parameter <= 47){
+				this->set_background(vt::ansi_colour_index(parameter - 40));
+			}else if(parameter >= 100 && parameter <= 107){
+				this->set_background(vt::ansi_colour_index(parameter - 100) | 0x8);
+			}else if(parameter == 38 || parameter == 48 || parameter == 58){
+				int colour;
+				last = this->read_extended_colour(i, colour);
+				if(colour >= 0 && parameter == 38) this->set_foreground(static_cast<unsigned int>(colour));
+				if(colour >= 0 && parameter == 48) this->set_background(static_cast<unsigned int>(colour));
+			}else{
+				switch(parameter){
+					case 0: this->reset_attributes(); break;
+					case 1: this->bold_ = true; break;
+					case 22: this->bold_ = false; break;
+					// 4:0 is no underline, all other styles of 4 are shown as the underscore
+					case 4: this->set_flag(Attribute::underscore, !(last > i && this->parameters_[i + 1] == 0)); break;
+					case 21: this->set_flag(Attribute::underscore, true); break;
+					case 24: this->set_flag(Attribute::underscore, false); break;
+					case 7: this->set_flag(Attribute::reverse_video, true); break;
+					case 27: this->set_flag(Attribute::reverse_video, false); break;
+					case 53: this->set_flag(Attribute::grid_horizontal, true); break;
+					case 55: this->set_flag(Attribute::grid_horizontal, false); break;
+					case 39: this->set_foreground(this->base_.value & Attribute::foreground); break;
+					case 49: this->set_background((this->base_.value & Attribute::background) >> 4); break;
+					default: break;
+				}
+			}
+			i = last;
+		}
+	}
+
+	ConsoleTextAttr base_;
+	unsigned int colours_;		///< the foreground and background bits
+	unsigned int flags_;		///< the bits of the attributes that are not colours
+	bool bold_ = false;
+
+	State state_ = State::ground;
+	std::uint32_t parameters_[max_parameters + 1] = {};	///< the last entry is the spare one
+	std::size_t parameter_count_ = 0;
+	std::uint64_t sub_parameters_ = 0;	///< bit i is set if the parameter i follows a ':'
+};
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_PARSER_H
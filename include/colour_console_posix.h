@@ -0,0 +1,64 @@
+/*
+	Description
+	-----------
+	
+	The backend of 'colour_console.h' for all platforms other than windows. 
+	It defines the calls of 'cc::platform' with 'isatty' and 'write' of POSIX, the attributes are always
+	written as virtual terminal escape sequences, so there is no attribute call of the operating system.
+	With 'OMEGA_COLOR_CONSOLE_COMPILED_BACKEND' the calls are only defined in 'colour_console.cpp'.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_POSIX_H
+#define OMEGA_COLOR_CONSOLE_POSIX_H
+
+#include <unistd.h>
+#include <cerrno>
+
+#include "colour_console.h"
+
+#if !defined(OMEGA_COLOR_CONSOLE_COMPILED_BACKEND) || defined(OMEGA_COLOR_CONSOLE_BACKEND_SOURCE)
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+namespace platform{
+
+OMEGA_COLOR_CONSOLE_BACKEND_API ConsoleHandle standard_output(){
+	return STDOUT_FILENO;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API bool is_console(ConsoleHandle handle){
+	return kernel_call(KernelCall::get_file_type, [&]{return isatty(handle);}) == 1;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API Backend console_backend(ConsoleHandle){
+	return Backend::vt;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API bool read_attributes(ConsoleHandle, ConsoleTextAttr&){
+	return false;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API void set_attributes(ConsoleHandle, ConsoleTextAttr){}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API void write(ConsoleHandle handle, std::string_view bytes){
+	while(!bytes.empty()){
+		const ssize_t written = kernel_call(KernelCall::write_file, [&]{return ::write(handle, bytes.data(), bytes.size());});
+		if(written < 0){
+			if(errno == EINTR) continue;
+			return;
+		}
+		bytes.remove_prefix(static_cast<std::size_t>(written));
+	}
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API bool write_utf16(ConsoleHandle, const wchar_t*, std::size_t){
+	return false;
+}
+
+}//namespace platform
+
+}//namespace cc
+
+#endif
+
+#endif //OMEGA_COLOR_CONSOLE_POSIX_H
@@ -0,0 +1,97 @@
+/*
+	Description
+	-----------
+
+	Fast mapping of 24-bit RGB colours to the 16 console colours, for example for heatmaps on legacy consoles.
+
+	A table with the nearest console colour of every colour of a 32x32x32 grid (5 bits per channel)
+	is generated at compile time, so quantising a colour at runtime costs a few shifts and one lookup.
+	Whole rows are quantised at once: the table indices are computed 8 (AVX2) or 4 (SSE2) colours at a time,
+	with AVX2 the lookups are gathered as well. The rows can be written straight into the cells of a 'BasicScreen',
+	which have the layout of the windows 'CHAR_INFO':
+
+	```C++
+	static cc::BasicScreen<120, 40> screen;
+	std::uint32_t heat[120];	// 0xRRGGBB
+
+	for(std::size_t y = 0; y < 40; ++y){
+		compute_heat_row(y, heat);
+		cc::quantise::colour_row(screen.row(y), heat, heat, 120);	// foreground and background
+	}
+	screen.present();
+	```
+
+	The table is the one of 'colour_console_extended.h', which maps the RGB colours of the extended attributes as well.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_QUANTISE_H
+#define OMEGA_COLOR_CONSOLE_QUANTISE_H
+
+#include "colour_console.h"
+#include "colour_console_extended.h"
+#include "colour_console_screen.h"
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+namespace quantise{
+
+	/**
+		Quantises a row of colours given as 0xRRGGBB into the 4 windows colour bits of their nearest console colours
+	*/
+	inline void nearest_row(const std::uint32_t* rgb, std::size_t count, std::uint8_t* out){
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		const __m256i red_mask = _mm256_set1_epi32(0x7C00);
+		const __m256i green_mask = _mm256_set1_epi32(0x03E0);
+		const __m256i blue_mask = _mm256_set1_epi32(0x001F);
+		const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+		for(; i + 8 <= count; i += 8){
+			const __m256i colours = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgb + i));
+			const __m256i index = _mm256_or_si256(
+				_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(colours, 9), red_mask), _mm256_and_si256(_mm256_srli_epi32(colours, 6), green_mask)),
+				_mm256_and_si256(_mm256_srli_epi32(colours, 3), blue_mask));
+			const __m256i entries = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(rgb_table.entries), index, 1), byte_mask);
+			alignas(32) std::uint32_t lanes[8];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), entries);
+			for(std::size_t lane = 0; lane < 8; ++lane) out[i + lane] = static_cast<std::uint8_t>(lanes[lane]);
+		}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		const __m128i red_mask = _mm_set1_epi32(0x7C00);
+		const __m128i green_mask = _mm_set1_epi32(0x03E0);
+		const __m128i blue_mask = _mm_set1_epi32(0x001F);
+		for(; i + 4 <= count; i += 4){
+			const __m128i colours = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i));
+			const __m128i index = _mm_or_si128(
+				_mm_or_si128(_mm_and_si128(_mm_srli_epi32(colours, 9), red_mask), _mm_and_si128(_mm_srli_epi32(colours, 6), green_mask)),
+				_mm_and_si128(_mm_srli_epi32(colours, 3), blue_mask));
+			alignas(16) std::uint32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+			for(std::size_t lane = 0; lane < 4; ++lane) out[i + lane] = rgb_table.entries[lanes[lane]];
+		}
+#endif
+		for(; i < count; ++i) out[i] = static_cast<std::uint8_t>(nearest(rgb[i]));
+	}
+
+	/**
+		Sets the attributes of a row of screen cells to the nearest console colours of the given foreground
+		and background colours (0xRRGGBB) together with the flags (bars, reverse video and underscore).
+		The characters of the cells are kept.
+	*/
+	inline void colour_row(ScreenCell* cells, const std::uint32_t* foreground, const std::uint32_t* background, std::size_t count, unsigned int flags = 0){
+		constexpr std::size_t block = 64;
+		std::uint8_t foreground_colours[block];
+		std::uint8_t background_colours[block];
+		const std::uint16_t flag_bits = static_cast<std::uint16_t>(flags & ~(Attribute::foreground | Attribute::background));
+		for(std::size_t begin = 0; begin < count; begin += block){
+			const std::size_t size = std::min(block, count - begin);
+			nearest_row(foreground + begin, size, foreground_colours);
+			nearest_row(background + begin, size, background_colours);
+			for(std::size_t i = 0; i < size; ++i){
+				cells[begin + i].attributes = static_cast<std::uint16_t>(foreground_colours[i] | (background_colours[i] << 4) | flag_bits);
+			}
+		}
+	}
+
+}//namespace quantise
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_QUANTISE_H
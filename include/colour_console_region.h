@@ -0,0 +1,289 @@
+/*
+	Description
+	-----------
+
+	Clearing, filling and recolouring regions of the console with a constant number of calls,
+	instead of printing spaces cell by cell through the stream.
+
+	```C++
+	cc::clear_screen(Preset::Default);
+	cc::fill_rectangle(10, 2, 40, 5, BackgroundSet::blue);			// a blue box
+	cc::recolour_rectangle(10, 3, 40, 1, TextSet::bright_white | BackgroundSet::red);	// highlight a row, the text is kept
+	cc::clear_line(24);
+	```
+
+	The coordinates are cells of the console, counted from 0, like those of the 'BasicScreen'.
+	None of the functions moves the cursor or changes the current attributes, except for 'clear_screen()'.
+
+	With the win32 backend:
+		- clearing whole lines or the screen fills characters and attributes with 'FillConsoleOutputCharacterW'
+		  and 'FillConsoleOutputAttribute', one call each for the whole region
+		- a rectangle is filled with 'WriteConsoleOutputW' from a small buffer, one call per 4096 cells
+		- a single row is recoloured with one 'FillConsoleOutputAttribute', larger rectangles with one
+		  'ReadConsoleOutputW' and 'WriteConsoleOutputW' per 4096 cells
+	With the virtual terminal backend every operation is one write of escape sequences:
+		- erase in display and erase in line for the screen and whole lines
+		- erase character ('ECH') for each row of a rectangle filled with spaces
+		- change attributes in a rectangular area ('DECCARA') for recolouring, which needs a terminal that supports it,
+		  like the windows console or the windows terminal. Other terminals ignore it.
+	Redirected output has no cells, so nothing is written.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_REGION_H
+#define OMEGA_COLOR_CONSOLE_REGION_H
+
+#include "colour_console.h"
+#ifdef _WIN32
+	#include "colour_console_win32.h"
+#endif
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**VtSequenceBuffer
+	Collects escape sequences and text and writes them with as few calls as possible
+*/
+class VtSequenceBuffer{
+public:
+	explicit VtSequenceBuffer(ConsoleState& console)
+		: console_(console){}
+
+	VtSequenceBuffer(const VtSequenceBuffer&) = delete;
+	VtSequenceBuffer& operator = (const VtSequenceBuffer&) = delete;
+
+	~VtSequenceBuffer(){
+		this->flush();
+	}
+
+	void append(std::string_view bytes){
+		if(this->size_ + bytes.size() > sizeof(this->buffer_)){
+			this->flush();
+			// input that does not fit into the empty buffer either is written as it is
+			if(bytes.size() > sizeof(this->buffer_)) return this->console_.write_text(bytes);
+		}
+		std::memcpy(this->buffer_ + this->size_, bytes.data(), bytes.size());
+		this->size_ += bytes.size();
+	}
+
+	void append(std::size_t number){
+		char buffer[24];
+		const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+		this->append(std::string_view(buffer, static_cast<std::size_t>(result.ptr - buffer)));
+	}
+
+	/// appends the escape sequence that moves the cursor to the cell 'x', 'y'
+	void append_cursor_position(std::size_t x, std::size_t y){
+		this->append("\x1b[");
+		this->append(y + 1);
+		this->append(";");
+		this->append(x + 1);
+		this->append("H");
+	}
+
+	void flush(){
+		if(this->size_ == 0) return;
+		this->console_.write_text(std::string_view(this->buffer_, this->size_));
+		this->size_ = 0;
+	}
+
+private:
+	ConsoleState& console_;
+	std::size_t size_ = 0;
+	char buffer_[4096];
+};
+
+#ifdef _WIN32
+/// the number of cells that are written with one call
+inline constexpr std::size_t region_chunk_cells = 4096;
+
+/**
+	Calls the function with every part of the rectangle as a 'SMALL_RECT' that has at most 'region_chunk_cells' cells
+	and is made of whole rows if possible
+*/
+template<class Function>
+inline void for_each_region_chunk(std::size_t x, std::size_t y, std::size_t width, std::size_t height, Function&& function){
+	const std::size_t columns = std::min(width, region_chunk_cells);
+	const std::size_t rows = region_chunk_cells / columns;
+	for(std::size_t left = 0; left < width; left += columns){
+		const std::size_t chunk_width = std::min(columns, width - left);
+		for(std::size_t top = 0; top < height; top += rows){
+			const std::size_t chunk_height = std::min(rows, height - top);
+			SMALL_RECT region{
+				static_cast<SHORT>(x + left), static_cast<SHORT>(y + top),
+				static_cast<SHORT>(x + left + chunk_width - 1), static_cast<SHORT>(y + top + chunk_height - 1)};
+			function(region, COORD{static_cast<SHORT>(chunk_width), static_cast<SHORT>(chunk_height)});
+		}
+	}
+}
+
+/**
+	Fills 'count' cells starting at the cell 'x', 'y' with the character and the attributes,
+	continuing on the next rows
+*/
+inline void fill_console_output(HANDLE handle, std::size_t x, std::size_t y, std::size_t count, wchar_t character, ConsoleTextAttr attributes){
+	const COORD origin{static_cast<SHORT>(x), static_cast<SHORT>(y)};
+	DWORD written;
+	kernel_call(KernelCall::fill_output_character, [&]{return FillConsoleOutputCharacterW(handle, character, static_cast<DWORD>(count), origin, &written);});
+	kernel_call(KernelCall::fill_output_attribute, [&]{return FillConsoleOutputAttribute(handle, static_cast<WORD>(attributes.value), static_cast<DWORD>(count), origin, &written);});
+}
+#endif
+
+/**
+	Clears the whole screen with the attributes, moves the cursor to the top left cell
+	and makes the attributes the current ones
+*/
+inline void clear_screen(ConsoleTextAttr attributes = Preset::Default, ConsoleState& console = console_state()){
+	switch(console.backend()){
+		case Backend::none:
+			break;
+		case Backend::win32:{
+#ifdef _WIN32
+			CONSOLE_SCREEN_BUFFER_INFO info;
+			if(!kernel_call(KernelCall::get_screen_buffer_info, [&]{return GetConsoleScreenBufferInfo(console.handle(), &info);})) return;
+			fill_console_output(console.handle(), 0, 0, static_cast<std::size_t>(info.dwSize.X) * static_cast<std::size_t>(info.dwSize.Y), L' ', attributes);
+			kernel_call(KernelCall::set_cursor_position, [&]{return SetConsoleCursorPosition(console.handle(), COORD{0, 0});});
+			console.set(attributes);
+#endif
+		}break;
+		case Backend::vt:{
+			// the erased cells get the background of the current attributes
+			VtSequenceBuffer out(console);
+			out.append(vt::sgr(attributes).view());
+			out.append("\x1b[H" "\x1b[2J");
+			console.track(attributes);
+		}break;
+	}
+}
+
+/**
+	Clears 'count' whole lines starting with the line 'y' with the attributes
+*/
+inline void clear_lines(std::size_t y, std::size_t count, ConsoleTextAttr attributes = Preset::Default, ConsoleState& console = console_state()){
+	if(count == 0) return;
+	switch(console.backend()){
+		case Backend::none:
+			break;
+		case Backend::win32:{
+#ifdef _WIN32
+			CONSOLE_SCREEN_BUFFER_INFO info;
+			if(!kernel_call(KernelCall::get_screen_buffer_info, [&]{return GetConsoleScreenBufferInfo(console.handle(), &info);})) return;
+			fill_console_output(console.handle(), 0, y, static_cast<std::size_t>(info.dwSize.X) * count, L' ', attributes);
+#endif
+		}break;
+		case Backend::vt:{
+			// the cursor and the attributes are saved and restored around the erase
+			VtSequenceBuffer out(console);
+			out.append("\x1b" "7");
+			out.append(vt::sgr(attributes).view());
+			for(std::size_t i = 0; i < count; ++i){
+				out.append_cursor_position(0, y + i);
+				out.append("\x1b[2K");
+			}
+			out.append("\x1b" "8");
+		}break;
+	}
+}
+
+/**
+	Clears the line 'y' with the attributes
+*/
+inline void clear_line(std::size_t y, ConsoleTextAttr attributes = Preset::Default, ConsoleState& console = console_state()){
+	clear_lines(y, 1, attributes, console);
+}
+
+/**
+	Fills the rectangle with the character and the attributes
+*/
+inline void fill_rectangle(std::size_t x, std::size_t y, std::size_t width, std::size_t height, ConsoleTextAttr attributes,
+							char16_t character = u' ', ConsoleState& console = console_state()){
+	if(width == 0 || height == 0) return;
+	switch(console.backend()){
+		case Backend::none:
+			break;
+		case Backend::win32:{
+#ifdef _WIN32
+			CHAR_INFO cells[region_chunk_cells];
+			const std::size_t used = std::min(width * height, region_chunk_cells);
+			for(std::size_t i = 0; i < used; ++i){
+				cells[i].Char.UnicodeChar = static_cast<wchar_t>(character);
+				cells[i].Attributes = static_cast<WORD>(attributes.value);
+			}
+			for_each_region_chunk(x, y, width, height, [&](SMALL_RECT region, COORD size){
+				count_written_bytes(static_cast<std::size_t>(size.X) * static_cast<std::size_t>(size.Y) * sizeof(CHAR_INFO));
+				kernel_call(KernelCall::write_console_output, [&]{return WriteConsoleOutputW(console.handle(), cells, size, COORD{0, 0}, &region);});
+			});
+#endif
+		}break;
+		case Backend::vt:{
+			VtSequenceBuffer out(console);
+			out.append("\x1b" "7");
+			out.append(vt::sgr(attributes).view());
+			char encoded[4];
+			const std::string_view symbol(encoded, utf8::encode(character, encoded));
+			for(std::size_t row = 0; row < height; ++row){
+				out.append_cursor_position(x, y + row);
+				if(character == u' '){
+					// erase character does not move the cursor and does not need the spaces
+					out.append("\x1b[");
+					out.append(width);
+					out.append("X");
+				}else{
+					for(std::size_t i = 0; i < width; ++i) out.append(symbol);
+				}
+			}
+			out.append("\x1b" "8");
+		}break;
+	}
+}
+
+/**
+	Changes the attributes of all cells in the rectangle and keeps their characters
+*/
+inline void recolour_rectangle(std::size_t x, std::size_t y, std::size_t width, std::size_t height, ConsoleTextAttr attributes,
+								ConsoleState& console = console_state()){
+	if(width == 0 || height == 0) return;
+	switch(console.backend()){
+		case Backend::none:
+			break;
+		case Backend::win32:{
+#ifdef _WIN32
+			if(height == 1){
+				const COORD origin{static_cast<SHORT>(x), static_cast<SHORT>(y)};
+				DWORD written;
+				kernel_call(KernelCall::fill_output_attribute, [&]{return FillConsoleOutputAttribute(console.handle(), static_cast<WORD>(attributes.value), static_cast<DWORD>(width), origin, &written);});
+				break;
+			}
+			CHAR_INFO cells[region_chunk_cells];
+			for_each_region_chunk(x, y, width, height, [&](SMALL_RECT region, COORD size){
+				if(!kernel_call(KernelCall::read_console_output, [&]{return ReadConsoleOutputW(console.handle(), cells, size, COORD{0, 0}, &region);})) return;
+				for(std::size_t i = 0, n = static_cast<std::size_t>(size.X) * static_cast<std::size_t>(size.Y); i < n; ++i){
+					cells[i].Attributes = static_cast<WORD>(attributes.value);
+				}
+				// the region has been clipped to the screen buffer by the read
+				count_written_bytes(static_cast<std::size_t>(size.X) * static_cast<std::size_t>(size.Y) * sizeof(CHAR_INFO));
+				kernel_call(KernelCall::write_console_output, [&]{return WriteConsoleOutputW(console.handle(), cells, size, COORD{0, 0}, &region);});
+			});
+#endif
+		}break;
+		case Backend::vt:{
+			// DECSACE selects the rectangular extent, DECCARA takes the SGR parameters without the introducer and the final 'm',
+			// the second DECSACE restores the default extent afterwards
+			const vt::Sgr sgr = vt::sgr(attributes);
+			VtSequenceBuffer out(console);
+			out.append("\x1b[2*x" "\x1b[");
+			out.append(y + 1);
+			out.append(";");
+			out.append(x + 1);
+			out.append(";");
+			out.append(y + height);
+			out.append(";");
+			out.append(x + width);
+			out.append(";");
+			out.append(sgr.view().substr(2, sgr.size - 3));
+			out.append("$r" "\x1b[*x");
+		}break;
+	}
+}
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_REGION_H
@@ -0,0 +1,231 @@
+/*
+	Description
+	-----------
+
+	Rendering coloured output into a buffer of the caller instead of the console,
+	for example on a worker thread, to send it to several places with one 'send' or 'WriteFile' each.
+	Rendering never calls the console.
+
+	```C++
+	char buffer[4096];
+	cc::BufferWriter out(buffer, sizeof(buffer), cc::RenderFormat::vt);
+	out << Text::red << "error: " << Preset::Default << "in " << Dye::yellow(file) << '\n';
+
+	send(socket, out.data(), out.size(), 0);
+	```
+
+	The formats are:
+		- 'RenderFormat::vt': the text with virtual terminal escape sequences. The output starts with the complete attributes,
+		  so it does not depend on the state of the terminal it is written to.
+		- 'RenderFormat::runs': a compact binary format of attribute runs, that can be replayed into any stream or sink,
+		  for example the local console with 'replay_runs()'. Every run is a header of 4 bytes,
+		  the 16 bit attributes and the 16 bit size of the text in little endian,
+		  followed by the UTF-8 text. Longer texts are split into several runs.
+		- 'RenderFormat::text': only the text.
+
+	If the buffer is too small the output is cut at the last complete piece and 'overflowed()' returns true,
+	'required()' returns the size the buffer would need, for the binary runs it may be a few bytes more.
+	No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_RENDER_H
+#define OMEGA_COLOR_CONSOLE_RENDER_H
+
+#include "colour_console.h"
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/** RenderFormat
+	How a 'BufferWriter' encodes the attributes
+*/
+enum class RenderFormat{
+	vt,		///< virtual terminal escape sequences
+	runs,	///< binary attribute runs
+	text	///< no attributes
+};
+
+/// the size of the header of a binary attribute run
+inline constexpr std::size_t run_header_size = 4;
+
+/// the maximal size of the text of a binary attribute run
+inline constexpr std::size_t max_run_size = 0xFFFF;
+
+/**BufferWriter
+	A sink that renders text and attributes into a buffer of the caller
+*/
+class BufferWriter : public AttrSink<BufferWriter>{
+public:
+	BufferWriter(char* data, std::size_t capacity, RenderFormat format = RenderFormat::vt, ConsoleTextAttr attributes = Preset::Default)
+		: data_(data)
+		, capacity_(capacity)
+		, format_(format)
+		, attributes_(attributes){}
+
+	BufferWriter(const BufferWriter&) = delete;
+	BufferWriter& operator = (const BufferWriter&) = delete;
+
+	/**
+		Returns the attributes that will be applied to the next text that is written
+	*/
+	ConsoleTextAttr attributes() const {return this->attributes_;}
+
+	void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+	void write(std::string_view text){
+		if(text.empty()) return;
+		switch(this->format_){
+			case RenderFormat::text:
+				this->append(text);
+				break;
+			case RenderFormat::vt:
+				if(!this->started_ || this->written_.value != this->attributes_.value){
+					const vt::Sgr sgr = this->started_
+						? vt::sgr(this->attributes_, vt::difference_mask(this->written_, this->attributes_))
+						: vt::sgr(this->attributes_);
+					this->append(sgr.view());
+					this->written_ = this->attributes_;
+					this->started_ = true;
+				}
+				this->append(text);
+				break;
+			case RenderFormat::runs:
+				this->write_runs(text);
+				break;
+		}
+	}
+
+	const char* data() const {return this->data_;}
+
+	/**
+		Returns how many bytes have been rendered into the buffer
+	*/
+	std::size_t size() const {return this->size_;}
+
+	std::string_view view() const {return std::string_view(this->data_, this->size_);}
+
+	/**
+		Returns how many bytes would have been rendered into a buffer that is large enough
+	*/
+	std::size_t required() const {return this->required_;}
+
+	/**
+		Returns true if some output did not fit into the buffer
+	*/
+	bool overflowed() const {return this->full_;}
+
+	/**
+		Empties the buffer, the next output starts with the complete attributes again
+	*/
+	void clear(){
+		this->size_ = 0;
+		this->required_ = 0;
+		this->run_ = nullptr;
+		this->started_ = false;
+		this->full_ = false;
+	}
+
+private:
+	void append(std::string_view bytes){
+		this->required_ += bytes.size();
+		// once something did not fit, nothing more is written, so the output is never missing a piece in the middle
+		if(this->full_ || this->size_ + bytes.size() > this->capacity_){
+			this->full_ = true;
+			return;
+		}
+		std::memcpy(this->data_ + this->size_, bytes.data(), bytes.size());
+		this->size_ += bytes.size();
+	}
+
+	void write_runs(std::string_view text){
+		while(!text.empty()){
+			if(this->full_){
+				// only count what would be needed, with a header for every part of the text
+				this->required_ += text.size() + run_header_size * ((text.size() + max_run_size - 1) / max_run_size);
+				return;
+			}
+			// a run is extended as long as the attributes stay the same and its size fits into the header
+			std::size_t run_size = (this->run_ != nullptr) ? load_u16(this->run_ + 2) : 0;
+			if(this->run_ == nullptr || load_u16(this->run_) != (this->attributes_.value & 0xFFFF) || run_size == max_run_size){
+				// a new header is only written together with its text, so the buffer never ends in an empty run
+				const std::size_t size = std::min(text.size(), max_run_size);
+				if(this->size_ + run_header_size + size > this->capacity_){
+					this->full_ = true;
+					continue;
+				}
+				char header[run_header_size];
+				store_u16(header, this->attributes_.value);
+				store_u16(header + 2, 0);
+				this->run_ = this->data_ + this->size_;
+				this->append(std::string_view(header, run_header_size));
+				run_size = 0;
+			}
+
+			const std::size_t size = std::min(text.size(), max_run_size - run_size);
+			this->append(text.substr(0, size));
+			if(!this->full_) store_u16(this->run_ + 2, static_cast<unsigned int>(run_size + size));
+			text.remove_prefix(size);
+		}
+	}
+
+	static void store_u16(char* out, unsigned int value){
+		out[0] = static_cast<char>(value & 0xFF);
+		out[1] = static_cast<char>((value >> 8) & 0xFF);
+	}
+
+	static unsigned int load_u16(const char* in){
+		return static_cast<unsigned int>(static_cast<unsigned char>(in[0])) | (static_cast<unsigned int>(static_cast<unsigned char>(in[1])) << 8);
+	}
+
+	char* data_;
+	std::size_t capacity_;
+	RenderFormat format_;
+	ConsoleTextAttr attributes_;
+	ConsoleTextAttr written_;
+	bool started_ = false;
+	bool full_ = false;
+	std::size_t size_ = 0;
+	std::size_t required_ = 0;
+	char* run_ = nullptr;	///< the header of the last binary run
+};
+
+/**
+	Renders the runs into the buffer and returns how many bytes have been rendered.
+	If 'required' is given it receives the size the buffer would need.
+*/
+inline std::size_t render_runs(const AttrRun* runs, std::size_t count, char* data, std::size_t capacity, RenderFormat format = RenderFormat::vt, std::size_t* required = nullptr){
+	BufferWriter out(data, capacity, format);
+	for(std::size_t i = 0; i < count; ++i) out << runs[i].attributes << runs[i].text;
+	if(required != nullptr) *required = out.required();
+	return out.size();
+}
+
+/**
+	Calls the function with every run of a buffer in the binary run format, as an 'AttrRun'.
+	Returns false if the buffer ends in the middle of a run.
+*/
+template<class Function>
+inline bool for_each_run(std::string_view data, Function&& function){
+	while(!data.empty()){
+		if(data.size() < run_header_size) return false;
+		const auto byte = [&](std::size_t i){return static_cast<unsigned int>(static_cast<unsigned char>(data[i]));};
+		const ConsoleTextAttr attributes{byte(0) | (byte(1) << 8)};
+		const std::size_t size = byte(2) | (byte(3) << 8);
+		if(data.size() < run_header_size + size) return false;
+		function(AttrRun{attributes, data.substr(run_header_size, size)});
+		data.remove_prefix(run_header_size + size);
+	}
+	return true;
+}
+
+/**
+	Writes a buffer in the binary run format into a stream or sink, for example 'std::cout' or a 'ConsoleWriter'.
+	Returns false if the buffer ends in the middle of a run, all complete runs before are written.
+*/
+template<class Out>
+inline bool replay_runs(std::string_view data, Out& out){
+	return for_each_run(data, [&](AttrRun run){out << run.attributes << run.text;});
+}
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_RENDER_H
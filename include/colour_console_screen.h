@@ -0,0 +1,517 @@
+/*
+	Description
+	-----------
+
+	A double buffered screen renderer for live dashboards and status screens.
+
+	The 'BasicScreen' keeps a back buffer of cells, each a UTF-16 character and an attribute word
+	with the same bits as 'ConsoleTextAttr::value'. The cells have the same layout as the windows 'CHAR_INFO'.
+	Drawing only changes the back buffer in memory and never calls the console.
+	'present()' then brings the frame to the console at a constant cost,
+	only the cells that have changed since the last frame are written:
+
+		- With the win32 backend the frame is written with one 'WriteConsoleOutputW' per dirty rectangle.
+		  Alternatively the screen can render into two console screen buffers and swap them
+		  with 'SetConsoleActiveScreenBuffer', so the frame never becomes visible half drawn.
+		- With the virtual terminal backend the changed spans are written as cursor moves, text and escape sequences,
+		  with the cursor and the attributes saved and restored around it.
+
+	```C++
+	static cc::BasicScreen<200, 60> screen;
+
+	screen.clear(Preset::Default);
+	screen.cursor(2, 1) << Text::light_green << "jobs: " << Preset::Default << jobs << '\n' << Mark::red("failed: ") << failed;
+	screen.present();
+	```
+
+	The screen does not use dynamic memory, so it is quite large and should have static storage duration.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_SCREEN_H
+#define OMEGA_COLOR_CONSOLE_SCREEN_H
+
+#include "colour_console.h"
+#ifdef _WIN32
+	#include "colour_console_win32.h"
+#endif
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+#endif
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**ScreenCell
+	A single character cell of the screen, it has the same layout as the windows 'CHAR_INFO'
+*/
+struct ScreenCell{
+	char16_t character = u' ';
+	std::uint16_t attributes = 0;
+};
+
+inline constexpr bool operator == (ScreenCell lhs, ScreenCell rhs){
+	return lhs.character == rhs.character && lhs.attributes == rhs.attributes;
+}
+
+inline constexpr bool operator != (ScreenCell lhs, ScreenCell rhs){
+	return !(lhs == rhs);
+}
+
+#ifdef _WIN32
+	static_assert(sizeof(ScreenCell) == sizeof(CHAR_INFO), "the screen cells have to have the same layout as CHAR_INFO");
+#endif
+
+/** screen_diff
+	Comparison of rows of cells to find the parts of a frame that have changed.
+	Each cell is a packed 32-bit value, so the rows are compared from both ends 8 (AVX2) or 4 (SSE2) cells at a time,
+	or 2 cells at a time as 64-bit words if neither is available.
+*/
+namespace screen_diff{
+
+	/// compares whole blocks of cells from the front, returns the index of the first block that differs or 'count'
+	inline std::size_t first_different_block(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count, std::size_t& block){
+		std::size_t i = 0;
+#if defined(__AVX2__)
+		block = 8;
+		for(; i + 8 <= count; i += 8){
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+			if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) != -1) return i;
+		}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		block = 4;
+		for(; i + 4 <= count; i += 4){
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xFFFF) return i;
+		}
+#else
+		block = 2;
+		for(; i + 2 <= count; i += 2){
+			std::uint64_t a, b;
+			std::memcpy(&a, lhs + i, sizeof(a));
+			std::memcpy(&b, rhs + i, sizeof(b));
+			if(a != b) return i;
+		}
+#endif
+		block = count - i;
+		return i;
+	}
+
+	/**
+		Returns the index of the first cell that differs, or 'count' if all cells are equal
+	*/
+	inline std::size_t first_difference(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count){
+		std::size_t block;
+		std::size_t i = first_different_block(lhs, rhs, count, block);
+		for(const std::size_t end = std::min(count, i + block); i < end; ++i){
+			if(lhs[i] != rhs[i]) return i;
+		}
+		return count;
+	}
+
+	/// compares whole blocks of cells from the back, returns the index after the last block that differs or 0
+	inline std::size_t last_different_block(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count, std::size_t& block){
+		std::size_t end = count;
+#if defined(__AVX2__)
+		block = 8;
+		for(; end >= 8; end -= 8){
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + end - 8));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + end - 8));
+			if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) != -1) return end;
+		}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		block = 4;
+		for(; end >= 4; end -= 4){
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + end - 4));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + end - 4));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) != 0xFFFF) return end;
+		}
+#else
+		block = 2;
+		for(; end >= 2; end -= 2){
+			std::uint64_t a, b;
+			std::memcpy(&a, lhs + end - 2, sizeof(a));
+			std::memcpy(&b, rhs + end - 2, sizeof(b));
+			if(a != b) return end;
+		}
+#endif
+		block = end;
+		return end;
+	}
+
+	/**
+		Returns the index after the last cell that differs, or 0 if all cells are equal
+	*/
+	inline std::size_t last_difference(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count){
+		std::size_t block;
+		std::size_t end = last_different_block(lhs, rhs, count, block);
+		for(const std::size_t begin = end - std::min(end, block); end > begin; --end){
+			if(lhs[end-1] != rhs[end-1]) return end;
+		}
+		return 0;
+	}
+
+}//namespace screen_diff
+
+/** PresentMode
+	How the win32 backend brings a frame to the console
+*/
+enum class PresentMode{
+	region,			///< the frame is written into the region of the active console screen buffer
+	swap_buffers	///< the frame is written into a hidden console screen buffer which is then made active
+};
+
+/**BasicScreen
+	A back buffer of 'Width' x 'Height' cells that is presented at the position 'left', 'top' of the console.
+	See the description at the top of this file.
+*/
+template<std::size_t Width, std::size_t Height>
+class BasicScreen{
+	static_assert(Width > 0 && Height > 0, "the screen has to have at least one cell");
+	static_assert(Width <= 0x7FFF && Height <= 0x7FFF, "the screen has to fit into the console coordinates");
+
+public:
+	static constexpr std::size_t width = Width;
+	static constexpr std::size_t height = Height;
+
+	/**Cursor
+		A sink that prints text into the back buffer, starting at a cell.
+		Text is clipped at the right edge of the screen, '\n' moves to the start column of the next row.
+	*/
+	class Cursor : public AttrSink<Cursor>{
+	public:
+		Cursor(BasicScreen& screen, std::size_t x, std::size_t y, ConsoleTextAttr attributes)
+			: screen_(screen)
+			, start_x_(x)
+			, x_(x)
+			, y_(y)
+			, attributes_(attributes){}
+
+		ConsoleTextAttr attributes() const {return this->attributes_;}
+
+		void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+		void write(std::string_view text){
+			while(!text.empty()){
+				const char32_t code_point = utf8::next(text);
+				if(code_point == U'\n'){
+					this->x_ = this->start_x_;
+					++this->y_;
+				}else{
+					this->screen_.put(this->x_++, this->y_, code_point, this->attributes_);
+				}
+			}
+		}
+
+		std::size_t x() const {return this->x_;}
+		std::size_t y() const {return this->y_;}
+
+	private:
+		BasicScreen& screen_;
+		std::size_t start_x_;
+		std::size_t x_;
+		std::size_t y_;
+		ConsoleTextAttr attributes_;
+	};
+
+	explicit BasicScreen(short left = 0, short top = 0, PresentMode mode = PresentMode::region, ConsoleState& console = console_state())
+		: console_(console)
+		, left_(left)
+		, top_(top)
+		, mode_(mode){
+		this->clear(console.attributes());
+	}
+
+	BasicScreen(const BasicScreen&) = delete;
+	BasicScreen& operator = (const BasicScreen&) = delete;
+
+	~BasicScreen(){
+#ifdef _WIN32
+		if(this->buffers_[0] != nullptr){
+			kernel_call(KernelCall::set_active_screen_buffer, [&]{return SetConsoleActiveScreenBuffer(this->console_.handle());});
+			CloseHandle(this->buffers_[0]);
+			CloseHandle(this->buffers_[1]);
+		}
+#endif
+	}
+
+	/**
+		Fills the whole back buffer with spaces in the given attributes
+	*/
+	void clear(ConsoleTextAttr attributes){
+		const ScreenCell blank{u' ', static_cast<std::uint16_t>(attributes.value)};
+		std::fill(this->cells_, this->cells_ + Width * Height, blank);
+	}
+
+	/**
+		Sets a single cell, cells outside of the screen are ignored.
+		Code points outside of the basic multilingual plane are replaced, because a cell holds one UTF-16 character.
+	*/
+	void put(std::size_t x, std::size_t y, char32_t code_point, ConsoleTextAttr attributes){
+		if(x >= Width || y >= Height) return;
+		const char16_t character = (code_point < 0x10000 && (code_point < 0xD800 || code_point > 0xDFFF)) ? static_cast<char16_t>(code_point) : static_cast<char16_t>(utf8::replacement);
+		this->cells_[y * Width + x] = ScreenCell{character, static_cast<std::uint16_t>(attributes.value)};
+	}
+
+	/**
+		Applies the change to the attributes of a cell and keeps its character,
+		for example to change the background of a cell without rewriting its text
+	*/
+	void change(std::size_t x, std::size_t y, ConsoleTextAttrChange change){
+		if(x >= Width || y >= Height) return;
+		ScreenCell& cell = this->cells_[y * Width + x];
+		cell.attributes = static_cast<std::uint16_t>(apply_change(ConsoleTextAttr{cell.attributes}, change).value);
+	}
+
+	/**
+		Returns a sink that prints into the back buffer starting at the cell 'x', 'y'
+	*/
+	Cursor cursor(std::size_t x, std::size_t y, ConsoleTextAttr attributes = Preset::Default){
+		return Cursor(*this, x, y, attributes);
+	}
+
+	ScreenCell& cell(std::size_t x, std::size_t y){return this->cells_[y * Width + x];}
+	const ScreenCell& cell(std::size_t x, std::size_t y) const {return this->cells_[y * Width + x];}
+
+	/**
+		Returns the 'Width' cells of the row 'y', for example to fill them with 'quantise::colour_row()'
+	*/
+	ScreenCell* row(std::size_t y){return this->cells_ + y * Width;}
+
+	/**
+		Returns all cells row by row
+	*/
+	const ScreenCell* cells() const {return this->cells_;}
+
+	/**
+		Brings the back buffer to the console.
+		Only the cells that have changed since the last present are written:
+		With the win32 backend each block of consecutive changed rows is written as one dirty rectangle
+		with 'WriteConsoleOutputW', with the virtual terminal backend the changed spans of each row are written
+		as a cursor move followed by the text and its escape sequences.
+		The first frame, every frame after 'invalidate()' and all frames in the 'swap_buffers' mode are written completely.
+		If the standard output is redirected and the attributes are dropped, nothing is written.
+		Returns the number of cells that have been written.
+	*/
+	std::size_t present(){
+		const bool full = !this->front_valid_ || this->mode_ == PresentMode::swap_buffers;
+		std::size_t written = 0;
+		
+		// redirected output that drops the attributes has no screen to draw on
+		if(this->console_.backend() == Backend::none){
+			this->update_front();
+			return 0;
+		}
+		
+#ifdef _WIN32
+		if(this->console_.backend() == Backend::win32){
+			if(full){
+				HANDLE target = this->console_.handle();
+				if(this->mode_ == PresentMode::swap_buffers){
+					if(!this->create_buffers()) return 0;
+					target = this->buffers_[this->back_];
+				}
+				this->write_rectangle(target, 0, 0, Width, Height);
+				written = Width * Height;
+				
+				if(this->mode_ == PresentMode::swap_buffers){
+					kernel_call(KernelCall::set_active_screen_buffer, [&]{return SetConsoleActiveScreenBuffer(target);});
+					this->back_ ^= 1;
+				}
+			}else{
+				written = this->present_dirty_rectangles();
+			}
+			this->update_front();
+			return written;
+		}
+#endif
+		written = this->present_vt(full);
+		this->update_front();
+		return written;
+	}
+	
+	/**
+		Forces the next 'present()' to write the whole frame, 
+		for example after other output has overwritten the region of the screen
+	*/
+	void invalidate(){this->front_valid_ = false;}
+
+private:
+	void update_front(){
+		std::memcpy(this->front_, this->cells_, sizeof(this->cells_));
+		this->front_valid_ = true;
+	}
+	
+	/// finds the first and the last changed cell of the row, returns false if the row has not changed
+	bool dirty_span(std::size_t y, std::size_t& first, std::size_t& last) const {
+		const ScreenCell* back = this->cells_ + y * Width;
+		const ScreenCell* front = this->front_ + y * Width;
+		first = screen_diff::first_difference(back, front, Width);
+		if(first == Width) return false;
+		last = first + screen_diff::last_difference(back + first, front + first, Width - first);
+		return true;
+	}
+	
+#ifdef _WIN32
+	/// writes the bounding rectangle of each block of consecutive changed rows 
+	std::size_t present_dirty_rectangles(){
+		std::size_t written = 0;
+		std::size_t top = 0, left = 0, right = 0;
+		bool open = false;
+		for(std::size_t y = 0; y <= Height; ++y){
+			std::size_t first, last;
+			const bool dirty = (y < Height) && this->dirty_span(y, first, last);
+			if(dirty){
+				if(!open){
+					open = true;
+					top = y;
+					left = first;
+					right = last;
+				}else{
+					left = std::min(left, first);
+					right = std::max(right, last);
+				}
+			}else if(open){
+				this->write_rectangle(this->console_.handle(), left, top, right, y);
+				written += (right - left) * (y - top);
+				open = false;
+			}
+		}
+		return written;
+	}
+	
+	/// writes the cells from 'left', 'top' (including) to 'right', 'bottom' (excluding) 
+	void write_rectangle(HANDLE target, std::size_t left, std::size_t top, std::size_t right, std::size_t bottom){
+		const COORD size{static_cast<SHORT>(Width), static_cast<SHORT>(Height)};
+		const COORD origin{static_cast<SHORT>(left), static_cast<SHORT>(top)};
+		SMALL_RECT region{
+			static_cast<SHORT>(this->left_ + left), static_cast<SHORT>(this->top_ + top), 
+			static_cast<SHORT>(this->left_ + right - 1), static_cast<SHORT>(this->top_ + bottom - 1)};
+		count_written_bytes((right - left) * (bottom - top) * sizeof(CHAR_INFO));
+		kernel_call(KernelCall::write_console_output, [&]{return WriteConsoleOutputW(target, reinterpret_cast<const CHAR_INFO*>(this->cells_), size, origin, &region);});
+	}
+#endif
+
+	/**
+		Writes the changed spans of all rows as text and escape sequences, 
+		the cursor and the attributes are saved and restored around the frame.
+		Clean gaps within a row are skipped with a cursor move if that is shorter than rewriting them.
+	*/
+	std::size_t present_vt(bool full){
+		constexpr std::size_t skip_gap = 8;
+		
+		std::size_t written = 0;
+		bool reset = true;
+		for(std::size_t y = 0; y < Height; ++y){
+			std::size_t first = 0, last = Width;
+			if(!full && !this->dirty_span(y, first, last)) continue;
+			
+			if(written == 0) this->append("\x1b" "7");
+			const ScreenCell* back = this->cells_ + y * Width;
+			const ScreenCell* front = this->front_ + y * Width;
+			std::size_t begin = first;
+			while(begin < last){
+				// extend the span until a gap of clean cells that is long enough to be skipped
+				std::size_t end = begin + 1;
+				std::size_t clean = 0;
+				for(std::size_t x = end; x < last && clean < skip_gap; ++x){
+					if(full || back[x] != front[x]){
+						end = x + 1;
+						clean = 0;
+					}else{
+						++clean;
+					}
+				}
+				
+				this->append_cursor_position(begin, y);
+				this->append_cells(back + begin, end - begin, reset);
+				reset = false;
+				written += end - begin;
+				
+				begin = end;
+				while(begin < last && !full && back[begin] == front[begin]) ++begin;
+			}
+		}
+		if(written != 0){
+			this->append("\x1b" "8");
+			this->flush_vt();
+		}
+		return written;
+	}
+
+	/// appends the escape sequence that moves the cursor to the cell 'x', 'y' of the screen
+	void append_cursor_position(std::size_t x, std::size_t y){
+		char buffer[32];
+		char* out = buffer;
+		*out++ = '\x1b'; *out++ = '[';
+		out = std::to_chars(out, buffer + 12, static_cast<unsigned int>(this->top_ + y + 1)).ptr;
+		*out++ = ';';
+		out = std::to_chars(out, buffer + 24, static_cast<unsigned int>(this->left_ + x + 1)).ptr;
+		*out++ = 'H';
+		this->append(std::string_view(buffer, static_cast<std::size_t>(out - buffer)));
+	}
+
+	/// appends the characters of consecutive cells together with the escape sequences of their attributes
+	void append_cells(const ScreenCell* cells, std::size_t count, bool reset){
+		for(std::size_t i = 0; i < count; ++i){
+			const ConsoleTextAttr attributes{cells[i].attributes};
+			if(reset || attributes.value != this->vt_attributes_.value){
+				this->append((reset ? vt::sgr(attributes) : vt::sgr(attributes, vt::difference_mask(this->vt_attributes_, attributes))).view());
+				this->vt_attributes_ = attributes;
+				reset = false;
+			}
+			char buffer[4];
+			this->append(std::string_view(buffer, utf8::encode(cells[i].character, buffer)));
+		}
+	}
+
+	void append(std::string_view bytes){
+		if(this->vt_size_ + bytes.size() > sizeof(this->vt_)) this->flush_vt();
+		std::memcpy(this->vt_ + this->vt_size_, bytes.data(), bytes.size());
+		this->vt_size_ += bytes.size();
+	}
+
+	void flush_vt(){
+		this->console_.write_text(std::string_view(this->vt_, this->vt_size_));
+		this->vt_size_ = 0;
+	}
+
+#ifdef _WIN32
+	bool create_buffers(){
+		if(this->buffers_[0] != nullptr) return true;
+		HANDLE front = kernel_call(KernelCall::create_screen_buffer, []{return CreateConsoleScreenBuffer(GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CONSOLE_TEXTMODE_BUFFER, nullptr);});
+		if(front == INVALID_HANDLE_VALUE) return false;
+		HANDLE back = kernel_call(KernelCall::create_screen_buffer, []{return CreateConsoleScreenBuffer(GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CONSOLE_TEXTMODE_BUFFER, nullptr);});
+		if(back == INVALID_HANDLE_VALUE){
+			CloseHandle(front);
+			return false;
+		}
+		this->buffers_[0] = front;
+		this->buffers_[1] = back;
+		return true;
+	}
+
+	HANDLE buffers_[2] = {nullptr, nullptr};
+	unsigned int back_ = 0;
+#endif
+
+	ConsoleState& console_;
+	short left_;
+	short top_;
+	PresentMode mode_;
+	ConsoleTextAttr vt_attributes_;
+	bool front_valid_ = false;
+	std::size_t vt_size_ = 0;
+	char vt_[8192];
+	ScreenCell cells_[Width * Height];
+	ScreenCell front_[Width * Height];
+};
+
+using Screen = BasicScreen<80, 25>;
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_SCREEN_H
@@ -0,0 +1,274 @@
+/*
+	Description
+	-----------
+
+	A scrollback of coloured lines with a bounded size, that can show any range of its lines on a 'BasicScreen'
+	without printing them through a stream again.
+
+	```C++
+	static cc::Scrollback scrollback;
+	static cc::BasicScreen<120, 40> screen;
+
+	scrollback << Text::red << "error: " << Preset::Default << "in " << Dye::yellow(file) << '\n';
+
+	scrollback.present(screen, scrollback.end() - 40);		// the last 40 lines
+	```
+
+	The text and the attributes are stored in an arena of 'ChunkCount' chunks of 'ChunkSize' bytes.
+	Every chunk holds the lines from its front, each a table of runs with their 'ConsoleTextAttr' and size
+	followed by the text, and a slot for every line from its back, so looking up a line is a binary search
+	over the chunks and one index into their slots. Appending a line copies it once into the newest chunk,
+	if it does not fit the next chunk is taken and when all are in use the oldest chunk is dropped with all its lines.
+
+	The lines are numbered from the first line that has ever been appended, 'first()' is the oldest line that is still kept.
+	'\n' ends a line, '\r' is dropped. Lines that are longer than 'LineText' bytes or have more than 'LineRuns' runs
+	are continued on the next line.
+
+	'render()' writes the lines into the cells of the screen and 'present()' brings them to the console with one
+	present of the screen, so scrolling only writes the cells that have changed.
+	No dynamic memory is used, the scrollback is large and should have static storage duration.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_SCROLLBACK_H
+#define OMEGA_COLOR_CONSOLE_SCROLLBACK_H
+
+#include "colour_console.h"
+#include "colour_console_screen.h"
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**BasicScrollback
+	Keeps the newest coloured lines in 'ChunkCount' chunks of 'ChunkSize' bytes.
+	It is a sink, so anything can be printed into it. Must only be used by one thread at a time.
+*/
+template<std::size_t ChunkSize = 65536, std::size_t ChunkCount = 256, std::size_t LineText = 1024, std::size_t LineRuns = 64>
+class BasicScrollback : public AttrSink<BasicScrollback<ChunkSize, ChunkCount, LineText, LineRuns>>{
+	struct LineRun{
+		std::uint16_t attributes;
+		std::uint16_t size;
+	};
+
+	struct LineSlot{
+		std::uint32_t offset;		///< the offset of the run table of the line in the chunk
+		std::uint16_t run_count;
+		std::uint16_t text_size;
+	};
+
+	static_assert(ChunkCount >= 2, "the scrollback needs at least two chunks to drop the oldest one");
+	static_assert(LineText <= 0xFFFF && LineRuns <= 0xFFFF, "the sizes of a line are stored with 16 bit");
+	static_assert(ChunkSize <= 0xFFFFFFFF, "the offsets in a chunk are stored with 32 bit");
+	static_assert(LineRuns * sizeof(LineRun) + LineText + sizeof(LineSlot) + alignof(LineSlot) <= ChunkSize, "the longest line has to fit into a chunk");
+
+public:
+	static constexpr std::size_t chunk_size = ChunkSize;
+	static constexpr std::size_t chunk_count = ChunkCount;
+
+	/**
+		Attributes of the text that is appended first
+	*/
+	explicit BasicScrollback(ConsoleTextAttr attributes = Preset::Default)
+		: attributes_(attributes){}
+
+	BasicScrollback(const BasicScrollback&) = delete;
+	BasicScrollback& operator = (const BasicScrollback&) = delete;
+
+	ConsoleTextAttr attributes() const {return this->attributes_;}
+
+	void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+	/**
+		Appends text with the current attributes to the current line, '\n' ends the line
+	*/
+	void write(std::string_view text){
+		while(!text.empty()){
+			const std::size_t end = text.find_first_of("\r\n");
+			std::string_view part = text.substr(0, end);
+			while(!part.empty()){
+				const std::size_t appended = this->line_.append(this->attributes_, part);
+				// stray continuation bytes that do not fit into an empty line are dropped
+				part.remove_prefix((appended == 0 && this->line_.empty()) ? 1 : appended);
+				// the line is full, the rest is continued on the next line
+				if(!part.empty()) this->commit();
+			}
+			if(end == std::string_view::npos) return;
+			if(text[end] == '\n') this->commit_line();
+			text.remove_prefix(end + 1);
+		}
+	}
+
+	/**
+		Ends the current line, even if it is empty
+	*/
+	void commit_line(){
+		std::size_t need = this->line_.run_count() * sizeof(LineRun) + this->line_.text_size();
+		if(this->chunks_in_use_ == 0 || !this->fits(this->newest(), need)) this->next_chunk();
+
+		Chunk& chunk = this->newest();
+		char* const out = chunk.data + chunk.front;
+		char* text = out + this->line_.run_count() * sizeof(LineRun);
+		std::size_t run = 0;
+		this->line_.for_each([&](AttrRun attr_run){
+			const LineRun entry{static_cast<std::uint16_t>(attr_run.attributes.value), static_cast<std::uint16_t>(attr_run.text.size())};
+			std::memcpy(out + run++ * sizeof(LineRun), &entry, sizeof(entry));
+			std::memcpy(text, attr_run.text.data(), attr_run.text.size());
+			text += attr_run.text.size();
+		});
+		const LineSlot slot{chunk.front, static_cast<std::uint16_t>(this->line_.run_count()), static_cast<std::uint16_t>(this->line_.text_size())};
+		std::memcpy(chunk.data + ChunkSize - (chunk.line_count + 1) * sizeof(LineSlot), &slot, sizeof(slot));
+
+		// the run tables of the lines stay aligned
+		need = (need + alignof(LineRun) - 1) / alignof(LineRun) * alignof(LineRun);
+		chunk.front += static_cast<std::uint32_t>(need);
+		++chunk.line_count;
+		++this->end_;
+		this->line_.clear();
+	}
+
+	/**
+		Returns the number of the oldest line that is kept
+	*/
+	std::uint64_t first() const {return this->end_ - this->size();}
+
+	/**
+		Returns the number after the newest line
+	*/
+	std::uint64_t end() const {return this->end_;}
+
+	/**
+		Returns the number of lines that are kept
+	*/
+	std::size_t size() const {return static_cast<std::size_t>(this->end_ - ((this->chunks_in_use_ == 0) ? this->end_ : this->chunks_[this->oldest_].first_line));}
+
+	bool empty() const {return this->size() == 0;}
+
+	/**
+		Removes all lines, the numbers of the next lines continue after the removed ones
+	*/
+	void clear(){
+		this->chunks_in_use_ = 0;
+		this->line_.clear();
+	}
+
+	/**
+		Calls the function with every run of the line as an 'AttrRun'.
+		Returns false if the line is not kept.
+	*/
+	template<class Function>
+	bool for_each_run(std::uint64_t number, Function&& function) const {
+		const Chunk* const chunk = this->find(number);
+		if(chunk == nullptr) return false;
+		LineSlot slot;
+		std::memcpy(&slot, chunk->data + ChunkSize - (static_cast<std::size_t>(number - chunk->first_line) + 1) * sizeof(LineSlot), sizeof(slot));
+		const char* runs = chunk->data + slot.offset;
+		const char* text = runs + slot.run_count * sizeof(LineRun);
+		for(std::size_t i = 0; i < slot.run_count; ++i){
+			LineRun run;
+			std::memcpy(&run, runs + i * sizeof(LineRun), sizeof(run));
+			function(AttrRun{ConsoleTextAttr{run.attributes}, std::string_view(text, run.size)});
+			text += run.size;
+		}
+		return true;
+	}
+
+	/**
+		Writes the line into a stream or sink, without the line break. Returns false if the line is not kept.
+	*/
+	template<class Out>
+	bool replay(std::uint64_t number, Out& out) const {
+		return this->for_each_run(number, [&](AttrRun run){out << run.attributes << run.text;});
+	}
+
+	/**
+		Writes the lines starting with the line 'top' into the rows of the screen, the lines are clipped at its right edge.
+		Rows without a line and the cells after the end of a line are filled with spaces in the 'blank' attributes.
+		Numbers before 'first()' start with the oldest line that is kept.
+	*/
+	template<class Screen>
+	void render(Screen& screen, std::uint64_t top, ConsoleTextAttr blank = Preset::Default) const {
+		if(top < this->first()) top = this->first();
+		const ScreenCell space{u' ', static_cast<std::uint16_t>(blank.value)};
+		for(std::size_t y = 0; y < Screen::height; ++y){
+			ScreenCell* const row = screen.row(y);
+			std::fill(row, row + Screen::width, space);
+			auto cursor = screen.cursor(0, y, blank);
+			this->for_each_run(top + y, [&](AttrRun run){
+				if(cursor.x() < Screen::width) cursor << run.attributes << run.text;
+			});
+		}
+	}
+
+	/**
+		Renders the lines starting with the line 'top' into the screen and presents it.
+		Returns the number of cells that have been written.
+	*/
+	template<class Screen>
+	std::size_t present(Screen& screen, std::uint64_t top, ConsoleTextAttr blank = Preset::Default) const {
+		this->render(screen, top, blank);
+		return screen.present();
+	}
+
+private:
+	struct Chunk{
+		std::uint64_t first_line = 0;
+		std::uint32_t line_count = 0;
+		std::uint32_t front = 0;		///< the end of the lines at the front of the chunk
+		alignas(LineSlot) char data[ChunkSize];
+	};
+
+	void commit(){
+		if(!this->line_.empty()) this->commit_line();
+	}
+
+	static bool fits(const Chunk& chunk, std::size_t need){
+		const std::size_t aligned = (need + alignof(LineRun) - 1) / alignof(LineRun) * alignof(LineRun);
+		return chunk.front + aligned + (chunk.line_count + 1) * sizeof(LineSlot) <= ChunkSize;
+	}
+
+	Chunk& newest(){return this->chunks_[(this->oldest_ + this->chunks_in_use_ - 1) % ChunkCount];}
+
+	/// starts a new chunk, the oldest one is dropped if all are in use
+	void next_chunk(){
+		if(this->chunks_in_use_ == ChunkCount){
+			this->oldest_ = (this->oldest_ + 1) % ChunkCount;
+			--this->chunks_in_use_;
+		}
+		if(this->chunks_in_use_ == 0) this->oldest_ = 0;
+		++this->chunks_in_use_;
+		Chunk& chunk = this->newest();
+		chunk.first_line = this->end_;
+		chunk.line_count = 0;
+		chunk.front = 0;
+	}
+
+	/// returns the chunk that holds the line or nullptr if it is not kept
+	const Chunk* find(std::uint64_t number) const {
+		if(number >= this->end_ || number < this->first()) return nullptr;
+		std::size_t first = 0;
+		std::size_t count = this->chunks_in_use_;
+		// the last chunk whose first line is not after the number
+		while(count > 1){
+			const std::size_t half = count / 2;
+			if(this->chunks_[(this->oldest_ + first + half) % ChunkCount].first_line <= number){
+				first += half;
+				count -= half;
+			}else{
+				count = half;
+			}
+		}
+		return &this->chunks_[(this->oldest_ + first) % ChunkCount];
+	}
+
+	ConsoleTextAttr attributes_;
+	BasicAttrRunBuffer<LineText, LineRuns> line_;	///< the line that is being appended
+
+	std::uint64_t end_ = 0;
+	std::size_t oldest_ = 0;
+	std::size_t chunks_in_use_ = 0;
+	Chunk chunks_[ChunkCount];
+};
+
+using Scrollback = BasicScrollback<>;
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_SCROLLBACK_H
@@ -0,0 +1,180 @@
+/*
+	Description
+	-----------
+
+	Stream buffers that carry the attributes in-band with the characters.
+
+	The attributes of the ordinary stream operators bypass the buffer of the stream,
+	so with the win32 backend the stream has to be flushed before every colour change.
+	A 'BasicColourStreambuf' instead records every attribute change at the current position of its buffer
+	and hands text and attributes in order to a sink. The stream operators of this library detect it
+	behind the 'rdbuf()' of any 'std::ostream', so the call sites do not change:
+
+	```C++
+	cc::ColourStreambuf buffer;
+	std::ostream out(&buffer);
+
+	out << "Normal text " << Text::red << "This text is red" << '\n';	// no flush needed
+	```
+
+	It can also replace the buffer of an existing stream:
+
+	```C++
+	cc::ColourStreambuf buffer;
+	std::streambuf* const original = std::cout.rdbuf(&buffer);
+	std::cout << Dye::green("green") << std::endl;
+	std::cout.rdbuf(original);
+	```
+
+	The sink can be:
+		- a 'ConsoleWriter' ('ColourStreambuf') for the console or any other handle with its own 'ConsoleState'
+		- a 'StreambufWriter' ('ColourFilterStreambuf') that wraps another stream buffer, for example of a file,
+		  and writes the attributes as escape sequences into it or drops them
+		- the 'Writer' of a logger, see 'colour_console_logger.h'
+
+	The stream buffers do not use any dynamic memory.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_STREAMBUF_H
+#define OMEGA_COLOR_CONSOLE_STREAMBUF_H
+
+#include "colour_console.h"
+
+//std
+#include <streambuf>
+#include <utility>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**BasicColourStreambuf
+	A stream buffer that forwards text and attribute changes in order to the sink.
+	The characters are collected in a small put area, an attribute change hands the collected characters
+	to the sink before it changes the attributes of the sink. Flushing the stream flushes the sink.
+
+	The sink has to provide:
+		ConsoleTextAttr attributes() const;
+		void set_attributes(ConsoleTextAttr attributes);
+		void write(std::string_view text);
+		void flush();
+
+	The sink is constructed in place from the arguments of the constructor.
+*/
+template<class Sink, std::size_t BufferSize = 256>
+class BasicColourStreambuf : public AttrStreambuf{
+	static_assert(BufferSize >= 1, "the put area needs at least one character");
+
+public:
+	template<class... Args>
+	explicit BasicColourStreambuf(Args&&... args)
+		: sink_(std::forward<Args>(args)...){
+		this->setp(this->buffer_, this->buffer_ + BufferSize);
+		this->attach();
+	}
+
+	BasicColourStreambuf(const BasicColourStreambuf&) = delete;
+	BasicColourStreambuf& operator = (const BasicColourStreambuf&) = delete;
+
+	~BasicColourStreambuf() override {
+		this->detach();
+		this->drain();
+	}
+
+	ConsoleTextAttr attributes() const override {return this->sink_.attributes();}
+
+	void set_attributes(ConsoleTextAttr attributes) override {
+		this->drain();
+		this->sink_.set_attributes(attributes);
+	}
+
+	Sink& sink() {return this->sink_;}
+	const Sink& sink() const {return this->sink_;}
+
+protected:
+	int_type overflow(int_type c) override {
+		this->drain();
+		if(!traits_type::eq_int_type(c, traits_type::eof())){
+			*this->pptr() = traits_type::to_char_type(c);
+			this->pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char* text, std::streamsize count) override {
+		const std::size_t size = static_cast<std::size_t>(count);
+		if(size > static_cast<std::size_t>(this->epptr() - this->pptr())){
+			this->drain();
+			// large texts are handed to the sink directly instead of being copied into the put area first
+			if(size >= BufferSize){
+				this->sink_.write(std::string_view(text, size));
+				return count;
+			}
+		}
+		std::memcpy(this->pptr(), text, size);
+		this->pbump(static_cast<int>(size));
+		return count;
+	}
+
+	int sync() override {
+		this->drain();
+		this->sink_.flush();
+		return 0;
+	}
+
+private:
+	/// hands the characters of the put area to the sink
+	void drain(){
+		const std::size_t size = static_cast<std::size_t>(this->pptr() - this->pbase());
+		if(size != 0) this->sink_.write(std::string_view(this->pbase(), size));
+		this->setp(this->buffer_, this->buffer_ + BufferSize);
+	}
+
+	Sink sink_;
+	char buffer_[BufferSize];
+};
+
+/**StreambufWriter
+	A sink that writes into another stream buffer, for example the one of a 'std::ofstream'.
+	With 'RedirectPolicy::vt' the attributes are written as escape sequences in front of the text they apply to,
+	consecutive changes without text in between collapse into one sequence.
+	With 'RedirectPolicy::strip' only the text is written.
+*/
+class StreambufWriter{
+public:
+	explicit StreambufWriter(std::streambuf& target, RedirectPolicy policy = RedirectPolicy::vt, ConsoleTextAttr attributes = Preset::Default)
+		: target_(target)
+		, policy_(policy)
+		, attributes_(attributes)
+		, written_(attributes){}
+
+	ConsoleTextAttr attributes() const {return this->attributes_;}
+
+	void set_attributes(ConsoleTextAttr attributes){this->attributes_ = attributes;}
+
+	void write(std::string_view text){
+		if(text.empty()) return;
+		if(this->policy_ == RedirectPolicy::vt && this->attributes_.value != this->written_.value){
+			const vt::Sgr sgr = vt::sgr(this->attributes_, vt::difference_mask(this->written_, this->attributes_));
+			this->target_.sputn(sgr.data, static_cast<std::streamsize>(sgr.size));
+			this->written_ = this->attributes_;
+		}
+		this->target_.sputn(text.data(), static_cast<std::streamsize>(text.size()));
+	}
+
+	void flush(){this->target_.pubsync();}
+
+private:
+	std::streambuf& target_;
+	RedirectPolicy policy_;
+	ConsoleTextAttr attributes_;
+	ConsoleTextAttr written_;
+};
+
+/// writes to the console through a 'ConsoleWriter'
+using ColourStreambuf = BasicColourStreambuf<ConsoleWriter>;
+
+/// writes into another stream buffer
+using ColourFilterStreambuf = BasicColourStreambuf<StreambufWriter>;
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_STREAMBUF_H
@@ -0,0 +1,286 @@
+/*
+	Description
+	-----------
+
+	Printing large coloured tables, with the widths of the columns measured in the cells of the console.
+
+	```C++
+	static const cc::TableColumn columns[] = {{cc::Align::left}, {cc::Align::right}, {cc::Align::left, 0, 40}};
+	cc::BasicTable<3> table(columns, " | ");
+
+	const cc::TableCell row[] = {{name, TextSet::light_yellow}, {size}, {status, ok ? TextSet::light_green : TextSet::light_red}};
+	table.measure(row);
+	...
+	cc::ConsoleWriter out;
+	table.print_row(out, row);
+	```
+
+	The width of a text is the number of console cells it takes, 'display::width()' looks up every code point
+	in a table of the ranges of East Asian wide and full width characters, which take two cells, and of combining
+	and other zero width characters. Runs of printable ASCII are measured 8 bytes at a time.
+
+	The table keeps the width of every column, 'measure()' only widens them, so the layout stays the same
+	across updates of the rows and only new or changed rows have to be measured.
+	Every row is composed into one buffer of attribute runs, in which adjacent cells, padding and separators
+	that look the same are merged into one run, and then written to the stream or sink as a whole.
+	With a 'ConsoleWriter' a row costs one attribute change per visible change of the style, and many rows
+	are written with one call. No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_TABLE_H
+#define OMEGA_COLOR_CONSOLE_TABLE_H
+
+#include "colour_console.h"
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/** display
+	The number of console cells that text takes
+*/
+namespace display{
+
+	/**WidthRange
+		A range of code points that do not take one cell
+	*/
+	struct WidthRange{
+		char32_t first;
+		char32_t last;
+		unsigned char width;
+	};
+
+	/// the zero width and the wide ranges, sorted
+	inline constexpr WidthRange width_ranges[] = {
+		{0x0300, 0x036F, 0}, {0x0483, 0x0489, 0}, {0x0591, 0x05BD, 0}, {0x0610, 0x061A, 0}, {0x064B, 0x065F, 0},
+		{0x0E34, 0x0E3A, 0}, {0x0E47, 0x0E4E, 0},
+		{0x1100, 0x115F, 2}, {0x1160, 0x11FF, 0}, {0x1AB0, 0x1AFF, 0}, {0x1DC0, 0x1DFF, 0},
+		{0x200B, 0x200F, 0}, {0x2028, 0x202E, 0}, {0x2060, 0x206F, 0}, {0x20D0, 0x20FF, 0},
+		{0x231A, 0x231B, 2}, {0x2329, 0x232A, 2}, {0x23E9, 0x23EC, 2}, {0x23F0, 0x23F0, 2}, {0x23F3, 0x23F3, 2},
+		{0x25FD, 0x25FE, 2}, {0x2614, 0x2615, 2}, {0x2648, 0x2653, 2}, {0x267F, 0x267F, 2}, {0x2693, 0x2693, 2},
+		{0x26A1, 0x26A1, 2}, {0x26AA, 0x26AB, 2}, {0x26BD, 0x26BE, 2}, {0x26C4, 0x26C5, 2}, {0x26CE, 0x26CE, 2},
+		{0x26D4, 0x26D4, 2}, {0x26EA, 0x26EA, 2}, {0x26F2, 0x26F3, 2}, {0x26F5, 0x26F5, 2}, {0x26FA, 0x26FA, 2},
+		{0x26FD, 0x26FD, 2}, {0x2705, 0x2705, 2}, {0x270A, 0x270B, 2}, {0x2728, 0x2728, 2}, {0x274C, 0x274C, 2},
+		{0x274E, 0x274E, 2}, {0x2753, 0x2755, 2}, {0x2757, 0x2757, 2}, {0x2795, 0x2797, 2}, {0x27B0, 0x27B0, 2},
+		{0x27BF, 0x27BF, 2}, {0x2B1B, 0x2B1C, 2}, {0x2B50, 0x2B50, 2}, {0x2B55, 0x2B55, 2},
+		{0x2E80, 0x303E, 2}, {0x3041, 0x33FF, 2}, {0x3400, 0x4DBF, 2}, {0x4E00, 0x9FFF, 2}, {0xA000, 0xA4CF, 2},
+		{0xA960, 0xA97F, 2}, {0xAC00, 0xD7A3, 2}, {0xF900, 0xFAFF, 2},
+		{0xFE00, 0xFE0F, 0}, {0xFE10, 0xFE19, 2}, {0xFE20, 0xFE2F, 0}, {0xFE30, 0xFE6F, 2}, {0xFEFF, 0xFEFF, 0},
+		{0xFF00, 0xFF60, 2}, {0xFFE0, 0xFFE6, 2},
+		{0x16FE0, 0x16FE4, 2}, {0x17000, 0x18CFF, 2}, {0x1B000, 0x1B2FF, 2},
+		{0x1F004, 0x1F004, 2}, {0x1F0CF, 0x1F0CF, 2}, {0x1F18E, 0x1F18E, 2}, {0x1F191, 0x1F19A, 2}, {0x1F200, 0x1F2FF, 2},
+		{0x1F300, 0x1F64F, 2}, {0x1F680, 0x1F6FF, 2}, {0x1F900, 0x1F9FF, 2}, {0x1FA70, 0x1FAFF, 2},
+		{0x20000, 0x2FFFD, 2}, {0x30000, 0x3FFFD, 2}, {0xE0000, 0xE0FFF, 0}
+	};
+
+	inline constexpr std::size_t width_range_count = sizeof(width_ranges) / sizeof(width_ranges[0]);
+
+	inline constexpr bool width_ranges_sorted(){
+		for(std::size_t i = 0; i < width_range_count; ++i){
+			if(width_ranges[i].first > width_ranges[i].last) return false;
+			if(i > 0 && width_ranges[i - 1].last >= width_ranges[i].first) return false;
+		}
+		return true;
+	}
+
+	static_assert(width_ranges_sorted(), "the width ranges have to be sorted and must not overlap");
+
+	/**
+		Returns the number of cells of the code point: 0 for control and combining characters,
+		2 for East Asian wide and full width characters and 1 for all others
+	*/
+	inline constexpr unsigned int width(char32_t code_point){
+		if(code_point < 0x300) return (code_point < 0x20 || (code_point >= 0x7F && code_point < 0xA0)) ? 0 : 1;
+		std::size_t first = 0;
+		std::size_t count = width_range_count;
+		while(count > 0){
+			const std::size_t half = count / 2;
+			const WidthRange& range = width_ranges[first + half];
+			if(range.last < code_point){
+				first += half + 1;
+				count -= half + 1;
+			}else{
+				count = half;
+			}
+		}
+		return (first < width_range_count && width_ranges[first].first <= code_point) ? width_ranges[first].width : 1;
+	}
+
+	/// returns true if all 8 bytes of the word are printable ASCII, which take one cell each
+	inline constexpr bool is_printable_ascii(std::uint64_t word){
+		constexpr std::uint64_t ones = 0x0101010101010101ull;
+		constexpr std::uint64_t highs = 0x8080808080808080ull;
+		const std::uint64_t below_space = (word - ones * 0x20) & ~word & highs;
+		const std::uint64_t del = word ^ (ones * 0x7F);
+		const std::uint64_t is_del = (del - ones) & ~del & highs;
+		return ((word & highs) | below_space | is_del) == 0;
+	}
+
+	/**
+		Returns the number of cells of the UTF-8 text
+	*/
+	inline std::size_t width(std::string_view text){
+		std::size_t cells = 0;
+		while(!text.empty()){
+			while(text.size() >= 8){
+				std::uint64_t word;
+				std::memcpy(&word, text.data(), sizeof(word));
+				if(!is_printable_ascii(word)) break;
+				cells += 8;
+				text.remove_prefix(8);
+			}
+			if(text.empty()) break;
+			cells += width(utf8::next(text));
+		}
+		return cells;
+	}
+
+	/**
+		Returns the longest beginning of the text that takes at most 'cells' cells, without splitting code points.
+		'width' receives the number of cells of the beginning.
+	*/
+	inline std::string_view clip(std::string_view text, std::size_t cells, std::size_t& width){
+		width = 0;
+		std::string_view rest = text;
+		while(!rest.empty()){
+			std::string_view next = rest;
+			const unsigned int cell_count = display::width(utf8::next(next));
+			if(width + cell_count > cells) break;
+			width += cell_count;
+			rest = next;
+		}
+		return text.substr(0, text.size() - rest.size());
+	}
+
+}//namespace display
+
+/**Align
+	The alignment of the text in the cells of a column
+*/
+enum class Align{left, right, centre};
+
+/**TableColumn
+	The alignment and the limits of the width of a column, a 'max_width' of 0 does not limit the width.
+	Longer texts are clipped.
+*/
+struct TableColumn{
+	Align align = Align::left;
+	std::size_t min_width = 0;
+	std::size_t max_width = 0;
+};
+
+/**TableCell
+	The text and the attributes of a cell, the padding of the cell has the same attributes
+*/
+struct TableCell{
+	std::string_view text;
+	ConsoleTextAttr attributes = Preset::Default;
+};
+
+/**BasicTable
+	The layout of a table with 'Columns' columns. Rows of up to 'RowText' bytes are composed in place,
+	longer rows are cut.
+*/
+template<std::size_t Columns, std::size_t RowText = 1024, std::size_t RowRuns = 2 * Columns + 1>
+class BasicTable{
+	static_assert(Columns >= 1, "the table has to have at least one column");
+
+public:
+	static constexpr std::size_t columns = Columns;
+
+	explicit BasicTable(const TableColumn (&layout)[Columns], std::string_view separator = " ", ConsoleTextAttr separator_attributes = Preset::Default)
+		: separator_(separator)
+		, separator_attributes_(separator_attributes){
+		for(std::size_t i = 0; i < Columns; ++i) this->columns_[i] = layout[i];
+		this->reset();
+	}
+
+	/**
+		Widens the columns to the cells of the row, which has 'Columns' cells
+	*/
+	void measure(const TableCell* row){
+		for(std::size_t i = 0; i < Columns; ++i){
+			std::size_t width = display::width(row[i].text);
+			if(this->columns_[i].max_width != 0) width = std::min(width, this->columns_[i].max_width);
+			this->widths_[i] = std::max(this->widths_[i], width);
+		}
+	}
+
+	/**
+		Widens the columns to the cells of 'count' rows, which follow each other
+	*/
+	void measure(const TableCell* rows, std::size_t count){
+		for(std::size_t i = 0; i < count; ++i) this->measure(rows + i * Columns);
+	}
+
+	/**
+		Forgets the measured widths, the columns get their minimal widths
+	*/
+	void reset(){
+		for(std::size_t i = 0; i < Columns; ++i) this->widths_[i] = this->columns_[i].min_width;
+	}
+
+	/**
+		Returns the number of cells of the column
+	*/
+	std::size_t width(std::size_t column) const {return this->widths_[column];}
+
+	/**
+		Returns the number of cells of a whole row
+	*/
+	std::size_t width() const {
+		std::size_t total = (Columns - 1) * display::width(this->separator_);
+		for(std::size_t i = 0; i < Columns; ++i) total += this->widths_[i];
+		return total;
+	}
+
+	/**
+		Writes the row, which has 'Columns' cells, with a line break into a stream or sink.
+		Cells that are wider than their column are clipped.
+	*/
+	template<class Out>
+	void print_row(Out& out, const TableCell* row) const {
+		BasicAttrRunBuffer<RowText, RowRuns> line;
+		for(std::size_t i = 0; i < Columns; ++i){
+			if(i > 0) line.append(this->separator_attributes_, this->separator_);
+			const std::size_t column_width = this->widths_[i];
+			std::size_t width;
+			const std::string_view text = display::clip(row[i].text, column_width, width);
+			const std::size_t padding = column_width - width;
+			const std::size_t before = (this->columns_[i].align == Align::right) ? padding
+				: (this->columns_[i].align == Align::centre) ? padding / 2 : 0;
+			append_spaces(line, row[i].attributes, before);
+			line.append(row[i].attributes, text);
+			append_spaces(line, row[i].attributes, padding - before);
+		}
+		line.append(this->separator_attributes_, "\n");
+		line.for_each([&](AttrRun run){out << run.attributes << run.text;});
+	}
+
+	/**
+		Measures 'count' rows and writes them into a stream or sink
+	*/
+	template<class Out>
+	void print(Out& out, const TableCell* rows, std::size_t count){
+		this->measure(rows, count);
+		for(std::size_t i = 0; i < count; ++i) this->print_row(out, rows + i * Columns);
+	}
+
+private:
+	template<class Line>
+	static void append_spaces(Line& line, ConsoleTextAttr attributes, std::size_t count){
+		constexpr std::string_view spaces = "                                ";
+		while(count > 0){
+			const std::size_t size = std::min(count, spaces.size());
+			if(line.append(attributes, spaces.substr(0, size)) == 0) return;
+			count -= size;
+		}
+	}
+
+	TableColumn columns_[Columns];
+	std::size_t widths_[Columns];
+	std::string_view separator_;
+	ConsoleTextAttr separator_attributes_;
+};
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_TABLE_H
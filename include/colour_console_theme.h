@@ -0,0 +1,428 @@
+/*
+	Description
+	-----------
+
+	A registry of semantic styles, like 'error', 'warning' or 'path', whose attributes can be changed at runtime
+	without touching the code that prints them.
+
+	The names of the styles are interned once into dense 'StyleId's, printing then only indexes a flat array
+	of the attributes together with their precomputed escape sequences. A style that is printed into a stream
+	is merged with the attribute changes around it like the 'Preset's, a styled payload writes its sequence as it is:
+
+	```C++
+	const cc::StyleId component = cc::theme_registry().intern("component");
+
+	std::cout << cc::style(cc::Style::error) << "error: " << cc::styled(component, "network") << Preset::Default << '\n';
+	```
+
+	A theme can be loaded from a configuration with one style per line, the attributes use the syntax of the tags
+	of 'colour_console_markup.h' and are applied on top of 'Preset::Default':
+
+	```C++
+	cc::theme_registry().load(
+		"error = light_red\n"
+		"warning = light_yellow, u\n"
+		"component = bg:blue, bright_white\n");
+	```
+
+	The registry keeps two themes, a new theme is written into the one that is not in use and then swapped in atomically.
+	Threads that print never wait for a lock, only the thread that publishes a theme waits until
+	no thread copies the inactive one anymore. Snapshots are copies, so holding one never blocks a publisher.
+	Every thread that prints keeps a copy of the current theme, which is only refreshed after a theme has been published,
+	so looking up a style does not write to shared memory.
+	No dynamic memory is used.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_THEME_H
+#define OMEGA_COLOR_CONSOLE_THEME_H
+
+#include "colour_console.h"
+#include "colour_console_markup.h"
+
+//std
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+/**StyleId
+	The dense index of an interned style name
+*/
+struct StyleId{
+	std::uint16_t value = 0;
+};
+
+inline constexpr bool operator == (StyleId lhs, StyleId rhs){return lhs.value == rhs.value;}
+inline constexpr bool operator != (StyleId lhs, StyleId rhs){return lhs.value != rhs.value;}
+
+/**
+	The styles that every registry starts with, in this order
+*/
+namespace Style{
+	inline constexpr StyleId normal{0};
+	inline constexpr StyleId error{1};
+	inline constexpr StyleId warning{2};
+	inline constexpr StyleId info{3};
+	inline constexpr StyleId debug{4};
+	inline constexpr StyleId path{5};
+	inline constexpr StyleId timestamp{6};
+	inline constexpr StyleId link{7};
+	inline constexpr StyleId active_link{8};
+
+	inline constexpr std::string_view builtin_names[] = {"normal", "error", "warning", "info", "debug", "path", "timestamp", "link", "active_link"};
+	inline constexpr std::size_t builtin_count = sizeof(builtin_names) / sizeof(builtin_names[0]);
+}
+
+/**StyleEntry
+	The attributes of a style together with the escape sequence that sets them
+*/
+struct StyleEntry{
+	ConsoleTextAttr attributes;
+	vt::Sgr sgr;
+};
+
+inline constexpr StyleEntry make_style_entry(ConsoleTextAttr attributes){
+	return StyleEntry{attributes, vt::sgr(attributes)};
+}
+
+/**
+	Sets the attributes of the style within the stream,
+	consecutive changes are merged like those of the 'Preset's, see 'StreamAttrChain'
+*/
+template<class OStream, enable_if_stream_t<OStream> = 0>
+StreamAttrChain<OStream> operator << (OStream& stream, const StyleEntry& style){
+	return StreamAttrChain<OStream>(stream, style.attributes);
+}
+
+template<class Sink, std::enable_if_t<is_attribute_sink<Sink>::value, int> = 0>
+Sink& operator << (Sink& sink, const StyleEntry& style){
+	return sink << style.attributes;
+}
+
+/**StyledPrint
+	Prints the payload with a style and restores the previous attributes afterwards, see 'styled()'
+*/
+template<class Payload>
+struct StyledPrint{
+	StyleEntry style;
+	Payload string;
+};
+
+template<class OStream, class Payload, enable_if_stream_t<OStream> = 0>
+OStream& operator << (OStream& stream, const StyledPrint<Payload>& print){
+	if(attr_state(stream) != nullptr) return stream << attr_print(ConsoleTextAttrChange{print.style.attributes.value, Attribute::all}, print.string);
+	ConsoleState& console = console_state();
+	console.push(stream, print.style.attributes, print.style.sgr);
+	stream << print.string;
+	console.pop(stream);
+	return stream;
+}
+
+template<class Sink, class Payload, std::enable_if_t<is_attribute_sink<Sink>::value, int> = 0>
+Sink& operator << (Sink& sink, const StyledPrint<Payload>& print){
+	return sink << attr_print(ConsoleTextAttrChange{print.style.attributes.value, Attribute::all}, print.string);
+}
+
+/**
+	Returns a new generation for a published theme, unique across all registries
+*/
+OMEGA_COLOR_CONSOLE_MODULE_INLINE std::uint64_t next_theme_generation(){
+	static std::atomic<std::uint64_t> generation{0};
+	return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+/**BasicTheme
+	The attributes of 'Capacity' styles, indexed by their 'StyleId'.
+	Styles that have not been set use 'Preset::Default', the builtin styles have their own defaults.
+*/
+template<std::size_t Capacity>
+class BasicTheme{
+	static_assert(Capacity >= Style::builtin_count, "the theme has to hold at least the builtin styles");
+
+public:
+	static constexpr std::size_t capacity = Capacity;
+
+	constexpr BasicTheme(){
+		for(StyleEntry& entry : this->entries_) entry = make_style_entry(Preset::Default);
+		this->set(Style::error, TextSet::light_red);
+		this->set(Style::warning, TextSet::light_yellow);
+		this->set(Style::info, TextSet::light_aqua);
+		this->set(Style::debug, TextSet::grey);
+		this->set(Style::path, TextSet::light_blue);
+		this->set(Style::timestamp, TextSet::grey);
+		this->set(Style::link, Preset::link);
+		this->set(Style::active_link, Preset::active_link);
+	}
+
+	/**
+		Sets the attributes of the style, ids that do not fit are ignored
+	*/
+	constexpr void set(StyleId id, ConsoleTextAttr attributes){
+		if(id.value < Capacity) this->entries_[id.value] = make_style_entry(attributes);
+	}
+
+	/**
+		Returns the style, ids that do not fit return the style 'Style::normal'
+	*/
+	constexpr const StyleEntry& operator[](StyleId id) const {
+		return this->entries_[(id.value < Capacity) ? id.value : Style::normal.value];
+	}
+
+private:
+	StyleEntry entries_[Capacity] = {};
+};
+
+/**BasicThemeRegistry
+	Interns up to 'Capacity' style names of up to 'NameCapacity' bytes and holds the current theme.
+
+	Looking up styles and names never takes a lock.
+	Interning names and publishing or loading themes is serialised by a mutex.
+*/
+template<std::size_t Capacity, std::size_t NameCapacity = 32>
+class BasicThemeRegistry{
+public:
+	using Theme = BasicTheme<Capacity>;
+
+	/**Snapshot
+		A copy of the theme that was current when it was taken, it can be kept as long as needed.
+		Take one snapshot for many lookups, for example for a whole line.
+	*/
+	class Snapshot{
+	public:
+		explicit Snapshot(const BasicThemeRegistry& registry)
+			: theme_(registry.copy_current()){}
+
+		const StyleEntry& operator[](StyleId id) const {return this->theme_[id];}
+		const Theme& theme() const {return this->theme_;}
+
+	private:
+		Theme theme_;
+	};
+
+	BasicThemeRegistry(){
+		for(const std::string_view name : Style::builtin_names) this->append_name(name);
+	}
+
+	BasicThemeRegistry(const BasicThemeRegistry&) = delete;
+	BasicThemeRegistry& operator = (const BasicThemeRegistry&) = delete;
+
+	/**
+		Returns the id of the style name, the name is added if it is not known yet.
+		If the registry is full or the name too long, 'Style::normal' is returned.
+	*/
+	StyleId intern(std::string_view name){
+		const std::lock_guard<std::mutex> lock(this->mutex_);
+		return this->intern_locked(name);
+	}
+
+	/**
+		Looks up the id of a style name without adding it, returns false if the name is unknown
+	*/
+	bool find(std::string_view name, StyleId& id) const {
+		const std::size_t count = this->name_count_.load(std::memory_order_acquire);
+		for(std::size_t i = 0; i < count; ++i){
+			if(std::string_view(this->names_[i], this->name_sizes_[i]) == name){
+				id = StyleId{static_cast<std::uint16_t>(i)};
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+		Returns the name of the style or an empty name for an unknown id
+	*/
+	std::string_view name(StyleId id) const {
+		if(id.value >= this->name_count_.load(std::memory_order_acquire)) return std::string_view();
+		return std::string_view(this->names_[id.value], this->name_sizes_[id.value]);
+	}
+
+	/**
+		Returns the number of interned names
+	*/
+	std::size_t size() const {return this->name_count_.load(std::memory_order_acquire);}
+
+	Snapshot snapshot() const {return Snapshot(*this);}
+
+	/**
+		Returns a copy of the style in the current theme, taken from the copy of the theme of the calling thread
+	*/
+	StyleEntry style(StyleId id) const {
+		return this->thread_theme()[id];
+	}
+
+	/**
+		Returns the attributes of the style in the current theme
+	*/
+	ConsoleTextAttr attributes(StyleId id) const {
+		return this->thread_theme()[id].attributes;
+	}
+
+	/**
+		Returns a copy of the current theme, for example to change some of its styles and publish it again
+	*/
+	Theme current() const {
+		return this->copy_current();
+	}
+
+	/**
+		Makes the theme the current one. Threads that still print with the previous theme are not disturbed.
+	*/
+	void publish(const Theme& theme){
+		const std::lock_guard<std::mutex> lock(this->mutex_);
+		this->publish_locked(theme);
+	}
+
+	/**
+		Loads a theme from a configuration with one 'name = attributes' per line and publishes it.
+		Empty lines and lines that start with '#' are skipped, unknown names are interned.
+		Styles that are not in the configuration get their defaults.
+		If a line cannot be parsed nothing is published and false is returned.
+	*/
+	bool load(std::string_view config){
+		const std::lock_guard<std::mutex> lock(this->mutex_);
+		Theme theme;
+		while(!config.empty()){
+			const std::size_t end = config.find('\n');
+			const std::string_view line = trim(config.substr(0, end));
+			config.remove_prefix((end == std::string_view::npos) ? config.size() : end + 1);
+			if(line.empty() || line.front() == '#') continue;
+
+			const std::size_t equals = line.find('=');
+			if(equals == std::string_view::npos) return false;
+			const std::string_view name = trim(line.substr(0, equals));
+			ConsoleTextAttrChange change;
+			if(name.empty() || !markup::parse_tag(line.substr(equals + 1), change)) return false;
+
+			const StyleId id = this->intern_locked(name);
+			if(id == Style::normal && name != Style::builtin_names[0]) return false;
+			theme.set(id, apply_change(Preset::Default, change));
+		}
+		this->publish_locked(theme);
+		return true;
+	}
+
+private:
+	struct Slot{
+		Theme theme;
+		mutable std::atomic<std::uint32_t> readers{0};
+	};
+
+	/**
+		Copies the current theme. The reader is registered at its slot only during the copy,
+		a publisher waits for the readers of the slot it wants to overwrite, so it never waits longer than one copy.
+		If the slot has been swapped out in between, the registration is undone and repeated with the new slot.
+	*/
+	Theme copy_current() const {
+		while(true){
+			const unsigned int index = this->current_.load();
+			const Slot& slot = this->slots_[index];
+			slot.readers.fetch_add(1);
+			if(this->current_.load() == index){
+				Theme theme = slot.theme;
+				slot.readers.fetch_sub(1);
+				return theme;
+			}
+			slot.readers.fetch_sub(1);
+		}
+	}
+
+	void publish_locked(const Theme& theme){
+		const unsigned int next = 1 - this->current_.load();
+		Slot& slot = this->slots_[next];
+		while(slot.readers.load() != 0) std::this_thread::yield();
+		slot.theme = theme;
+		this->current_.store(next);
+		this->generation_.store(next_theme_generation(), std::memory_order_release);
+	}
+
+	/**
+		Returns the copy of the current theme of the calling thread and refreshes it if a theme has been published since.
+		The generations are unique across registries, so one copy per thread serves all registries of the type.
+		A theme that is published during the refresh is copied with the older generation and copied again on the next call.
+	*/
+	const Theme& thread_theme() const {
+		struct ThreadTheme{
+			std::uint64_t generation = 0;
+			Theme theme;
+		};
+		thread_local ThreadTheme copy;
+		const std::uint64_t generation = this->generation_.load(std::memory_order_acquire);
+		if(copy.generation != generation){
+			copy.theme = this->copy_current();
+			copy.generation = generation;
+		}
+		return copy.theme;
+	}
+
+	StyleId intern_locked(std::string_view name){
+		StyleId id;
+		if(this->find(name, id)) return id;
+		if(name.size() > NameCapacity || this->name_count_.load(std::memory_order_relaxed) == Capacity) return Style::normal;
+		return this->append_name(name);
+	}
+
+	StyleId append_name(std::string_view name){
+		const std::size_t index = this->name_count_.load(std::memory_order_relaxed);
+		std::memcpy(this->names_[index], name.data(), name.size());
+		this->name_sizes_[index] = static_cast<std::uint8_t>(name.size());
+		// the name is complete before it becomes visible to 'find()'
+		this->name_count_.store(index + 1, std::memory_order_release);
+		return StyleId{static_cast<std::uint16_t>(index)};
+	}
+
+	static constexpr std::string_view trim(std::string_view text){
+		while(!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+		while(!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+		return text;
+	}
+
+	static_assert(NameCapacity <= 255, "the size of a name is stored in one byte");
+	static_assert(Capacity <= 65536, "the ids are 16 bit");
+
+	Slot slots_[2];
+	std::atomic<unsigned int> current_{0};
+	std::atomic<std::uint64_t> generation_{next_theme_generation()};
+
+	char names_[Capacity][NameCapacity] = {};
+	std::uint8_t name_sizes_[Capacity] = {};
+	std::atomic<std::size_t> name_count_{0};
+
+	std::mutex mutex_;
+};
+
+using ThemeRegistry = BasicThemeRegistry<64>;
+
+/**
+	The process wide theme registry
+*/
+OMEGA_COLOR_CONSOLE_MODULE_INLINE ThemeRegistry& theme_registry(){
+	static ThemeRegistry registry;
+	return registry;
+}
+
+/**
+	Returns the style in the current theme of the process wide registry,
+	it can be written into any stream or sink like the 'Preset's
+*/
+inline StyleEntry style(StyleId id){
+	return theme_registry().style(id);
+}
+
+/**
+	Prints the payload with the style of the current theme and restores the previous attributes afterwards, like 'Dye'.
+	If the payload is already formatted, then the style is composed with the attributes of the payload.
+*/
+template<class String>
+inline auto styled(StyleId id, const String& string){
+	if constexpr (is_console_text_attr_change_print<String>::value){
+		return attr_print(ConsoleTextAttrChange{theme_registry().attributes(id).value, Attribute::all}, string);
+	}else{
+		return StyledPrint<console_print_payload_t<String>>{style(id), string};
+	}
+}
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_THEME_H
@@ -0,0 +1,83 @@
+/*
+	Description
+	-----------
+	
+	The windows backend of 'colour_console.h'. It defines the calls of 'cc::platform' with the console API of windows.
+	
+	It is included at the end of 'colour_console.h' on windows and by the headers that call the console API themselves,
+	like the screen and the regions, so '<windows.h>' is only pulled in where it is actually needed.
+	With 'OMEGA_COLOR_CONSOLE_COMPILED_BACKEND' the calls are only defined in 'colour_console.cpp'.
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_WIN32_H
+#define OMEGA_COLOR_CONSOLE_WIN32_H
+
+#include <windows.h>
+#include <WinCon.h>
+
+#include <type_traits>
+
+#include "colour_console.h"
+
+OMEGA_COLOR_CONSOLE_EXPORT namespace cc{
+
+static_assert(std::is_same_v<ConsoleHandle, HANDLE>, "the console handle has to be a 'HANDLE'");
+
+namespace Attribute{
+	static_assert(foreground_blue == FOREGROUND_BLUE && foreground_green == FOREGROUND_GREEN && foreground_red == FOREGROUND_RED && foreground_intensity == FOREGROUND_INTENSITY);
+	static_assert(background_blue == BACKGROUND_BLUE && background_green == BACKGROUND_GREEN && background_red == BACKGROUND_RED && background_intensity == BACKGROUND_INTENSITY);
+	static_assert(grid_horizontal == COMMON_LVB_GRID_HORIZONTAL && grid_lvertical == COMMON_LVB_GRID_LVERTICAL && grid_rvertical == COMMON_LVB_GRID_RVERTICAL);
+	static_assert(reverse_video == COMMON_LVB_REVERSE_VIDEO && underscore == COMMON_LVB_UNDERSCORE);
+}//namespace Attribute
+
+#if !defined(OMEGA_COLOR_CONSOLE_COMPILED_BACKEND) || defined(OMEGA_COLOR_CONSOLE_BACKEND_SOURCE)
+
+namespace platform{
+
+OMEGA_COLOR_CONSOLE_BACKEND_API ConsoleHandle standard_output(){
+	return kernel_call(KernelCall::get_std_handle, []{return GetStdHandle(STD_OUTPUT_HANDLE);});
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API bool is_console(ConsoleHandle handle){
+	if(kernel_call(KernelCall::get_file_type, [&]{return GetFileType(handle);}) != FILE_TYPE_CHAR) return false;
+	DWORD mode;
+	return kernel_call(KernelCall::get_console_mode, [&]{return GetConsoleMode(handle, &mode);}) != 0;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API Backend console_backend(ConsoleHandle handle){
+	DWORD mode;
+	if(kernel_call(KernelCall::get_console_mode, [&]{return GetConsoleMode(handle, &mode);})){
+		if(mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) return Backend::vt;
+		if(kernel_call(KernelCall::set_console_mode, [&]{return SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);})) return Backend::vt;
+	}
+	return Backend::win32;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API bool read_attributes(ConsoleHandle handle, ConsoleTextAttr& attributes){
+	CONSOLE_SCREEN_BUFFER_INFO i;
+	if(!kernel_call(KernelCall::get_screen_buffer_info, [&]{return GetConsoleScreenBufferInfo(handle, &i);})) return false;
+	attributes = ConsoleTextAttr{i.wAttributes};
+	return true;
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API void set_attributes(ConsoleHandle handle, ConsoleTextAttr attributes){
+	kernel_call(KernelCall::set_text_attribute, [&]{return SetConsoleTextAttribute(handle, static_cast<WORD>(attributes.value));});
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API void write(ConsoleHandle handle, std::string_view bytes){
+	DWORD written;
+	kernel_call(KernelCall::write_file, [&]{return WriteFile(handle, bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr);});
+}
+
+OMEGA_COLOR_CONSOLE_BACKEND_API bool write_utf16(ConsoleHandle handle, const wchar_t* text, std::size_t size){
+	DWORD written;
+	return kernel_call(KernelCall::write_console, [&]{return WriteConsoleW(handle, text, static_cast<DWORD>(size), &written, nullptr);}) != 0;
+}
+
+}//namespace platform
+
+#endif
+
+}//namespace cc
+
+#endif //OMEGA_COLOR_CONSOLE_WIN32_H
@@ -0,0 +1,16 @@
+/*
+	Uses the library through the module 'cc', 'make module' builds and runs it with GCC.
+
+	The file does not include or import any standard header, GCC 12 miscompiles the declarations
+	that such a header shares with the module, see the module section of the readme.
+*/
+
+import cc;
+
+int main(){
+
+	cc::ConsoleWriter out;
+	out << cc::Text::red << "error: " << cc::Preset::Default << "something went wrong\n";
+	out << "this is " << cc::Dye::light_blue("light blue") << " and this is not\n";
+	out << cc::push(cc::Text::yellow) << "pushed " << cc::Dye::green("green") << " and yellow again" << cc::pop << '\n';
+}
@@ -0,0 +1,126 @@
+/*
+	Replays an archive of coloured console output ('colour_console_archive.h') to the console.
+
+	The archive is memory mapped and the blocks of the range are found with a binary search,
+	the runs are written with the 'ConsoleWriter' without parsing any escape sequences.
+
+		replay <file>							the whole archive
+		replay <file> --from 10 --to 20			the entries from 10 to 20 seconds after the first entry
+		replay <file> --offset 1048576 --length 65536	the entries that start in the range of bytes of the file
+		replay <file> --grep "error"			only the entries whose text contains the pattern
+		replay <file> --info					the number of blocks and entries and the time range
+
+	Options:
+
+		--from <seconds>		start of the time range, relative to the first entry (default 0)
+		--to <seconds>			end of the time range, relative to the first entry (default the end)
+		--offset <bytes>		start of the range of offsets in the file, instead of the time range
+		--length <bytes>		size of the range of offsets (default the end)
+		--grep <text>			only replay the entries that contain the text, the attributes are ignored
+		--times					print the time of every entry in front of it
+		--info					print a summary instead of the entries
+*/
+
+#include "include/colour_console.h"
+#include "include/colour_console_archive.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace cc;
+
+namespace{
+
+std::uint64_t to_nanoseconds(const char* seconds){
+	return static_cast<std::uint64_t>(std::strtod(seconds, nullptr) * 1e9);
+}
+
+/// true if the text of the entry contains the pattern, also across runs
+bool contains(const ArchiveEntry& entry, std::string_view pattern, std::string& text){
+	text.clear();
+	for_each_run(entry.runs, [&](AttrRun run){text.append(run.text);});
+	return text.find(pattern) != std::string::npos;
+}
+
+void print_info(const ArchiveReader& archive){
+	std::size_t entries = 0;
+	std::size_t damaged = 0;
+	for(std::size_t index = 0; index < archive.block_count(); ++index){
+		const ArchiveBlock block = archive.block(index);
+		if(block.valid) entries += block.entry_count;
+		else ++damaged;
+	}
+	const double seconds = static_cast<double>(archive.last_time() - archive.first_time()) * 1e-9;
+	std::cout << "size:         " << archive.size() << " bytes\n"
+	          << "block size:   " << archive.block_size() << " bytes\n"
+	          << "blocks:       " << archive.block_count() << " (" << damaged << " damaged)\n"
+	          << "entries:      " << entries << '\n'
+	          << "duration:     " << seconds << " s\n";
+}
+
+}//namespace
+
+int main(int argc, char** argv){
+	const char* path = nullptr;
+	const char* from = nullptr;
+	const char* to = nullptr;
+	const char* offset = nullptr;
+	const char* length = nullptr;
+	std::string_view pattern;
+	bool times = false;
+	bool info = false;
+	for(int i = 1; i < argc; ++i){
+		const std::string_view argument = argv[i];
+		if(argument == "--from" && i + 1 < argc) from = argv[++i];
+		else if(argument == "--to" && i + 1 < argc) to = argv[++i];
+		else if(argument == "--offset" && i + 1 < argc) offset = argv[++i];
+		else if(argument == "--length" && i + 1 < argc) length = argv[++i];
+		else if(argument == "--grep" && i + 1 < argc) pattern = argv[++i];
+		else if(argument == "--times") times = true;
+		else if(argument == "--info") info = true;
+		else path = argv[i];
+	}
+	if(path == nullptr){
+		std::cerr << "usage: replay <file> [--from <seconds>] [--to <seconds>] [--offset <bytes>] [--length <bytes>] [--grep <text>] [--times] [--info]\n";
+		return 1;
+	}
+
+	const ArchiveReader archive(path);
+	if(!archive.is_open()){
+		std::cerr << "'" << path << "' is not an archive\n";
+		return 1;
+	}
+	if(info){
+		print_info(archive);
+		return 0;
+	}
+
+	const std::uint64_t start = archive.first_time();
+	std::string text;
+	ConsoleWriter out;
+	const auto replay = [&](const ArchiveEntry& entry){
+		if(!pattern.empty() && !contains(entry, pattern, text)) return;
+		if(times){
+			char stamp[32];
+			const int size = std::snprintf(stamp, sizeof(stamp), "[%12.6f] ", static_cast<double>(entry.time - start) * 1e-9);
+			out << TextSet::grey << std::string_view(stamp, static_cast<std::size_t>(size));
+		}
+		replay_entry(entry, out);
+	};
+
+	if(offset != nullptr){
+		const std::size_t begin = static_cast<std::size_t>(std::strtoull(offset, nullptr, 10));
+		const std::size_t end = (length != nullptr) ? begin + static_cast<std::size_t>(std::strtoull(length, nullptr, 10)) : archive.size();
+		archive.for_each_entry_in_offsets(begin, end, replay);
+	}else{
+		const std::uint64_t begin = (from != nullptr) ? start + to_nanoseconds(from) : 0;
+		const std::uint64_t end = (to != nullptr) ? start + to_nanoseconds(to) : ~std::uint64_t(0);
+		archive.for_each_entry_in_time(begin, end, replay);
+	}
+	out << Preset::Default;
+	out.flush();
+	return 0;
+}
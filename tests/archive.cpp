@@ -0,0 +1,67 @@
+/*
+	Tests of the archive format, the archive is written into the current directory and removed again
+*/
+
+#include "include/colour_console_archive.h"
+#include "tests/check.h"
+
+//std
+#include <cstdio>
+#include <string>
+
+using namespace cc;
+
+namespace{
+
+void test_round_trip(){
+	const char* const path = "test_archive.ccar";
+	constexpr std::size_t entries = 300;
+	const ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+	{
+		BasicArchiveWriter<1024> archive(path);
+		CHECK(archive.good());
+		for(std::size_t i = 0; i < entries; ++i){
+			archive.entry(1000 + i) << Text::red << "entry " << Preset::Default << i << '\n';
+		}
+	}
+
+	ArchiveReader archive(path);
+	CHECK(archive.is_open());
+	CHECK(archive.block_size() == 1024);
+	CHECK(archive.block_count() > 1);
+	CHECK(archive.first_time() == 1000);
+	CHECK(archive.last_time() == 1000 + entries - 1);
+
+	// every entry comes back with its time, its text and its attributes
+	std::size_t count = 0;
+	bool intact = true;
+	archive.for_each_entry_in_time(0, ~std::uint64_t(0), [&](const ArchiveEntry& entry){
+		const std::string expected = "entry " + std::to_string(count) + "\n";
+		std::string text;
+		bool coloured = false;
+		intact = for_each_run(entry.runs, [&](AttrRun run){
+			if(text.empty()) coloured = run.attributes.value == red.value && run.text == "entry ";
+			text += run.text;
+		}) && intact;
+		intact = intact && coloured && text == expected && entry.time == 1000 + count;
+		++count;
+	});
+	CHECK(intact);
+	CHECK(count == entries);
+
+	// a time range only returns the entries in it
+	std::size_t in_range = 0;
+	archive.for_each_entry_in_time(1100, 1200, [&](const ArchiveEntry& entry){
+		in_range += (entry.time >= 1100 && entry.time < 1200) ? 1 : 0;
+	});
+	CHECK(in_range == 100);
+
+	std::remove(path);
+}
+
+}//namespace
+
+int main(){
+	test_round_trip();
+	return test::result("archive");
+}
@@ -0,0 +1,131 @@
+/*
+	Tests of the bulk output of attribute runs
+*/
+
+#include "include/colour_console_bulk.h"
+#include "tests/check.h"
+
+//std
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+//posix
+#include <csignal>
+#include <pthread.h>
+#include <sys/time.h>
+
+using namespace cc;
+
+namespace{
+
+void interrupt(int){}
+
+/// the escape sequences and texts that the runs have to produce on a stream that starts with the default attributes
+std::string expected_output(const std::vector<AttrRun>& runs){
+	std::string expected;
+	ConsoleTextAttr current = Preset::Default;
+	for(const AttrRun& run : runs){
+		if(run.attributes.value != current.value) expected += vt::sgr(run.attributes, vt::difference_mask(current, run.attributes)).view();
+		current = run.attributes;
+		expected += run.text;
+	}
+	return expected;
+}
+
+void test_partial_writes(){
+	// text that is much larger than the pipe, with an attribute change between all runs
+	constexpr std::size_t run_count = 200;
+	constexpr std::size_t run_size = 8192;
+	std::string text;
+	std::vector<AttrRun> runs;
+	for(std::size_t i = 0; i < run_count; ++i) text.append(run_size, static_cast<char>('a' + i % 26));
+	for(std::size_t i = 0; i < run_count; ++i){
+		const ConsoleTextAttr attributes = apply_change(Preset::Default, (i % 2 == 0) ? Text::red : Text::green);
+		runs.push_back(AttrRun{attributes, std::string_view(text).substr(i * run_size, run_size)});
+	}
+
+	int pipe_fds[2];
+	CHECK(::pipe(pipe_fds) == 0);
+#ifdef F_SETPIPE_SZ
+	::fcntl(pipe_fds[1], F_SETPIPE_SZ, 4096);
+#endif
+
+	// the reader is slow and does not get the signals, so they interrupt the 'writev' calls after they have written a part
+	sigset_t alarm;
+	sigemptyset(&alarm);
+	sigaddset(&alarm, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &alarm, nullptr);
+	std::string received;
+	std::thread reader([&]{
+		char data[1024];
+		for(;;){
+			const ssize_t size = ::read(pipe_fds[0], data, sizeof(data));
+			if(size <= 0) break;
+			received.append(data, static_cast<std::size_t>(size));
+			std::this_thread::sleep_for(std::chrono::microseconds(20));
+		}
+	});
+	pthread_sigmask(SIG_UNBLOCK, &alarm, nullptr);
+
+	struct sigaction action = {};
+	action.sa_handler = interrupt;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0;
+	sigaction(SIGALRM, &action, nullptr);
+	itimerval timer = {};
+	timer.it_interval.tv_usec = 300;
+	timer.it_value.tv_usec = 300;
+	setitimer(ITIMER_REAL, &timer, nullptr);
+	{
+		ConsoleState console(pipe_fds[1]);
+		console.set_redirect_policy(RedirectPolicy::vt);
+		write_runs(runs.data(), runs.size(), console);
+	}
+	timer = {};
+	setitimer(ITIMER_REAL, &timer, nullptr);
+	::close(pipe_fds[1]);
+	reader.join();
+	::close(pipe_fds[0]);
+
+	// the writes resume after the part that has been written, nothing is lost or repeated
+	CHECK(received.size() == expected_output(runs).size());
+	CHECK(received == expected_output(runs));
+}
+
+void test_merged_runs(){
+	int pipe_fds[2];
+	CHECK(::pipe(pipe_fds) == 0);
+	{
+		// contiguous runs whose attribute change is not visible are written as one run
+		const std::string_view text = "red   green";
+		const AttrRun runs[] = {
+			{apply_change(Preset::Default, Text::red), text.substr(0, 3)},
+			{apply_change(Preset::Default, Text::blue), text.substr(3, 3)},
+			{apply_change(Preset::Default, Text::green), text.substr(6)}
+		};
+		ConsoleState console(pipe_fds[1]);
+		console.set_redirect_policy(RedirectPolicy::vt);
+		write_runs(runs, std::size(runs), console);
+		CHECK(console.attributes().value == runs[2].attributes.value);
+	}
+	::close(pipe_fds[1]);
+	std::string received;
+	char data[256];
+	for(ssize_t size; (size = ::read(pipe_fds[0], data, sizeof(data))) > 0;) received.append(data, static_cast<std::size_t>(size));
+	::close(pipe_fds[0]);
+
+	const ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+	const ConsoleTextAttr green = apply_change(Preset::Default, Text::green);
+	CHECK(received == std::string(vt::sgr(red, vt::difference_mask(Preset::Default, red)).view()) + "red   "
+		+ std::string(vt::sgr(green, vt::difference_mask(red, green)).view()) + "green");
+}
+
+}//namespace
+
+int main(){
+	test_partial_writes();
+	test_merged_runs();
+	return test::result("bulk");
+}
@@ -0,0 +1,37 @@
+/*
+	The checks of the tests. Every file in 'tests' is a program of its own, for the parts of one header,
+	it reports every failed check to the standard error and returns the number of failed checks.
+	
+		CHECK(queue.empty());
+		return test::result("logger");
+*/
+
+#ifndef OMEGA_COLOR_CONSOLE_TESTS_CHECK_H
+#define OMEGA_COLOR_CONSOLE_TESTS_CHECK_H
+
+//std
+#include <cstdio>
+
+namespace test{
+
+inline int failures = 0;
+
+inline void check(bool condition, const char* what, const char* file, int line){
+	if(condition) return;
+	++failures;
+	std::fprintf(stderr, "%s:%d: failed: %s\n", file, line, what);
+}
+
+/**
+	Reports the result of the program and returns the number of failed checks as its exit code
+*/
+inline int result(const char* name){
+	if(failures == 0) std::fprintf(stderr, "%s: all tests passed\n", name);
+	return failures;
+}
+
+}//namespace test
+
+#define CHECK(condition) test::check((condition), #condition, __FILE__, __LINE__)
+
+#endif //OMEGA_COLOR_CONSOLE_TESTS_CHECK_H
@@ -0,0 +1,176 @@
+/*
+	Tests of the console state and the stream operators
+*/
+
+#include "include/colour_console.h"
+#include "tests/check.h"
+
+//std
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+//posix
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace cc;
+
+namespace{
+
+constexpr ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+constexpr ConsoleTextAttr green = apply_change(Preset::Default, Text::green);
+
+// blank text only hides the foreground colour, and only if nothing is drawn in it
+static_assert(renders_alike(red, red, "text"));
+static_assert(renders_alike(red, green, " \t\n"));
+static_assert(!renders_alike(red, green, " x "));
+static_assert(!renders_alike(red, apply_change(red, Background::blue), "  "));
+static_assert(!renders_alike(apply_change(red, Bar::bottom), apply_change(green, Bar::bottom), "  "));
+
+std::size_t escapes(const std::string& text){
+	return static_cast<std::size_t>(std::count(text.begin(), text.end(), '\x1b'));
+}
+
+void test_elision(){
+	// the escape sequences of a redirected state go into the stream
+	const int null_device = ::open("/dev/null", O_WRONLY);
+	ConsoleState console(null_device);
+	console.set_redirect_policy(RedirectPolicy::vt);
+	CHECK(console.backend() == Backend::vt);
+
+	std::ostringstream out;
+	console.change(out, Text::red);
+	CHECK(out.str() == vt::sgr(Text::red).view());
+	CHECK(console.attributes().value == apply_change(Preset::Default, Text::red).value);
+	CHECK(console.elided_changes() == 0);
+
+	// changes and sets that keep the effective attributes write nothing
+	console.change(out, Text::red);
+	console.set(out, apply_change(Preset::Default, Text::red));
+	console.change(out, Background::black);
+	CHECK(escapes(out.str()) == 1);
+	CHECK(console.elided_changes() == 3);
+
+	// after 'invalidate()' equal attributes are written again
+	console.invalidate();
+	console.set(out, apply_change(Preset::Default, Text::red));
+	CHECK(escapes(out.str()) == 2);
+	CHECK(console.is_known());
+	CHECK(console.elided_changes() == 3);
+	::close(null_device);
+}
+
+void test_chain_merge(){
+	set_redirect_policy(RedirectPolicy::vt);
+	std::ostringstream reset;
+	reset << Preset::Default << "";
+
+	// consecutive changes without text in between write one escape sequence
+	std::ostringstream out;
+	out << Text::red << Background::blue << Bar::bottom << "x";
+	CHECK(escapes(out.str()) == 1);
+	const ConsoleTextAttr merged = apply_change(apply_change(apply_change(Preset::Default, Text::red), Background::blue), Bar::bottom);
+	CHECK(console_state().attributes().value == merged.value);
+
+	// changes that cancel each other write nothing and are counted as elided
+	const std::uint64_t elided = elided_text_attribute_changes();
+	out.str("");
+	out << Text::green << Text::red << "y" << Text::red << "z";
+	CHECK(out.str() == "yz");
+	CHECK(elided_text_attribute_changes() == elided + 3);
+
+	// a single change keeps the sequence of the constant, also at the end of an expression
+	out.str("");
+	out << Text::green;
+	CHECK(out.str() == vt::sgr(Text::green).view());
+
+	reset << Preset::Default << "";
+	set_redirect_policy(RedirectPolicy::strip);
+}
+
+/// returns what has been written into the pipe
+std::string read_all(int fd){
+	std::string received;
+	char data[256];
+	for(ssize_t size; (size = ::read(fd, data, sizeof(data))) > 0;) received.append(data, static_cast<std::size_t>(size));
+	return received;
+}
+
+void test_run_buffer(){
+	// text with equal attributes, or that looks the same with them, extends the last run
+	BasicAttrRunBuffer<64, 4> runs;
+	runs.append(red, "a");
+	runs.append(red, "b");
+	runs.append(green, "  ");
+	runs.append(green, "c");
+	runs.append(red, "");
+	CHECK(runs.run_count() == 2);
+	CHECK(runs.text_size() == 5);
+
+	std::string text;
+	runs.for_each([&](AttrRun run){text += std::string(run.text) + '|';});
+	CHECK(text == "ab  |c|");
+}
+
+void test_writer_coalescing(){
+	int pipe_fds[2];
+	CHECK(::pipe(pipe_fds) == 0);
+	ConsoleState console(pipe_fds[1]);
+	console.set_redirect_policy(RedirectPolicy::vt);
+	{
+		// only the first change is visible, the others do not change the effective attributes or only colour blanks
+		ConsoleWriter out(console);
+		out << Text::red << "a" << Text::red << "b" << Background::black << "c" << Text::green << " " << Text::red << "d";
+	}
+	::close(pipe_fds[1]);
+	CHECK(read_all(pipe_fds[0]) == std::string(vt::sgr(red, vt::difference_mask(Preset::Default, red)).view()) + "abc d");
+	CHECK(console.attributes().value == red.value);
+	CHECK(console.elided_changes() == 4);
+	::close(pipe_fds[0]);
+}
+
+void test_stream_states(){
+	std::ostringstream file;
+	std::ostringstream socket;
+	{
+		StreamAttrState file_state(file, RedirectPolicy::vt);
+		StreamAttrState socket_state(socket, RedirectPolicy::strip, red);
+		CHECK(attr_state(file) == &file_state);
+		CHECK(attr_state(socket) == &socket_state);
+
+		// every stream resolves the changes against its own state
+		file << Text::red << "error" << Background::black << " " << Preset::Default << '\n';
+		socket << Text::green << "text";
+		CHECK(file.str() == std::string(vt::sgr(red, vt::difference_mask(Preset::Default, red)).view()) + "error \x1b[37m\n");
+		CHECK(socket.str() == "text");
+		CHECK(file_state.attributes().value == Preset::Default.value);
+		CHECK(socket_state.attributes().value == green.value);
+
+		// the state stays with the stream, 'copyfmt' does not copy it
+		std::ostringstream copy;
+		copy.copyfmt(file);
+		CHECK(attr_state(copy) == nullptr);
+		CHECK(attr_state(file) == &file_state);
+
+		// the most recently created state of a stream is used as long as it exists
+		{
+			StreamAttrState nested(file, RedirectPolicy::strip);
+			CHECK(attr_state(file) == &nested);
+		}
+		CHECK(attr_state(file) == &file_state);
+	}
+	CHECK(attr_state(file) == nullptr);
+	CHECK(attr_state(socket) == nullptr);
+}
+
+}//namespace
+
+int main(){
+	test_elision();
+	test_chain_merge();
+	test_run_buffer();
+	test_writer_coalescing();
+	test_stream_states();
+	return test::result("console");
+}
@@ -0,0 +1,47 @@
+/*
+	Tests of the extended colours and their quantisation, everything is checked by the compiler
+*/
+
+#include "include/colour_console_extended.h"
+#include "tests/check.h"
+
+using namespace cc;
+
+namespace{
+
+constexpr ExtendedTextAttr rgb_foreground(std::uint8_t red, std::uint8_t green, std::uint8_t blue){
+	return make_extended(Colour::make_rgb(red, green, blue), 0);
+}
+
+constexpr ExtendedTextAttr rgb_background(std::uint8_t red, std::uint8_t green, std::uint8_t blue){
+	return make_extended(0, Colour::make_rgb(red, green, blue));
+}
+
+// two colours of the same field, the right one replaces the left one as a whole
+static_assert((rgb_foreground(0x12, 0x34, 0x56) | rgb_foreground(0xAB, 0xCD, 0xEF)).foreground() == Colour::make_rgb(0xAB, 0xCD, 0xEF));
+static_assert((make_extended(Colour::make_palette(200), 0) | rgb_foreground(1, 2, 3)).foreground() == Colour::make_rgb(1, 2, 3));
+static_assert((extend(TextSet::red) | rgb_foreground(1, 2, 3)).foreground() == Colour::make_rgb(1, 2, 3));
+static_assert((rgb_foreground(1, 2, 3) | extend(TextSet::red)).foreground() == Colour::make_legacy(TextSet::red.value));
+
+// an empty field keeps the other one
+static_assert((rgb_foreground(1, 2, 3) | rgb_background(4, 5, 6)).foreground() == Colour::make_rgb(1, 2, 3));
+static_assert((rgb_foreground(1, 2, 3) | rgb_background(4, 5, 6)).background() == Colour::make_rgb(4, 5, 6));
+static_assert((rgb_foreground(1, 2, 3) | BackgroundSet::blue).foreground() == Colour::make_rgb(1, 2, 3));
+
+// the console colours and the flags compose bit by bit, like the console attributes
+static_assert((extend(TextSet::red) | extend(TextSet::blue)).value == extend(TextSet::purple).value);
+static_assert((extend(TextSet::red | BackgroundSet::blue) | ConsoleTextAttr{Attribute::underscore}).value
+	== extend(ConsoleTextAttr{TextSet::red.value | BackgroundSet::blue.value | Attribute::underscore}).value);
+static_assert((rgb_foreground(1, 2, 3) | ConsoleTextAttr{Attribute::underscore}).flags() == Attribute::underscore);
+
+// the quantisation to the console colours
+static_assert(quantise::to_console(Colour::make_rgb(0, 0, 0xC0)) == 9);
+static_assert(quantise::to_console(Colour::make_rgb(0xC0, 0xC0, 0xC0)) == 7);
+static_assert(quantise::to_console(Colour::make_palette(196)) == 12);
+static_assert(to_console(rgb_foreground(0xFF, 0, 0) | rgb_background(0, 0, 0xFF)).value == (TextSet::light_red.value | BackgroundSet::light_blue.value));
+
+}//namespace
+
+int main(){
+	return test::result("extended");
+}
@@ -0,0 +1,176 @@
+/*
+	Tests of the queue and the records of the logger
+*/
+
+#include "include/colour_console_logger.h"
+#include "tests/check.h"
+
+//std
+#include <atomic>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+//posix
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace cc;
+
+namespace{
+
+void test_queue_contention(){
+	constexpr std::size_t producers = 4;
+	constexpr std::uint64_t values = 20000;
+	static BasicMpscQueue<std::uint64_t, 64> queue;
+
+	std::vector<std::thread> threads;
+	for(std::size_t producer = 0; producer < producers; ++producer){
+		threads.emplace_back([producer]{
+			for(std::uint64_t value = 0; value < values; ++value){
+				const std::uint64_t tagged = (std::uint64_t(producer) << 32) | value;
+				while(!queue.try_push([&](std::uint64_t& slot){slot = tagged;})) std::this_thread::yield();
+			}
+		});
+	}
+
+	// the values of every producer arrive complete and in order
+	std::uint64_t next[producers] = {};
+	std::uint64_t popped = 0;
+	bool ordered = true;
+	while(popped < producers * values){
+		const bool got = queue.try_pop([&](std::uint64_t& value){
+			const std::size_t producer = static_cast<std::size_t>(value >> 32);
+			ordered = ordered && producer < producers && (value & 0xFFFFFFFF) == next[producer];
+			if(producer < producers) ++next[producer];
+			++popped;
+		});
+		if(!got) std::this_thread::yield();
+	}
+	for(std::thread& thread : threads) thread.join();
+
+	CHECK(ordered);
+	CHECK(popped == producers * values);
+	CHECK(queue.empty());
+}
+
+void test_queue_drop(){
+	constexpr std::size_t producers = 4;
+	constexpr std::uint64_t values = 20000;
+	static BasicMpscQueue<std::uint64_t, 16> queue;
+
+	std::atomic<std::uint64_t> dropped{0};
+	std::atomic<std::size_t> running{producers};
+	std::vector<std::thread> threads;
+	for(std::size_t producer = 0; producer < producers; ++producer){
+		threads.emplace_back([producer, &dropped, &running]{
+			for(std::uint64_t value = 0; value < values; ++value){
+				const std::uint64_t tagged = (std::uint64_t(producer) << 32) | value;
+				// like 'OverflowPolicy::drop_oldest'
+				while(!queue.try_push([&](std::uint64_t& slot){slot = tagged;})){
+					if(queue.try_drop()) dropped.fetch_add(1);
+				}
+			}
+			running.fetch_sub(1);
+		});
+	}
+
+	// the values of every producer that are not dropped still arrive in order
+	std::uint64_t last[producers] = {};
+	bool seen[producers] = {};
+	std::uint64_t popped = 0;
+	bool ordered = true;
+	const auto pop = [&]{
+		return queue.try_pop([&](std::uint64_t& value){
+			const std::size_t producer = static_cast<std::size_t>(value >> 32);
+			if(producer >= producers){
+				ordered = false;
+				return;
+			}
+			ordered = ordered && (!seen[producer] || (value & 0xFFFFFFFF) > last[producer]);
+			last[producer] = value & 0xFFFFFFFF;
+			seen[producer] = true;
+			++popped;
+		});
+	};
+	while(running.load() != 0) if(!pop()) std::this_thread::yield();
+	while(pop()){}
+	for(std::thread& thread : threads) thread.join();
+
+	CHECK(ordered);
+	CHECK(popped + dropped.load() == producers * values);
+}
+
+/// sets the step and waits for another one while it is printed, so the threads interleave in a fixed order
+struct Step{
+	std::atomic<int>* step;
+	int reached;
+	int next;
+};
+
+std::ostream& operator << (std::ostream& stream, const Step& step){
+	step.step->store(step.reached);
+	while(step.step->load() < step.next) std::this_thread::yield();
+	return stream;
+}
+
+void test_installed_spans(){
+	// the output of the logger goes to the null device
+	const int null_device = ::open("/dev/null", O_WRONLY);
+	ConsoleState console(null_device);
+	std::atomic<int> step{0};
+	std::atomic<bool> kept{true};
+	{
+		Logger logger(LoggerOptions(), console);
+		std::ostream stream(nullptr);
+		logger.install(stream);
+
+		// the first thread ends its span and its push while those of the second thread are still open,
+		// each of them gets its own attributes back
+		std::thread first([&]{
+			stream << Text::red;
+			const ConsoleTextAttr own = attr_state(stream)->attributes();
+			stream << Dye::blue(Step{&step, 1, 2}) << "\n";
+			if(attr_state(stream)->attributes().value != own.value) kept.store(false);
+			stream << push(Text::aqua) << Step{&step, 3, 4} << pop << "\n";
+			if(attr_state(stream)->attributes().value != own.value) kept.store(false);
+			step.store(5);
+		});
+		std::thread second([&]{
+			while(step.load() < 1) std::this_thread::yield();
+			stream << Text::green;
+			const ConsoleTextAttr own = attr_state(stream)->attributes();
+			stream << Dye::purple(Step{&step, 2, 3}) << "\n";
+			if(attr_state(stream)->attributes().value != own.value) kept.store(false);
+			stream << push(Text::yellow) << Step{&step, 4, 5} << pop << "\n";
+			if(attr_state(stream)->attributes().value != own.value) kept.store(false);
+		});
+		first.join();
+		second.join();
+
+		// and at the same time, for the thread sanitizer
+		const auto produce = [&](ConsoleTextAttrChange colour){
+			stream << colour;
+			const ConsoleTextAttr own = attr_state(stream)->attributes();
+			for(int line = 0; line < 2000; ++line){
+				stream << "a " << Dye::blue("span") << ' ' << Mark::yellow("mark") << push(Text::aqua) << " pushed" << pop << '\n';
+				if(attr_state(stream)->attributes().value != own.value) kept.store(false);
+			}
+		};
+		std::thread red(produce, Text::red);
+		std::thread green(produce, Text::green);
+		red.join();
+		green.join();
+	}
+	::close(null_device);
+	CHECK(kept.load());
+}
+
+}//namespace
+
+int main(){
+	test_queue_contention();
+	test_queue_drop();
+	test_installed_spans();
+	return test::result("logger");
+}
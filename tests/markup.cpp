@@ -0,0 +1,74 @@
+/*
+	Tests of the markup templates, the constant templates are checked by the compiler
+*/
+
+#include "include/colour_console_markup.h"
+#include "include/colour_console_render.h"
+#include "tests/check.h"
+
+//std
+#include <string>
+#include <vector>
+
+using namespace cc;
+
+namespace{
+
+static_assert(markup::parse("{red}error{/} in {blue,u}{}{/}\n").valid());
+static_assert(markup::parse("{red}error{/} in {blue,u}{}{/}\n").arguments() == 1);
+static_assert(markup::parse("{red}x{/}{/}").error() == 9);	// a tag is closed that has not been opened
+static_assert(markup::parse("a}b").error() == 1);			// a single '}'
+static_assert(markup::parse("ab{nope}").error() == 2);		// an unknown attribute
+static_assert(markup::parse("ab{red").error() == 2);		// a tag that does not end
+
+void test_errors(){
+	// the runtime templates report the same offsets as the constant ones
+	CHECK(markup::parse<8>(std::string_view("{red}x{/}{/}")).error() == 9);
+	CHECK(markup::parse<8>(std::string_view("a}b")).error() == 1);
+	CHECK(markup::parse<8>(std::string_view("ab{nope}")).error() == 2);
+	CHECK(markup::parse<8>(std::string_view("ab{red")).error() == 2);
+	CHECK(markup::parse<8>(std::string_view("{{}}")).valid());
+
+	// a template with more pieces than fit fails at its end
+	const std::string_view many = "{}{}{}{}";
+	CHECK(markup::parse<2>(many).error() == many.size());
+
+	// tags that are nested too deep fail at the tag that is too deep
+	std::string deep;
+	for(std::size_t i = 0; i <= markup::max_depth; ++i) deep += "{red}";
+	CHECK(markup::parse<4>(std::string_view(deep)).error() == markup::max_depth * 5);
+}
+
+void test_format(){
+	char data[64];
+	BufferWriter text(data, sizeof(data), RenderFormat::text);
+	markup::format(text, markup::parse("{red}error{/} in {blue,u}{}{/}"), "file");
+	CHECK(text.view() == "error in file");
+
+	// the closing tags restore the attributes of the enclosing tag
+	char run_data[128];
+	BufferWriter out(run_data, sizeof(run_data), RenderFormat::runs);
+	markup::format(out, markup::parse("{red}error {u}{}{/}{/} in {}"), "here", 7);
+	std::vector<AttrRun> runs;
+	std::string formatted;
+	CHECK(for_each_run(out.view(), [&](AttrRun run){
+		runs.push_back(run);
+		formatted += run.text;
+	}));
+	CHECK(formatted == "error here in 7");
+	CHECK(runs.size() == 3);
+	if(runs.size() == 3){
+		const ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+		CHECK(runs[0].attributes.value == red.value && runs[0].text == "error ");
+		CHECK(runs[1].attributes.value == (red.value | Attribute::underscore) && runs[1].text == "here");
+		CHECK(runs[2].attributes.value == Preset::Default.value && runs[2].text == " in 7");
+	}
+}
+
+}//namespace
+
+int main(){
+	test_errors();
+	test_format();
+	return test::result("markup");
+}
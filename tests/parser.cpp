@@ -0,0 +1,90 @@
+/*
+	Tests of the parser of VT colour sequences
+*/
+
+#include "include/colour_console_parser.h"
+#include "tests/check.h"
+
+//std
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace cc;
+
+namespace{
+
+constexpr ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+constexpr ConsoleTextAttr green = apply_change(Preset::Default, Text::green);
+
+/// collects the text and merges the runs of equal attributes
+struct Collected{
+	std::string text;
+	std::vector<std::pair<ConsoleTextAttr, std::string>> runs;
+
+	void operator()(AttrRun run){
+		text += run.text;
+		if(!this->runs.empty() && this->runs.back().first.value == run.attributes.value){
+			this->runs.back().second += run.text;
+		}else{
+			this->runs.emplace_back(run.attributes, std::string(run.text));
+		}
+	}
+};
+
+void test_split_sequences(){
+	const std::string_view input = "a\x1b[31mred\x1b[0m b\x1b[38;2;0;0;192mblue\x1b]0;title\x07!";
+
+	Collected whole;
+	{
+		VtParser parser;
+		parser.parse(input, std::ref(whole));
+		CHECK(!parser.in_sequence());
+	}
+	CHECK(whole.text == "ared b" "blue!");
+	CHECK(whole.runs.size() == 4);
+	if(whole.runs.size() == 4){
+		CHECK(whole.runs[1].first.value == red.value && whole.runs[1].second == "red");
+		CHECK(whole.runs[2].first.value == Preset::Default.value && whole.runs[2].second == " b");
+		CHECK(whole.runs[3].first.value == apply_change(Preset::Default, Text::light_blue).value && whole.runs[3].second == "blue!");
+	}
+
+	// the same runs come out wherever the input is split
+	bool same = true;
+	for(std::size_t split = 0; split <= input.size(); ++split){
+		Collected parts;
+		VtParser parser;
+		parser.parse(input.substr(0, split), std::ref(parts));
+		parser.parse(input.substr(split), std::ref(parts));
+		same = same && parts.text == whole.text && parts.runs.size() == whole.runs.size();
+		for(std::size_t i = 0; same && i < parts.runs.size(); ++i){
+			same = parts.runs[i].first.value == whole.runs[i].first.value && parts.runs[i].second == whole.runs[i].second;
+		}
+	}
+	CHECK(same);
+
+	// byte by byte
+	Collected bytes;
+	VtParser parser;
+	for(const char c : input) parser.parse(std::string_view(&c, 1), std::ref(bytes));
+	CHECK(bytes.text == whole.text);
+}
+
+void test_unfinished_sequence(){
+	// an unfinished sequence is kept until the next call
+	VtParser parser;
+	Collected rest;
+	parser.parse("x\x1b[3", std::ref(rest));
+	CHECK(parser.in_sequence());
+	parser.parse("2mgreen", std::ref(rest));
+	CHECK(rest.runs.size() == 2 && rest.runs.back().first.value == green.value && rest.runs.back().second == "green");
+}
+
+}//namespace
+
+int main(){
+	test_split_sequences();
+	test_unfinished_sequence();
+	return test::result("parser");
+}
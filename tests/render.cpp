@@ -0,0 +1,85 @@
+/*
+	Tests of the rendering into buffers
+*/
+
+#include "include/colour_console_render.h"
+#include "tests/check.h"
+
+//std
+#include <string>
+#include <vector>
+
+using namespace cc;
+
+namespace{
+
+constexpr ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+constexpr ConsoleTextAttr green = apply_change(Preset::Default, Text::green);
+
+void test_runs_round_trip(){
+	char data[256];
+	BufferWriter out(data, sizeof(data), RenderFormat::runs);
+	out << Text::red << "error: " << Preset::Default << "in " << Dye::green("file") << '\n';
+	CHECK(!out.overflowed());
+	CHECK(out.required() == out.size());
+
+	std::string text;
+	std::vector<AttrRun> runs;
+	CHECK(for_each_run(out.view(), [&](AttrRun run){
+		runs.push_back(run);
+		text += run.text;
+	}));
+	CHECK(text == "error: in file\n");
+	CHECK(runs.size() == 4);
+	if(runs.size() == 4){
+		CHECK(runs[0].attributes.value == red.value && runs[0].text == "error: ");
+		CHECK(runs[1].attributes.value == Preset::Default.value && runs[1].text == "in ");
+		CHECK(runs[2].attributes.value == green.value && runs[2].text == "file");
+		CHECK(runs[3].attributes.value == Preset::Default.value && runs[3].text == "\n");
+	}
+
+	// a cut buffer returns the complete runs before the cut
+	CHECK(!for_each_run(out.view().substr(0, out.size() - 1), [](AttrRun){}));
+}
+
+void test_text_overflow(){
+	char data[16];
+	BufferWriter out(data, sizeof(data), RenderFormat::text);
+	out << "0123456789" << "0123456789";
+	CHECK(out.overflowed());
+	CHECK(out.view() == "0123456789");
+	CHECK(out.required() == 20);
+}
+
+void test_runs_overflow(){
+	// the header of the second run fits, its text does not
+	char data[run_header_size + 4 + run_header_size + 2];
+	BufferWriter out(data, sizeof(data), RenderFormat::runs);
+	out << Text::red << "abcd" << Text::green << "efgh";
+	CHECK(out.overflowed());
+	CHECK(out.size() == run_header_size + 4);
+	CHECK(out.required() == 2 * (run_header_size + 4));
+
+	std::size_t runs = 0;
+	CHECK(for_each_run(out.view(), [&](AttrRun run){
+		++runs;
+		CHECK(run.attributes.value == red.value && run.text == "abcd");
+	}));
+	CHECK(runs == 1);
+
+	// text of the same attributes still extends the last run as long as it fits
+	char more[run_header_size + 6];
+	BufferWriter extended(more, sizeof(more), RenderFormat::runs);
+	extended << Text::red << "abc" << "def" << "g";
+	CHECK(extended.overflowed());
+	CHECK(extended.size() == sizeof(more));
+}
+
+}//namespace
+
+int main(){
+	test_runs_round_trip();
+	test_text_overflow();
+	test_runs_overflow();
+	return test::result("render");
+}
@@ -0,0 +1,59 @@
+/*
+	Tests of the comparison of the screen rows
+*/
+
+#include "include/colour_console_screen.h"
+#include "tests/check.h"
+
+using namespace cc;
+
+namespace{
+
+constexpr std::size_t max_count = 37;
+
+std::size_t scalar_first_difference(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count){
+	for(std::size_t i = 0; i < count; ++i) if(lhs[i] != rhs[i]) return i;
+	return count;
+}
+
+std::size_t scalar_last_difference(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count){
+	for(std::size_t end = count; end > 0; --end) if(lhs[end-1] != rhs[end-1]) return end;
+	return 0;
+}
+
+bool matches_scalar(const ScreenCell* lhs, const ScreenCell* rhs, std::size_t count){
+	return screen_diff::first_difference(lhs, rhs, count) == scalar_first_difference(lhs, rhs, count)
+		&& screen_diff::last_difference(lhs, rhs, count) == scalar_last_difference(lhs, rhs, count);
+}
+
+void test_equal_rows(){
+	ScreenCell lhs[max_count];
+	ScreenCell rhs[max_count];
+	for(std::size_t count = 0; count <= max_count; ++count){
+		CHECK(screen_diff::first_difference(lhs, rhs, count) == count);
+		CHECK(screen_diff::last_difference(lhs, rhs, count) == 0);
+	}
+}
+
+void test_differences(){
+	// every row length that has a tail after the wide blocks, with the differences in the blocks and in the tail
+	for(std::size_t count = 1; count <= max_count; ++count){
+		for(std::size_t first = 0; first < count; ++first){
+			for(std::size_t last = first; last < count; ++last){
+				ScreenCell lhs[max_count];
+				ScreenCell rhs[max_count];
+				rhs[first].character = u'x';
+				rhs[last].attributes = 1;
+				CHECK(matches_scalar(lhs, rhs, count));
+			}
+		}
+	}
+}
+
+}//namespace
+
+int main(){
+	test_equal_rows();
+	test_differences();
+	return test::result("screen");
+}
@@ -0,0 +1,100 @@
+/*
+	Tests of the scrollback, with chunks small enough that the oldest ones are dropped
+*/
+
+#include "include/colour_console_scrollback.h"
+#include "tests/check.h"
+
+//std
+#include <string>
+
+using namespace cc;
+
+namespace{
+
+using SmallScrollback = BasicScrollback<256, 4, 64, 8>;
+
+constexpr ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+
+/// returns the text of the line, or "-" if it is not kept
+template<class Lines>
+std::string line_text(const Lines& lines, std::uint64_t number){
+	std::string text;
+	if(!lines.for_each_run(number, [&](AttrRun run){text += run.text;})) return "-";
+	return text;
+}
+
+void test_eviction(){
+	static SmallScrollback lines;
+	CHECK(lines.empty());
+	CHECK(line_text(lines, 0) == "-");
+
+	bool bounded = true;
+	bool kept = true;
+	for(std::uint64_t i = 0; i < 1000; ++i){
+		lines << Text::red << "line " << Preset::Default << i << '\n';
+		// the oldest chunk is dropped as a whole, the lines after it are still found
+		bounded = bounded && lines.end() == i + 1 && lines.first() + lines.size() == lines.end();
+		kept = kept && line_text(lines, lines.first()) == "line " + std::to_string(lines.first()) && line_text(lines, i) == "line " + std::to_string(i);
+		if(lines.first() != 0) kept = kept && line_text(lines, lines.first() - 1) == "-";
+	}
+	CHECK(bounded);
+	CHECK(kept);
+	CHECK(lines.first() > 0);
+	CHECK(lines.size() < 4 * 256 / 16);
+	CHECK(line_text(lines, lines.end()) == "-");
+
+	// every kept line is found by the search over the chunks, with its runs
+	bool found = true;
+	for(std::uint64_t number = lines.first(); number < lines.end(); ++number){
+		std::size_t runs = 0;
+		found = lines.for_each_run(number, [&](AttrRun run){
+			found = found && run.attributes.value == ((runs++ == 0) ? red.value : Preset::Default.value);
+		}) && found && runs == 2;
+	}
+	CHECK(found);
+
+	// the numbers continue after a clear
+	const std::uint64_t end = lines.end();
+	lines.clear();
+	CHECK(lines.empty() && lines.end() == end);
+	lines << "after\n";
+	CHECK(lines.first() == end && line_text(lines, end) == "after");
+}
+
+void test_long_lines(){
+	static SmallScrollback lines;
+	// lines longer than the line buffer are continued on the next line, '\r' is dropped
+	lines << std::string(100, 'x') << "\r\n" << "\n";
+	CHECK(lines.size() == 3);
+	CHECK(line_text(lines, 0) == std::string(64, 'x'));
+	CHECK(line_text(lines, 1) == std::string(36, 'x'));
+	CHECK(line_text(lines, 2).empty());
+}
+
+void test_render(){
+	static SmallScrollback lines;
+	static BasicScreen<8, 3> screen;
+	lines << Text::red << "ab" << Preset::Default << "cdefghijk\n" << "z\n";
+
+	// the lines are clipped at the right edge, the rest of the screen is blank
+	lines.render(screen, 0);
+	CHECK(screen.cell(0, 0).character == u'a' && screen.cell(0, 0).attributes == red.value);
+	CHECK(screen.cell(2, 0).character == u'c' && screen.cell(2, 0).attributes == Preset::Default.value);
+	CHECK(screen.cell(7, 0).character == u'h');
+	CHECK(screen.cell(0, 1).character == u'z' && screen.cell(1, 1).character == u' ');
+	CHECK(screen.cell(0, 2).character == u' ' && screen.cell(0, 2).attributes == Preset::Default.value);
+
+	// a later top scrolls
+	lines.render(screen, 1);
+	CHECK(screen.cell(0, 0).character == u'z' && screen.cell(0, 1).character == u' ');
+}
+
+}//namespace
+
+int main(){
+	test_eviction();
+	test_long_lines();
+	test_render();
+	return test::result("scrollback");
+}
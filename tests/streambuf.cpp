@@ -0,0 +1,53 @@
+/*
+	Tests of the stream buffers that carry the attributes in-band
+*/
+
+#include "include/colour_console_streambuf.h"
+#include "tests/check.h"
+
+//std
+#include <ostream>
+#include <sstream>
+
+using namespace cc;
+
+namespace{
+
+void test_in_band_attributes(){
+	std::ostringstream target;
+	{
+		ColourFilterStreambuf buffer(*target.rdbuf(), RedirectPolicy::vt);
+		std::ostream stream(&buffer);
+		CHECK(attr_state(stream) == &buffer);
+
+		stream << Text::red << "error: " << Preset::Default << "in " << Dye::green("file") << '\n';
+		stream << Text::red << Text::green << "merged" << std::flush;
+	}
+	CHECK(target.str() == "\x1b[31merror: \x1b[37min \x1b[32mfile\x1b[37m\n\x1b[32mmerged");
+}
+
+void test_registration(){
+	const std::size_t count = attr_state_registry().count.load();
+	std::ostringstream target;
+	std::ostream stream(nullptr);
+	{
+		ColourFilterStreambuf buffer(*target.rdbuf(), RedirectPolicy::strip);
+		CHECK(attr_state_registry().count.load() == count + 1);
+		CHECK(AttrStreambuf::find(&buffer) == &buffer);
+		stream.rdbuf(&buffer);
+		stream << Text::red << "text" << std::flush;
+		stream.rdbuf(target.rdbuf());
+	}
+	// a destroyed buffer is not found any more, even by a thread that has looked it up before
+	CHECK(attr_state_registry().count.load() == count);
+	CHECK(attr_state(stream) == nullptr);
+	CHECK(target.str() == "text");
+}
+
+}//namespace
+
+int main(){
+	test_in_band_attributes();
+	test_registration();
+	return test::result("streambuf");
+}
@@ -0,0 +1,121 @@
+/*
+	Tests of the display widths and the table layout
+*/
+
+#include "include/colour_console_table.h"
+#include "include/colour_console_render.h"
+#include "tests/check.h"
+
+//std
+#include <string>
+#include <vector>
+
+using namespace cc;
+
+namespace{
+
+static_assert(display::width(U'a') == 1);
+static_assert(display::width(U'\t') == 0);
+static_assert(display::width(U'\u0301') == 0);		// a combining accent
+static_assert(display::width(U'\u65E5') == 2);		// CJK
+static_assert(display::width(U'\uAC00') == 2);		// Hangul
+static_assert(display::width(U'\U0001F600') == 2);	// an emoji
+static_assert(display::width(U'\u00E9') == 1);
+static_assert(display::width(U'\u2603') == 1);		// between the ranges
+
+static_assert(display::is_printable_ascii(0x2020202020202020ull));
+static_assert(!display::is_printable_ascii(0x2020202020201F20ull));
+static_assert(!display::is_printable_ascii(0x202020207F202020ull));
+static_assert(!display::is_printable_ascii(0x20202020C3202020ull));
+
+constexpr ConsoleTextAttr red = apply_change(Preset::Default, Text::red);
+constexpr ConsoleTextAttr green = apply_change(Preset::Default, Text::green);
+
+/// measures code point by code point, without the ASCII fast path
+std::size_t scalar_width(std::string_view text){
+	std::size_t cells = 0;
+	while(!text.empty()) cells += display::width(utf8::next(text));
+	return cells;
+}
+
+void test_width(){
+	CHECK(display::width("") == 0);
+	CHECK(display::width("0123456789abcdef") == 16);
+	CHECK(display::width("\xE6\x97\xA5\xE6\x9C\xAC") == 4);
+	CHECK(display::width("e\xCC\x81") == 1);
+
+	// text around the 8 byte words of the fast path
+	const std::string_view pieces[] = {"\xE6\x97\xA5", "e\xCC\x81", "\t", "\x7F", "\xF0\x9F\x98\x80"};
+	for(const std::string_view piece : pieces){
+		for(std::size_t offset = 0; offset <= 20; ++offset){
+			std::string text(20, 'a');
+			text.insert(offset, piece);
+			CHECK(display::width(text) == scalar_width(text));
+		}
+	}
+}
+
+void test_clip(){
+	std::size_t width;
+	// a wide character that does not fit completely is left out
+	CHECK(display::clip("\xE6\x97\xA5\xE6\x9C\xAC", 3, width) == "\xE6\x97\xA5" && width == 2);
+	CHECK(display::clip("\xE6\x97\xA5\xE6\x9C\xAC", 4, width) == "\xE6\x97\xA5\xE6\x9C\xAC" && width == 4);
+	CHECK(display::clip("abcdef", 4, width) == "abcd" && width == 4);
+	CHECK(display::clip("ab", 4, width) == "ab" && width == 2);
+	// zero width characters stay with the character before them
+	CHECK(display::clip("e\xCC\x81x", 1, width) == "e\xCC\x81" && width == 1);
+}
+
+void test_padding(){
+	static const TableColumn columns[] = {{Align::left}, {Align::right}, {Align::centre, 0, 6}};
+	BasicTable<3> table(columns, "|");
+	const TableCell rows[] = {
+		{"name"}, {"1"}, {"ok"},
+		{"\xE6\x97\xA5\xE6\x9C\xAC"}, {"100"}, {"a much longer status"}
+	};
+	table.measure(rows, 2);
+	CHECK(table.width(0) == 4 && table.width(1) == 3 && table.width(2) == 6);
+	CHECK(table.width() == 4 + 3 + 6 + 2);
+
+	// the cells are padded to their display width and clipped to the limit of the column
+	char data[128];
+	BufferWriter out(data, sizeof(data), RenderFormat::text);
+	table.print_row(out, rows);
+	table.print_row(out, rows + 3);
+	CHECK(out.view() == "name|  1|  ok  \n" "\xE6\x97\xA5\xE6\x9C\xAC|100|a much\n");
+
+	// measuring shorter rows keeps the layout
+	const TableCell short_row[] = {{"a"}, {"b"}, {"c"}};
+	table.measure(short_row);
+	CHECK(table.width() == 4 + 3 + 6 + 2);
+}
+
+void test_merged_styles(){
+	static const TableColumn columns[] = {{Align::left, 3}, {Align::left, 3}, {Align::right, 3}};
+	BasicTable<3> table(columns, " ");
+
+	// adjacent cells, padding and separators that look the same are one run,
+	// blank padding only differs in the foreground colour, so it stays in the run before it
+	const TableCell row[] = {{"a", red}, {"b", red}, {"c", green}};
+	char data[128];
+	BufferWriter out(data, sizeof(data), RenderFormat::runs);
+	table.print_row(out, row);
+
+	std::vector<AttrRun> runs;
+	CHECK(for_each_run(out.view(), [&](AttrRun run){runs.push_back(run);}));
+	CHECK(runs.size() == 2);
+	if(runs.size() == 2){
+		CHECK(runs[0].attributes.value == red.value && runs[0].text == "a   b     ");
+		CHECK(runs[1].attributes.value == green.value && runs[1].text == "c\n");
+	}
+}
+
+}//namespace
+
+int main(){
+	test_width();
+	test_clip();
+	test_padding();
+	test_merged_styles();
+	return test::result("table");
+}
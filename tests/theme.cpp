@@ -0,0 +1,92 @@
+/*
+	Tests of the theme registry
+*/
+
+#include "include/colour_console_theme.h"
+#include "tests/check.h"
+
+//std
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+using namespace cc;
+
+namespace{
+
+void test_lookup(){
+	ThemeRegistry registry;
+	CHECK(registry.size() == Style::builtin_count);
+	CHECK(registry.attributes(Style::error).value == TextSet::light_red.value);
+	CHECK(registry.name(Style::warning) == "warning");
+
+	const StyleId component = registry.intern("component");
+	CHECK(registry.intern("component") == component);
+	CHECK(registry.attributes(component).value == Preset::Default.value);
+
+	StyleId found;
+	CHECK(registry.find("component", found) && found == component);
+	CHECK(!registry.find("unknown", found));
+}
+
+void test_publish(){
+	ThemeRegistry registry;
+	CHECK(registry.load(
+		"# comment\n"
+		"error = light_yellow, u\n"
+		"component = bg:blue, bright_white\n"));
+
+	StyleId component;
+	CHECK(registry.find("component", component));
+	CHECK(registry.attributes(Style::error).value == (TextSet::light_yellow.value | Attribute::underscore | (Preset::Default.value & BackgroundSet::mask)));
+	CHECK(registry.attributes(component).value == (TextSet::bright_white.value | BackgroundSet::blue.value));
+	CHECK(registry.style(component).sgr.view() == vt::sgr(registry.attributes(component)).view());
+
+	// a line that does not parse publishes nothing
+	CHECK(!registry.load("error = nope\n"));
+	CHECK(registry.attributes(component).value == (TextSet::bright_white.value | BackgroundSet::blue.value));
+
+	// styles that are not in the configuration get their defaults
+	CHECK(registry.load("component = red\n"));
+	CHECK(registry.attributes(Style::error).value == TextSet::light_red.value);
+}
+
+void test_snapshot_across_publishes(){
+	ThemeRegistry registry;
+	const ThemeRegistry::Snapshot snapshot = registry.snapshot();
+
+	// a snapshot that is kept across publishes, even by the publishing thread, does not block them
+	ThemeRegistry::Theme theme;
+	theme.set(Style::error, TextSet::green);
+	registry.publish(theme);
+	theme.set(Style::error, TextSet::blue);
+	registry.publish(theme);
+	registry.publish(theme);
+
+	CHECK(snapshot[Style::error].attributes.value == TextSet::light_red.value);
+	CHECK(registry.attributes(Style::error).value == TextSet::blue.value);
+}
+
+void test_stream_merge(){
+	set_redirect_policy(RedirectPolicy::vt);
+	std::ostringstream reset;
+	reset << Preset::Default << "";
+
+	// a style is merged with the changes that follow it into one escape sequence
+	std::ostringstream out;
+	out << style(Style::error) << Bar::bottom << "x";
+	const std::string text = out.str();
+	CHECK(std::count(text.begin(), text.end(), '\x1b') == 1);
+	CHECK(text == std::string(vt::sgr(ConsoleTextAttr{TextSet::light_red.value | Attribute::underscore}, vt::difference_mask(Preset::Default, ConsoleTextAttr{TextSet::light_red.value | Attribute::underscore})).view()) + "x");
+	set_redirect_policy(RedirectPolicy::strip);
+}
+
+}//namespace
+
+int main(){
+	test_lookup();
+	test_publish();
+	test_snapshot_across_publishes();
+	test_stream_merge();
+	return test::result("theme");
+}
@@ -0,0 +1,100 @@
+/*
+	Tests of the UTF-8 conversion against a conversion code point by code point
+*/
+
+#include "include/colour_console_core.h"
+#include "tests/check.h"
+
+//std
+#include <string>
+#include <string_view>
+
+using namespace cc;
+
+namespace{
+
+/// converts without the ASCII fast paths
+std::u16string scalar_to_utf16(std::string_view text){
+	std::u16string out;
+	while(!text.empty()){
+		char32_t code_point = utf8::next(text);
+		if(code_point > 0x10FFFF) code_point = utf8::replacement;
+		if(code_point >= 0x10000){
+			code_point -= 0x10000;
+			out += static_cast<char16_t>(0xD800 + (code_point >> 10));
+			out += static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+		}else{
+			out += static_cast<char16_t>(code_point);
+		}
+	}
+	return out;
+}
+
+std::u16string to_utf16(std::string_view text){
+	char16_t out[256];
+	return std::u16string(out, utf8::to_utf16(text, out));
+}
+
+std::u32string to_utf32_units(std::string_view text){
+	char32_t out[256];
+	return std::u32string(out, utf8::to_utf16(text, out));
+}
+
+bool matches_scalar(std::string_view text){
+	const std::u16string expected = scalar_to_utf16(text);
+	const std::u32string wide = to_utf32_units(text);
+	return to_utf16(text) == expected && std::u16string(wide.begin(), wide.end()) == expected;
+}
+
+void test_ascii(){
+	std::string text;
+	for(std::size_t size = 0; size <= 100; ++size){
+		CHECK(to_utf16(text) == std::u16string(text.begin(), text.end()));
+		text += static_cast<char>(' ' + size % 90);
+	}
+}
+
+void test_sequences_at_every_offset(){
+	// sequences that start, end or are cut at every position of the wide blocks
+	const std::string_view sequences[] = {
+		"\xC3\xA9",				// 2 bytes
+		"\xE2\x82\xAC",			// 3 bytes
+		"\xF0\x9F\x98\x80",		// 4 bytes, a surrogate pair
+		"\xE2\x82",				// truncated
+		"\x80",					// a single continuation byte
+		"\xF8\x88\x80\x80\x80",	// too long
+		"\xF4\x90\x80\x80",		// beyond the last code point
+		"\xC3\xA9\xE2\x82\xAC"	// two in a row
+	};
+	const std::string ascii(70, 'a');
+	for(const std::string_view sequence : sequences){
+		for(std::size_t offset = 0; offset <= ascii.size(); ++offset){
+			std::string text = ascii;
+			text.insert(offset, sequence);
+			CHECK(matches_scalar(text));
+			// and a text that ends in the sequence
+			CHECK(matches_scalar(std::string_view(text).substr(0, offset + sequence.size())));
+		}
+	}
+}
+
+void test_split_text(){
+	// text that is converted in parts split at code point boundaries, like chunks of a console write
+	const std::string text = std::string(40, 'x') + "\xC3\xA9t\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80" + std::string(40, 'y') + "\xE6\x97\xA5\xE6\x9C\xAC";
+	const std::u16string expected = scalar_to_utf16(text);
+	for(std::size_t split = 0; split <= text.size(); ++split){
+		std::size_t boundary = split;
+		while(boundary > 0 && boundary < text.size() && (static_cast<unsigned char>(text[boundary]) & 0xC0) == 0x80) --boundary;
+		const std::string_view all(text);
+		CHECK(to_utf16(all.substr(0, boundary)) + to_utf16(all.substr(boundary)) == expected);
+	}
+}
+
+}//namespace
+
+int main(){
+	test_ascii();
+	test_sequences_at_every_offset();
+	test_split_text();
+	return test::result("utf8");
+}